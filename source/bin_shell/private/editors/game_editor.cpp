@@ -28,6 +28,14 @@ void up::shell::GameEditor::configure() {
     addAction({.command = "Play / Pause", .menu = "Actions\\Play/Pause", .hotKey = "F5", .action = [this] {
                    _wantPlaying = !_wantPlaying;
                }});
+    addAction({.command = "Stop", .menu = "Actions\\Stop", .hotKey = "Shift+F5", .action = [this] {
+                   _stop();
+               }});
+}
+
+void up::shell::GameEditor::_stop() {
+    _wantPlaying = false;
+    _scene->stop();
 }
 
 void up::shell::GameEditor::content() {
@@ -44,6 +52,9 @@ void up::shell::GameEditor::content() {
         if (ImGui::IconMenuItem(text, icon, "F5")) {
             _wantPlaying = !_wantPlaying;
         }
+        if (ImGui::IconMenuItem("Stop", ICON_FA_UNDO, "Shift+F5")) {
+            _stop();
+        }
         ImGui::TextColored(ImGui::GetStyleColorVec4(ImGuiCol_TextDisabled), "Shift-ESC to release input");
         ImGui::EndMenuBar();
     }
@@ -132,7 +143,7 @@ void up::shell::GameEditor::render(Renderer& renderer, float deltaTime) {
         _renderCamera->resetBackBuffer(_buffer);
         _renderCamera->beginFrame(ctx, _camera.position(), _camera.matrix());
         if (_scene != nullptr) {
-            _scene->render(ctx);
+            _scene->render(ctx, _renderCamera->frustum());
         }
         renderer.flushDebugDraw(deltaTime);
         renderer.endFrame(deltaTime);
@@ -33,6 +33,7 @@ namespace up::shell {
 
     private:
         void _resize(GpuDevice& device, glm::ivec2 size);
+        void _stop();
 
         rc<Scene> _scene;
         rc<GpuTexture> _buffer;
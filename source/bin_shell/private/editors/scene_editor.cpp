@@ -10,6 +10,7 @@
 
 #include "potato/audio/audio_engine.h"
 #include "potato/audio/sound_resource.h"
+#include "potato/ecs/hierarchy.h"
 #include "potato/editor/imgui_ext.h"
 #include "potato/reflex/serialize.h"
 #include "potato/render/camera.h"
@@ -30,6 +31,8 @@
 #include <nlohmann/json.hpp>
 #include <imgui.h>
 #include <imgui_internal.h>
+#include <cstring>
+#include <new>
 
 namespace up::shell {
     namespace {
@@ -38,11 +41,13 @@ namespace up::shell {
             SceneEditorFactory(
                 AudioEngine& audioEngine,
                 Universe& universe,
+                Scheduler& scheduler,
                 AssetLoader& assetLoader,
                 SceneEditor::EnumerateComponents components,
                 SceneEditor::HandlePlayClicked onPlayClicked)
                 : _audioEngine(audioEngine)
                 , _universe(universe)
+                , _scheduler(scheduler)
                 , _assetLoader(assetLoader)
                 , _components(std::move(components))
                 , _onPlayClicked(std::move(onPlayClicked)) {}
@@ -52,7 +57,7 @@ namespace up::shell {
             box<Editor> createEditor() override { return nullptr; }
 
             box<Editor> createEditorForDocument(zstring_view filename) override {
-                auto scene = new_shared<Scene>(_universe, _audioEngine);
+                auto scene = new_shared<Scene>(_universe, _audioEngine, _scheduler);
                 auto doc = new_box<SceneDocument>(string(filename), std::move(scene));
 
 #if 0
@@ -88,22 +93,35 @@ namespace up::shell {
         private:
             AudioEngine& _audioEngine;
             Universe& _universe;
+            Scheduler& _scheduler;
             AssetLoader& _assetLoader;
             SceneEditor::EnumerateComponents _components;
             SceneEditor::HandlePlayClicked _onPlayClicked;
         };
+
+        // shared values are interned by their binary encoding, so equal encodings mean equal values
+        bool sameEncoding(reflex::Schema const& schema, void const* first, void const* second) {
+            vector<byte> firstEncoding;
+            vector<byte> secondEncoding;
+            return reflex::encodeToBinaryRaw(firstEncoding, schema, first) &&
+                reflex::encodeToBinaryRaw(secondEncoding, schema, second) &&
+                firstEncoding.size() == secondEncoding.size() &&
+                std::memcmp(firstEncoding.data(), secondEncoding.data(), firstEncoding.size()) == 0;
+        }
     } // namespace
 } // namespace up::shell
 
 auto up::shell::SceneEditor::createFactory(
     AudioEngine& audioEngine,
     Universe& universe,
+    Scheduler& scheduler,
     AssetLoader& assetLoader,
     SceneEditor::EnumerateComponents components,
     SceneEditor::HandlePlayClicked onPlayClicked) -> box<EditorFactory> {
     return new_box<SceneEditorFactory>(
         audioEngine,
         universe,
+        scheduler,
         assetLoader,
         std::move(components),
         std::move(onPlayClicked));
@@ -177,13 +195,16 @@ void up::shell::SceneEditor::content() {
 
         auto const id = ImGui::GetID("SceneControl");
         ImGui::ItemAdd(area, id);
-        ImGui::ButtonBehavior(
+        bool const pressed = ImGui::ButtonBehavior(
             area,
             id,
             nullptr,
             nullptr,
-            (int)ImGuiButtonFlags_PressedOnClick | (int)ImGuiButtonFlags_MouseButtonRight |
-                (int)ImGuiButtonFlags_MouseButtonMiddle);
+            (int)ImGuiButtonFlags_PressedOnClick | (int)ImGuiButtonFlags_MouseButtonLeft |
+                (int)ImGuiButtonFlags_MouseButtonRight | (int)ImGuiButtonFlags_MouseButtonMiddle);
+        if (pressed && ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+            _pick({io.MousePos.x - pos.x, io.MousePos.y - pos.y}, ImGui::IsModifierDown(ImGuiKeyModFlags_Ctrl));
+        }
         if (ImGui::IsItemActive()) {
             ImGui::CaptureMouseFromApp();
 
@@ -231,13 +252,34 @@ void up::shell::SceneEditor::render(Renderer& renderer, float deltaTime) {
         }
         _renderCamera->beginFrame(ctx, _camera.position(), _camera.matrix());
         if (_doc->scene() != nullptr) {
-            _doc->scene()->render(ctx);
+            _doc->scene()->render(ctx, _renderCamera->frustum());
         }
         renderer.flushDebugDraw(deltaTime);
         renderer.endFrame(deltaTime);
     }
 }
 
+void up::shell::SceneEditor::_pick(glm::vec2 position, bool multiselect) {
+    if (_renderCamera == nullptr || _doc->scene() == nullptr) {
+        return;
+    }
+
+    // unproject the cursor onto the near and far planes, which are at a clip depth of 0 and 1
+    glm::vec2 const clip{
+        position.x / static_cast<float>(_sceneDimensions.x) * 2.f - 1.f,
+        1.f - position.y / static_cast<float>(_sceneDimensions.y) * 2.f};
+    glm::mat4x4 const unproject = glm::inverse(_renderCamera->viewProjection());
+    glm::vec4 const nearPoint = unproject * glm::vec4{clip, 0.f, 1.f};
+    glm::vec4 const farPoint = unproject * glm::vec4{clip, 1.f, 1.f};
+    glm::vec3 const origin = glm::vec3{nearPoint} / nearPoint.w;
+    glm::vec3 const target = glm::vec3{farPoint} / farPoint.w;
+
+    EntityId const picked = _doc->scene()->pick({.origin = origin, .direction = glm::normalize(target - origin)});
+    if (picked != EntityId::None) {
+        _selection.click(to_underlying(picked), multiselect);
+    }
+}
+
 void up::shell::SceneEditor::_drawGrid() {
     auto constexpr guidelines = 10;
 
@@ -274,7 +316,14 @@ void up::shell::SceneEditor::_resize(GpuDevice& device, glm::ivec2 size) {
 }
 
 void up::shell::SceneEditor::_inspector() {
+    struct SharedEdit {
+        reflex::TypeInfo const* typeInfo = nullptr;
+        void const* original = nullptr;
+        void* data = nullptr;
+    };
+
     ComponentId deletedComponent = ComponentId::Unknown;
+    vector<SharedEdit> sharedEdits;
 
     if (_doc->scene() == nullptr) {
         return;
@@ -314,6 +363,11 @@ void up::shell::SceneEditor::_inspector() {
     _doc->scene()->world().interrogateEntityUnsafe(
         selectedId,
         [&](EntityId entity, ArchetypeId archetype, reflex::TypeInfo const* typeInfo, auto* data) {
+            // the hierarchy is edited through the scene tree instead
+            if (isHierarchyComponent(*typeInfo)) {
+                return;
+            }
+
             ImGui::PushID(data);
 
             const bool open = _propertyGrid.beginItem(typeInfo->name.c_str());
@@ -333,7 +387,14 @@ void up::shell::SceneEditor::_inspector() {
             }
 
             if (open) {
-                if (typeInfo->schema != nullptr) {
+                // a shared value belongs to many entities, so a copy is edited and given to this entity alone
+                if (_doc->scene()->universe().isSharedComponent(static_cast<ComponentId>(typeInfo->hash))) {
+                    void* const copy = ::operator new(typeInfo->size, std::align_val_t(typeInfo->alignment));
+                    typeInfo->ops.copyConstructor(copy, data);
+                    _propertyGrid.editObjectRaw(*typeInfo->schema, copy);
+                    sharedEdits.push_back({typeInfo, data, copy});
+                }
+                else if (typeInfo->schema != nullptr) {
                     _propertyGrid.editObjectRaw(*typeInfo->schema, data);
                 }
                 _propertyGrid.endItem();
@@ -344,6 +405,16 @@ void up::shell::SceneEditor::_inspector() {
 
     ImGui::EndTable();
 
+    // a new shared value moves the entity to another archetype, so it waits until enumeration is over;
+    // interning a value is costly, so the copy is only applied if it was actually edited
+    for (SharedEdit const& edit : sharedEdits) {
+        if (!sameEncoding(*edit.typeInfo->schema, edit.original, edit.data)) {
+            _doc->scene()->world().addComponentUnsafe(selectedId, *edit.typeInfo, edit.data);
+        }
+        edit.typeInfo->ops.destructor(edit.data);
+        ::operator delete(edit.data, std::align_val_t(edit.typeInfo->alignment));
+    }
+
     if (deletedComponent != ComponentId::Unknown) {
         _doc->scene()->world().removeComponent(selectedId, deletedComponent);
     }
@@ -357,8 +428,8 @@ void up::shell::SceneEditor::_inspector() {
             ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoSavedSettings |
                 ImGuiWindowFlags_NoMove)) {
         for (reflex::TypeInfo const* typeInfo : _components()) {
-            if (_doc->scene()->world().getComponentSlowUnsafe(selectedId, static_cast<ComponentId>(typeInfo->hash)) ==
-                nullptr) {
+            if (!isHierarchyComponent(*typeInfo) &&
+                !_doc->scene()->world().hasComponent(selectedId, static_cast<ComponentId>(typeInfo->hash))) {
                 if (ImGui::IconMenuItem(typeInfo->name.c_str())) {
                     _doc->scene()->world().addComponentDefault(selectedId, *typeInfo);
                 }
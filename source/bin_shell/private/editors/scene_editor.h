@@ -21,6 +21,7 @@
 namespace up {
     class Universe;
     class AssetLoader;
+    class Scheduler;
 } // namespace up
 
 namespace up::shell {
@@ -34,6 +35,7 @@ namespace up::shell {
         static auto createFactory(
             AudioEngine& audioEngine,
             Universe& universe,
+            Scheduler& scheduler,
             AssetLoader& assetLoader,
             SceneEditor::EnumerateComponents components,
             SceneEditor::HandlePlayClicked onPlayClicked) -> box<EditorFactory>;
@@ -66,6 +68,7 @@ namespace up::shell {
     private:
         void _drawGrid();
         void _resize(GpuDevice& device, glm::ivec2 size);
+        void _pick(glm::vec2 position, bool multiselect);
         void _inspector();
         void _hierarchy();
         void _hierarchyShowIndex(int index);
@@ -4,10 +4,14 @@
 #include "components_schema.h"
 
 #include "potato/audio/audio_engine.h"
+#include "potato/ecs/hierarchy.h"
 #include "potato/ecs/query.h"
+#include "potato/ecs/transforms.h"
 #include "potato/ecs/world.h"
+#include "potato/render/bounds.h"
 #include "potato/render/mesh.h"
 #include "potato/runtime/json.h"
+#include "potato/spud/sort.h"
 
 #include <glm/common.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -16,58 +20,229 @@
 #include <glm/vec3.hpp>
 #include <nlohmann/json.hpp>
 
-up::Scene::Scene(Universe& universe, AudioEngine& audioEngine)
+namespace up {
+    // the world transform of the nearest ancestor with a Transform; other ancestors leave their children in place
+    static auto ancestorTransform(World const& world, EntityId ancestor) noexcept -> glm::mat4x4 const* {
+        for (; ancestor != EntityId::None; ancestor = parentOf(world, ancestor)) {
+            if (auto const* const transform = world.readFieldSlow(ancestor, &components::Transform::transform)) {
+                return transform;
+            }
+        }
+        return nullptr;
+    }
+} // namespace up
+
+up::Scene::Scene(Universe& universe, AudioEngine& audioEngine, Scheduler& scheduler)
     : _audioEngine(audioEngine)
     , _universe(universe)
+    , _scheduler(scheduler)
     , _world{universe.createWorld()}
-    , _waveQuery{universe.createQuery<components::Transform, components::Wave>()}
-    , _orbitQuery{universe.createQuery<components::Transform>()}
-    , _spinQuery{universe.createQuery<components::Transform, components::Spin>()}
-    , _dingQuery{universe.createQuery<components::Ding>()}
-    , _transformQuery{universe.createQuery<components::Transform>()}
-    , _renderableMeshQuery{universe.createQuery<components::Mesh, components::Transform>()} {}
+    , _systems{universe.createSystemScheduler(scheduler)}
+    , _transformQuery{universe.createQuery<Fields<components::Transform>, Without<components::Parent>>()}
+    , _childTransformQuery{universe.createQuery<
+          Shared<components::HierarchyDepth>,
+          components::Parent const,
+          Fields<components::Transform>>()}
+    , _renderableMeshQuery{universe.createQuery<Shared<components::Mesh>, Fields<components::Transform const>>()} {
+    _systems->addChunkSystem<Fields<components::Transform>, components::Wave>(
+        "Wave",
+        [this](size_t count, EntityId const*, FieldColumns<components::Transform> trans, components::Wave* wave) {
+            auto const positions = trans(&components::Transform::position);
+            for (size_t index = 0; index != count; ++index) {
+                wave[index].offset += _frameTime * .2f;
+                positions[index].y = 1 + 5 * glm::sin(wave[index].offset * 10);
+            }
+        });
+
+    _systems->addChunkSystem<Fields<components::Transform>>(
+        "Orbit",
+        [this](size_t count, EntityId const*, FieldColumns<components::Transform> trans) {
+            auto const positions = trans(&components::Transform::position);
+            for (size_t index = 0; index != count; ++index) {
+                positions[index] = glm::rotateY(positions[index], _frameTime);
+            }
+        });
+
+    _systems->addChunkSystem<Fields<components::Transform>, components::Spin const>(
+        "Spin",
+        [this](size_t count, EntityId const*, FieldColumns<components::Transform> trans, components::Spin const* spin) {
+            auto const rotations = trans(&components::Transform::rotation);
+            for (size_t index = 0; index != count; ++index) {
+                rotations[index] =
+                    glm::angleAxis(spin[index].radians * _frameTime, glm::vec3(0.f, 1.f, 0.f)) * rotations[index];
+            }
+        });
+
+    // sounds are played from a single System invocation rather than from every Chunk in parallel
+    _systems->addSystem<components::Ding>("Ding", [this](SystemContext& context, Query<components::Ding>& query) {
+        query.select(context.world, [this](EntityId, components::Ding& ding) {
+            ding.time += _frameTime;
+            if (ding.time > ding.period) {
+                ding.time -= ding.period;
+                _audioEngine.play(ding.sound.asset());
+            }
+        });
+    });
+
+    _trackBounds(_world);
+}
 
 up::Scene::~Scene() = default;
 
+bool up::Scene::playing(bool active) {
+    // the play world shares chunks with the edited world until play modifies them
+    if (active && _playWorld == nullptr) {
+        _playWorld = box<World>(new World(_world.clone()));
+        _trackBounds(*_playWorld);
+    }
+    return _playing = active;
+}
+
+void up::Scene::stop() {
+    _playing = false;
+    if (_playWorld != nullptr) {
+        _trackBounds(_world);
+        _playWorld.reset();
+    }
+}
+
 void up::Scene::tick(float frameTime) {
     if (!_playing) {
         return;
     }
 
-    _waveQuery.select(_world, [&](EntityId, components::Transform& trans, components::Wave& wave) {
-        wave.offset += frameTime * .2f;
-        trans.position.y = 1 + 5 * glm::sin(wave.offset * 10);
-    });
+    _frameTime = frameTime;
+    _systems->run(activeWorld());
+}
 
-    _orbitQuery.select(_world, [&](EntityId, components::Transform& trans) {
-        trans.position = glm::rotateY(trans.position, frameTime);
-    });
+void up::Scene::flush() {
+    World& world = activeWorld();
 
-    _spinQuery.select(_world, [&](EntityId, components::Transform& trans, components::Spin const& spin) {
-        trans.rotation = glm::angleAxis(spin.radians * frameTime, glm::vec3(0.f, 1.f, 0.f)) * trans.rotation;
+    // only chunks in which a root's Transform may have been written since the last flush need updating
+    _transformQuery.selectChunksChanged(world, [&](size_t, EntityId const*, FieldColumns<components::Transform> trans) {
+        composeTransforms(
+            trans(&components::Transform::position),
+            trans(&components::Transform::rotation),
+            trans(&components::Transform::transform));
     });
 
-    _dingQuery.select(_world, [&, this](EntityId, components::Ding& ding) {
-        ding.time += frameTime;
-        if (ding.time > ding.period) {
-            ding.time -= ding.period;
-            _audioEngine.play(ding.sound.asset());
+    // a child depends on every ancestor, so children are always updated; one depth at a time,
+    // with every chunk of a depth in parallel, as each depth only reads those above it
+    _childTransformQuery.selectChunksParallelByLevel<components::HierarchyDepth>(
+        world,
+        _scheduler,
+        [](components::HierarchyDepth const& level) { return level.depth; },
+        [&world](
+            size_t count,
+            EntityId const*,
+            components::HierarchyDepth const&,
+            components::Parent const* parents,
+            FieldColumns<components::Transform> trans) {
+            auto const transforms = trans(&components::Transform::transform);
+            composeTransforms(
+                trans(&components::Transform::position),
+                trans(&components::Transform::rotation),
+                transforms);
+            for (size_t index = 0; index != count; ++index) {
+                if (auto const* const parent = ancestorTransform(world, parents[index].entity)) {
+                    transforms[index] = *parent * transforms[index];
+                }
+            }
+        });
+
+    // Entities which lost their Mesh or Transform leave the index before changed chunks are visited
+    world.notifyObservers();
+    _updateBounds(world);
+}
+
+void up::Scene::render(RenderContext& ctx, Frustum const& frustum) {
+    World& world = activeWorld();
+
+    // only the Entities found in the frustum are looked up, so the cost follows what is visible
+    _visible.clear();
+    _spatialIndex.queryFrustum(frustum, _visible);
+
+    // Mesh is shared, so every Entity of an Archetype draws the same Mesh; grouping the visible Entities
+    // by Archetype resolves each Mesh once per group, and draws of the same Mesh are issued together
+    //
+    _visibleEntities.clear();
+    for (uint64 const key : _visible) {
+        auto const entity = static_cast<EntityId>(key);
+        _visibleEntities.push_back({world.archetypeOf(entity), entity});
+    }
+    sort(_visibleEntities, {}, &VisibleEntity::archetype);
+
+    for (size_t first = 0, last = 0; first != _visibleEntities.size(); first = last) {
+        ArchetypeId const archetype = _visibleEntities[first].archetype;
+        for (last = first + 1; last != _visibleEntities.size() && _visibleEntities[last].archetype == archetype;
+             ++last) {
         }
-    });
+
+        auto const* const mesh = world.readComponentSlow<components::Mesh>(_visibleEntities[first].entity);
+        if (mesh == nullptr || !mesh->mesh.ready() || !mesh->material.ready()) {
+            continue;
+        }
+
+        for (VisibleEntity const& visible : _visibleEntities.subspan(first, last - first)) {
+            if (auto const* const transform = world.readFieldSlow(visible.entity, &components::Transform::transform)) {
+                mesh->mesh.asset()->render(ctx, mesh->material.asset(), *transform);
+            }
+        }
+    }
 }
 
-void up::Scene::flush() {
-    _transformQuery.select(_world, [&](EntityId, components::Transform& trans) {
-        trans.transform = glm::translate(trans.position) * glm::mat4_cast(trans.rotation);
-    });
+auto up::Scene::pick(Ray const& ray) const noexcept -> EntityId {
+    RayHit const hit = _spatialIndex.raycast(ray);
+    return hit ? static_cast<EntityId>(hit.key) : EntityId::None;
 }
 
-void up::Scene::render(RenderContext& ctx) {
-    _renderableMeshQuery.select(_world, [&](EntityId, components::Mesh& mesh, components::Transform const& trans) {
-        if (mesh.mesh.ready() && mesh.material.ready()) {
-            mesh.mesh.asset()->render(ctx, mesh.material.asset(), trans.transform);
+void up::Scene::_trackBounds(World& world) {
+    if (_boundsWorld != nullptr) {
+        for (ObserverId const observer : _boundsObservers) {
+            _boundsWorld->unobserve(observer);
         }
-    });
+    }
+    _boundsObservers.clear();
+    _spatialIndex.clear();
+    _boundsWorld = &world;
+    _rebuildBounds = true;
+
+    // Entities gaining a Mesh or Transform are placed in chunks which have changed, so only losses are observed
+    auto const untrack = [this](view<EntityId> entities) {
+        for (EntityId const entity : entities) {
+            _spatialIndex.remove(to_underlying(entity));
+        }
+    };
+    _boundsObservers.push_back(world.observe<components::Mesh>(ObserverEvent::Removed, untrack));
+    _boundsObservers.push_back(world.observe<components::Mesh>(ObserverEvent::Deleted, untrack));
+    _boundsObservers.push_back(world.observe<components::Transform>(ObserverEvent::Removed, untrack));
+}
+
+void up::Scene::_updateBounds(World& world) {
+    bool rebuild = false;
+    auto const update = [&](size_t count,
+                            EntityId const* entities,
+                            components::Mesh const& mesh,
+                            FieldColumns<components::Transform const> trans) {
+        // the bounds of a Mesh are only known once it has loaded, so every chunk is visited again until then
+        if (!mesh.mesh.ready()) {
+            rebuild = true;
+            return;
+        }
+        Aabb const& bounds = mesh.mesh.asset()->bounds();
+        auto const transforms = trans(&components::Transform::transform);
+        for (size_t index = 0; index != count; ++index) {
+            _spatialIndex.update(to_underlying(entities[index]), transformBounds(bounds, transforms[index]));
+        }
+    };
+
+    if (_rebuildBounds) {
+        _renderableMeshQuery.selectChunks(world, update);
+    }
+    else {
+        _renderableMeshQuery.selectChunksChanged(world, update);
+    }
+    _rebuildBounds = rebuild;
 }
 
 auto up::Scene::load(Stream file) -> bool {
@@ -3,6 +3,7 @@
 #include "scene_doc.h"
 #include "components_schema.h"
 
+#include "potato/ecs/hierarchy.h"
 #include "potato/ecs/world.h"
 #include "potato/reflex/serialize.h"
 #include "potato/render/mesh.h"
@@ -16,6 +17,8 @@
 #include <glm/vec3.hpp>
 #include <nlohmann/json.hpp>
 
+#include <new>
+
 int up::SceneDocument::indexOf(EntityId entityId) const noexcept {
     for (int index : indices()) {
         if (_entities[index].id == entityId) {
@@ -110,6 +113,9 @@ void up::SceneDocument::parentTo(EntityId childId, EntityId parentId) {
         childEnt.parent = parentIndex;
         childEnt.nextSibling = -1;
     }
+
+    // the scene's world keeps its own copy of the hierarchy, for propagating transforms
+    setParent(_scene->world(), childId, parentIndex != -1 ? parentId : EntityId::None);
 }
 
 void up::SceneDocument::createTestObjects(
@@ -163,6 +169,10 @@ void up::SceneDocument::_toJson(nlohmann::json& el, int index) const {
     _scene->world().interrogateEntityUnsafe(
         ent.id,
         [&components](EntityId entity, ArchetypeId archetype, reflex::TypeInfo const* typeInfo, auto* data) {
+            // the hierarchy is saved as nested children and rebuilt on load
+            if (isHierarchyComponent(*typeInfo)) {
+                return;
+            }
             nlohmann::json compEl = nlohmann::json::object();
             reflex::encodeToJsonRaw(compEl, *typeInfo->schema, data);
             components.push_back(std::move(compEl));
@@ -207,10 +217,9 @@ void up::SceneDocument::_fromJson(nlohmann::json const& el, int index, AssetLoad
                 continue;
             }
 
-            void* const compData = _scene->world().addComponentDefault(_entities[index].id, *compType);
-            if (compData == nullptr) {
-                continue;
-            }
+            // the value is decoded before it is added, as split components have no contiguous storage to decode into
+            void* const compData = ::operator new(compType->size, std::align_val_t(compType->alignment));
+            compType->ops.defaultConstructor(compData);
 
             reflex::decodeFromJsonRaw(compEl, *compType->schema, compData);
 
@@ -221,6 +230,10 @@ void up::SceneDocument::_fromJson(nlohmann::json const& el, int index, AssetLoad
                     *assetHandle = assetLoader.loadAssetSync(assetHandle->assetId());
                 }
             }
+
+            _scene->world().addComponentUnsafe(_entities[index].id, *compType, compData);
+            compType->ops.destructor(compData);
+            ::operator delete(compData, std::align_val_t(compType->alignment));
         }
     }
 
@@ -237,6 +250,7 @@ void up::SceneDocument::_fromJson(nlohmann::json const& el, int index, AssetLoad
             }
             prevSibling = childIndex;
             _fromJson(childEl, childIndex, assetLoader);
+            setParent(_scene->world(), _entities[childIndex].id, _entities[index].id);
         }
     }
 }
@@ -13,6 +13,7 @@
 #include "editors/scene_editor.h"
 
 #include "potato/audio/sound_resource.h"
+#include "potato/ecs/hierarchy.h"
 #include "potato/ecs/query.h"
 #include "potato/ecs/world.h"
 #include "potato/editor/imgui_backend.h"
@@ -272,11 +273,12 @@ int up::shell::ShellApp::initialize() {
     _universe = new_box<Universe>();
 
     _universe->registerComponent<components::Transform>("Transform");
-    _universe->registerComponent<components::Mesh>("Mesh");
+    _universe->registerSharedComponent<components::Mesh>("Mesh");
     _universe->registerComponent<components::Wave>("Wave");
     _universe->registerComponent<components::Spin>("Spin");
     _universe->registerComponent<components::Ding>("Ding");
     _universe->registerComponent<components::Test>("Test");
+    registerHierarchyComponents(*_universe);
 
     _editorFactories.push_back(
         AssetBrowser::createFactory(_assetLoader, _reconClient, _assetEditService, [this](UUID const& uuid) {
@@ -285,6 +287,7 @@ int up::shell::ShellApp::initialize() {
     _editorFactories.push_back(SceneEditor::createFactory(
         *_audio,
         *_universe,
+        _scheduler,
         _assetLoader,
         [this] { return _universe->components(); },
         [this](rc<Scene> scene) { _createGame(std::move(scene)); }));
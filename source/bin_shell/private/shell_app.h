@@ -16,6 +16,7 @@
 #include "potato/runtime/asset_loader.h"
 #include "potato/runtime/io_loop.h"
 #include "potato/runtime/logger.h"
+#include "potato/runtime/scheduler.h"
 #include "potato/spud/box.h"
 #include "potato/spud/unique_resource.h"
 
@@ -95,6 +96,7 @@ namespace up::shell {
         rc<GpuSwapChain> _swapChain;
         box<Renderer> _renderer;
         box<RenderCamera> _uiRenderCamera;
+        Scheduler _scheduler;
         box<Universe> _universe;
         box<AudioEngine> _audio;
         box<Project> _project;
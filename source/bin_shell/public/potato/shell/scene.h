@@ -3,7 +3,9 @@
 #pragma once
 
 #include "potato/ecs/query.h"
+#include "potato/ecs/system_scheduler.h"
 #include "potato/ecs/universe.h"
+#include "potato/render/spatial_index.h"
 #include "potato/runtime/stream.h"
 #include "potato/spud/box.h"
 #include "potato/spud/rc.h"
@@ -14,15 +16,18 @@ namespace up::components {
     struct Wave;
     struct Spin;
     struct Ding;
+    struct Parent;
+    struct HierarchyDepth;
 } // namespace up::components
 
 namespace up {
     class RenderContext;
     class AudioEngine;
+    class Scheduler;
 
     class Scene : public shared<Scene> {
     public:
-        explicit Scene(Universe& universe, AudioEngine& audioEngine);
+        explicit Scene(Universe& universe, AudioEngine& audioEngine, Scheduler& scheduler);
         ~Scene();
 
         Scene(Scene const&) = delete;
@@ -30,28 +35,63 @@ namespace up {
 
         void tick(float frameTime);
         void flush();
-        void render(RenderContext& ctx);
+
+        /// @brief Renders every Mesh whose bounds intersect the frustum.
+        void render(RenderContext& ctx, Frustum const& frustum);
+
+        /// @brief Finds the nearest rendered Entity whose bounds are struck by a ray.
+        /// @returns EntityId::None if the ray strikes nothing.
+        EntityId pick(Ray const& ray) const noexcept;
 
         bool load(Stream file);
         void save(Stream file);
 
         bool playing() const { return _playing; }
-        bool playing(bool active) { return _playing = active; }
 
+        /// @brief Starts or pauses play; starting for the first time clones the edited world.
+        bool playing(bool active);
+
+        /// @brief Ends play and discards the play world, returning to the edited world.
+        void stop();
+
+        /// @brief The world being edited; it is not modified by play.
         World& world() noexcept { return _world; }
+
+        /// @brief The world that is ticked and rendered; the play world while one exists.
+        World& activeWorld() noexcept { return _playWorld != nullptr ? *_playWorld : _world; }
         Universe& universe() noexcept { return _universe; }
+        SystemScheduler& systems() noexcept { return *_systems; }
 
     private:
+        struct VisibleEntity {
+            ArchetypeId archetype = ArchetypeId::Empty;
+            EntityId entity = EntityId::None;
+        };
+
+        void _trackBounds(World& world);
+        void _updateBounds(World& world);
+
         AudioEngine& _audioEngine;
         Universe& _universe;
+        Scheduler& _scheduler;
         World _world;
+        box<World> _playWorld;
+        box<SystemScheduler> _systems;
+        float _frameTime = 0.f;
         bool _playing = false;
 
-        Query<components::Transform, components::Wave> _waveQuery;
-        Query<components::Transform> _orbitQuery;
-        Query<components::Transform, components::Spin> _spinQuery;
-        Query<components::Ding> _dingQuery;
-        Query<components::Transform> _transformQuery;
-        Query<components::Mesh, components::Transform> _renderableMeshQuery;
+        Query<Fields<components::Transform>, Without<components::Parent>> _transformQuery;
+        Query<Shared<components::HierarchyDepth>, components::Parent const, Fields<components::Transform>>
+            _childTransformQuery;
+        Query<Shared<components::Mesh>, Fields<components::Transform const>> _renderableMeshQuery;
+
+        /// World bounds of every renderable Entity of the tracked world, keyed by EntityId.
+        SpatialIndex _spatialIndex;
+        World* _boundsWorld = nullptr;
+        vector<ObserverId> _boundsObservers;
+        /// Set when every renderable Entity must be visited again, e.g. while a Mesh is loading.
+        bool _rebuildBounds = true;
+        vector<uint64> _visible;
+        vector<VisibleEntity> _visibleEntities;
     };
 } // namespace up
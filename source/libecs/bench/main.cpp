@@ -0,0 +1,467 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "bench_components_schema.h"
+
+#include "potato/ecs/query.h"
+#include "potato/ecs/transforms.h"
+#include "potato/ecs/universe.h"
+#include "potato/ecs/world.h"
+#include "potato/runtime/json.h"
+#include "potato/spud/string_format.h"
+#include "potato/spud/vector.h"
+#include "potato/spud/zstring_view.h"
+
+#include <glm/gtx/transform.hpp>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+// Standalone ECS benchmark suite.
+//
+// Every benchmark runs a number of samples; each sample rebuilds its own fixture, and only the
+// measured region is timed. Results are written as JSON so that runs can be diffed across commits.
+//
+// Usage: potato_libecs_bench [--samples=N] [--filter=TEXT] [--output=PATH]
+
+namespace {
+    using namespace up;
+    using namespace up::components;
+
+    using BenchComponents = std::tuple<
+        Bench0,
+        Bench1,
+        Bench2,
+        Bench3,
+        Bench4,
+        Bench5,
+        Bench6,
+        Bench7,
+        Bench8,
+        Bench9,
+        Bench10,
+        Bench11,
+        Bench12,
+        Bench13,
+        Bench14,
+        Bench15>;
+
+    template <size_t Index>
+    using Bench = std::tuple_element_t<Index, BenchComponents>;
+
+    constexpr size_t benchComponentCount = std::tuple_size_v<BenchComponents>;
+
+    constexpr zstring_view benchComponentNames[benchComponentCount] = {
+        "Bench0",
+        "Bench1",
+        "Bench2",
+        "Bench3",
+        "Bench4",
+        "Bench5",
+        "Bench6",
+        "Bench7",
+        "Bench8",
+        "Bench9",
+        "Bench10",
+        "Bench11",
+        "Bench12",
+        "Bench13",
+        "Bench14",
+        "Bench15"};
+
+    // written by benchmarks so that the measured work cannot be optimized away
+    float volatile sink = 0.f;
+
+    class Stopwatch {
+    public:
+        void start() noexcept { _start = std::chrono::steady_clock::now(); }
+        void stop() noexcept { _elapsed += std::chrono::steady_clock::now() - _start; }
+
+        auto nanoseconds() const noexcept -> double {
+            return std::chrono::duration<double, std::nano>(_elapsed).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point _start;
+        std::chrono::steady_clock::duration _elapsed = {};
+    };
+
+    struct Options {
+        int samples = 10;
+        std::string filter;
+        std::string output;
+    };
+
+    class BenchRunner {
+    public:
+        explicit BenchRunner(Options const& options) : _options(options) {}
+
+        /// @brief Runs a benchmark, if it passes the filter, and records its timings.
+        ///
+        /// @param name Identifier of the benchmark in the results.
+        /// @param operations Number of operations performed by one sample, used to report per-operation cost.
+        /// @param sample Builds its fixture and times its work by starting and stopping the provided Stopwatch.
+        template <callable<Stopwatch&> Sample>
+        void run(zstring_view name, size_t operations, Sample&& sample) {
+            if (std::string_view(name.c_str()).find(_options.filter) == std::string_view::npos) {
+                return;
+            }
+
+            std::cerr << "running " << name.c_str() << "...\n";
+
+            vector<double> timings;
+            timings.reserve(_options.samples);
+            for (int index = 0; index != _options.samples; ++index) {
+                Stopwatch stopwatch;
+                sample(stopwatch);
+                timings.push_back(stopwatch.nanoseconds());
+            }
+            std::sort(timings.begin(), timings.end());
+
+            double total = 0;
+            for (double const timing : timings) {
+                total += timing;
+            }
+            double const median = timings[timings.size() / 2];
+
+            _results.push_back({
+                {"name", name.c_str()},
+                {"samples", timings.size()},
+                {"operations", operations},
+                {"min_ns", timings.front()},
+                {"median_ns", median},
+                {"mean_ns", total / static_cast<double>(timings.size())},
+                {"max_ns", timings.back()},
+                {"ns_per_operation", median / static_cast<double>(operations)},
+            });
+        }
+
+        auto results() const -> nlohmann::json {
+            return {{"suite", "potato_libecs_bench"}, {"samples", _options.samples}, {"results", _results}};
+        }
+
+    private:
+        Options const& _options;
+        nlohmann::json _results = nlohmann::json::array();
+    };
+
+    template <size_t... Indices>
+    void registerBenchComponents(Universe& universe, std::index_sequence<Indices...>) {
+        (universe.registerComponent<Bench<Indices>>(benchComponentNames[Indices]), ...);
+    }
+
+    template <size_t... Indices>
+    auto createBenchEntity(World& world, std::index_sequence<Indices...>) -> EntityId {
+        return world.createEntity(Bench<Indices>{static_cast<float>(Indices)}...);
+    }
+
+    template <size_t... Indices>
+    auto createBenchQuery(Universe& universe, std::index_sequence<Indices...>) {
+        return universe.createQuery<Bench<Indices>...>();
+    }
+
+    template <size_t... Indices>
+    void addBenchComponents(World& world, EntityId entity, uint32 mask, std::index_sequence<Indices...>) {
+        ((mask & (1u << Indices) ? world.addComponent(entity, Bench<Indices>{1.f}) : void()), ...);
+    }
+
+    void benchChurn(BenchRunner& runner, Universe& universe) {
+        constexpr int entityCount = 1000000;
+
+        // the same sequence of operations is replayed for every sample: each step either
+        // creates an entity or deletes a randomly-chosen live one
+        std::mt19937 random(42);
+        vector<bool> creates;
+        vector<size_t> victims;
+        for (int live = 0, created = 0; created != entityCount || live != 0;) {
+            bool const create = created != entityCount && (live == 0 || random() % 3 != 0);
+            creates.push_back(create);
+            if (create) {
+                ++created;
+                ++live;
+            }
+            else {
+                victims.push_back(std::uniform_int_distribution<size_t>(0, live - 1)(random));
+                --live;
+            }
+        }
+
+        runner.run("churn.create_delete", creates.size(), [&](Stopwatch& stopwatch) {
+            auto world = universe.createWorld();
+            vector<EntityId> live;
+            live.reserve(entityCount);
+
+            stopwatch.start();
+            size_t nextVictim = 0;
+            for (bool const create : creates) {
+                if (create) {
+                    live.push_back(createBenchEntity(world, std::make_index_sequence<4>{}));
+                }
+                else {
+                    size_t const victim = victims[nextVictim++];
+                    world.deleteEntity(live[victim]);
+                    live[victim] = live.back();
+                    live.pop_back();
+                }
+            }
+            stopwatch.stop();
+        });
+
+        runner.run("churn.create_batch", entityCount, [&](Stopwatch& stopwatch) {
+            auto world = universe.createWorld();
+
+            stopwatch.start();
+            auto const entities = world.createEntities(entityCount, Bench0{}, Bench1{}, Bench2{}, Bench3{});
+            stopwatch.stop();
+        });
+    }
+
+    void benchMigration(BenchRunner& runner, Universe& universe) {
+        constexpr int entityCount = 50000;
+
+        runner.run("migrate.add_remove", entityCount * 2, [&](Stopwatch& stopwatch) {
+            auto world = universe.createWorld();
+            auto const entities = world.createEntities(entityCount, Bench0{}, Bench1{}, Bench2{}, Bench3{});
+
+            stopwatch.start();
+            for (EntityId const entity : entities) {
+                world.addComponent(entity, Bench4{4.f});
+            }
+            for (EntityId const entity : entities) {
+                world.removeComponent<Bench4>(entity);
+            }
+            stopwatch.stop();
+        });
+    }
+
+    template <size_t Width>
+    void benchQueryWidth(BenchRunner& runner, Universe& universe, World& world, size_t entityCount) {
+        auto query = createBenchQuery(universe, std::make_index_sequence<Width>{});
+
+        char name[64] = {
+            0,
+        };
+        format_to(name, "query.iterate_{}", Width);
+
+        runner.run(name, entityCount, [&](Stopwatch& stopwatch) {
+            stopwatch.start();
+            query.selectChunks(world, [](size_t count, EntityId const*, auto*... columns) {
+                for (size_t index = 0; index != count; ++index) {
+                    ((columns[index].value += 1.f), ...);
+                }
+            });
+            stopwatch.stop();
+        });
+    }
+
+    void benchQuery(BenchRunner& runner, Universe& universe) {
+        constexpr size_t entityCount = 100000;
+
+        auto world = universe.createWorld();
+        for (size_t index = 0; index != entityCount; ++index) {
+            createBenchEntity(world, std::make_index_sequence<benchComponentCount>{});
+        }
+
+        benchQueryWidth<1>(runner, universe, world, entityCount);
+        benchQueryWidth<4>(runner, universe, world, entityCount);
+        benchQueryWidth<16>(runner, universe, world, entityCount);
+    }
+
+    // a kernel reading and writing two of eight fields, with the component stored whole or split by field
+    void benchQueryFields(BenchRunner& runner, Universe& universe) {
+        constexpr size_t entityCount = 100000;
+        constexpr float step = 1.f / 60.f;
+
+        auto world = universe.createWorld();
+        world.createEntities(entityCount, BenchBody{.velocityX = 1.f}, BenchSplitBody{.velocityX = 1.f});
+
+        auto bodies = universe.createQuery<BenchBody>();
+        runner.run("query.field_whole", entityCount, [&](Stopwatch& stopwatch) {
+            stopwatch.start();
+            bodies.selectChunks(world, [](size_t count, EntityId const*, BenchBody* body) {
+                for (size_t index = 0; index != count; ++index) {
+                    body[index].positionX += body[index].velocityX * step;
+                }
+            });
+            stopwatch.stop();
+        });
+
+        auto splitBodies = universe.createQuery<Fields<BenchSplitBody>>();
+        runner.run("query.field_split", entityCount, [&](Stopwatch& stopwatch) {
+            stopwatch.start();
+            splitBodies.selectChunks(world, [](size_t count, EntityId const*, FieldColumns<BenchSplitBody> body) {
+                float* const position = body(&BenchSplitBody::positionX).data();
+                float const* const velocity = body(&BenchSplitBody::velocityX).data();
+                for (size_t index = 0; index != count; ++index) {
+                    position[index] += velocity[index] * step;
+                }
+            });
+            stopwatch.stop();
+        });
+    }
+
+    void benchRandomAccess(BenchRunner& runner, Universe& universe) {
+        constexpr int entityCount = 100000;
+
+        auto world = universe.createWorld();
+        auto entities = world.createEntities(entityCount, Bench0{1.f}, Bench1{}, Bench2{}, Bench3{});
+        std::shuffle(entities.begin(), entities.end(), std::mt19937(42));
+
+        runner.run("access.get_component_slow", entityCount, [&](Stopwatch& stopwatch) {
+            float total = 0.f;
+
+            stopwatch.start();
+            for (EntityId const entity : entities) {
+                total += world.getComponentSlow<Bench0>(entity)->value;
+            }
+            stopwatch.stop();
+
+            sink = total;
+        });
+    }
+
+    void benchArchetypes(BenchRunner& runner) {
+        // every non-empty subset of the first 12 components is a distinct archetype
+        constexpr uint32 archetypeCount = (1u << 12) - 1;
+
+        runner.run("archetypes.create", archetypeCount, [&](Stopwatch& stopwatch) {
+            Universe universe;
+            registerBenchComponents(universe, std::make_index_sequence<benchComponentCount>{});
+            auto world = universe.createWorld();
+
+            stopwatch.start();
+            for (uint32 mask = 1; mask <= archetypeCount; ++mask) {
+                EntityId const entity = world.createEntity();
+                addBenchComponents(world, entity, mask, std::make_index_sequence<benchComponentCount>{});
+            }
+            stopwatch.stop();
+        });
+
+        Universe universe;
+        registerBenchComponents(universe, std::make_index_sequence<benchComponentCount>{});
+        auto world = universe.createWorld();
+        for (uint32 mask = 1; mask <= archetypeCount; ++mask) {
+            EntityId const entity = world.createEntity();
+            addBenchComponents(world, entity, mask, std::make_index_sequence<benchComponentCount>{});
+        }
+
+        // the first select also matches the query against every archetype
+        runner.run("archetypes.query_first_select", archetypeCount, [&](Stopwatch& stopwatch) {
+            auto query = universe.createQuery<Bench0 const, Bench1 const>();
+            float total = 0.f;
+
+            stopwatch.start();
+            query.selectChunks(world, [&total](size_t count, EntityId const*, Bench0 const* first, Bench1 const*) {
+                total += first[0].value * static_cast<float>(count);
+            });
+            stopwatch.stop();
+
+            sink = total;
+        });
+
+        auto query = universe.createQuery<Bench0 const, Bench1 const>();
+        runner.run("archetypes.query_select", archetypeCount, [&](Stopwatch& stopwatch) {
+            float total = 0.f;
+
+            stopwatch.start();
+            query.selectChunks(world, [&total](size_t count, EntityId const*, Bench0 const* first, Bench1 const*) {
+                total += first[0].value * static_cast<float>(count);
+            });
+            stopwatch.stop();
+
+            sink = total;
+        });
+    }
+
+    void benchTransforms(BenchRunner& runner) {
+        constexpr size_t transformCount = 100000;
+
+        vector<glm::vec3> positions(transformCount, glm::vec3(1.f, 2.f, 3.f));
+        vector<glm::quat> rotations(transformCount, glm::angleAxis(0.5f, glm::vec3(0.f, 1.f, 0.f)));
+        vector<glm::mat4x4> matrices(transformCount);
+
+        // the per-transform glm expression is the baseline for the batched composition
+        runner.run("transforms.scalar", transformCount, [&](Stopwatch& stopwatch) {
+            stopwatch.start();
+            for (size_t index = 0; index != transformCount; ++index) {
+                matrices[index] = glm::translate(positions[index]) * glm::mat4_cast(rotations[index]);
+            }
+            stopwatch.stop();
+            sink = matrices.back()[3][0];
+        });
+
+        runner.run("transforms.compose", transformCount, [&](Stopwatch& stopwatch) {
+            stopwatch.start();
+            composeTransforms(positions, rotations, matrices);
+            stopwatch.stop();
+            sink = matrices.back()[3][0];
+        });
+    }
+
+    auto parseOptions(int argc, char const* argv[], Options& options) -> bool {
+        for (int index = 1; index != argc; ++index) {
+            std::string_view const arg = argv[index];
+            if (arg.starts_with("--samples=")) {
+                options.samples = std::atoi(argv[index] + 10);
+                if (options.samples <= 0) {
+                    return false;
+                }
+            }
+            else if (arg.starts_with("--filter=")) {
+                options.filter = arg.substr(9);
+            }
+            else if (arg.starts_with("--output=")) {
+                options.output = arg.substr(9);
+            }
+            else {
+                return false;
+            }
+        }
+        return true;
+    }
+} // namespace
+
+// NOLINTNEXTLINE(bugprone-exception-escape)
+int main(int argc, char const* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: potato_libecs_bench [--samples=N] [--filter=TEXT] [--output=PATH]\n";
+        return 1;
+    }
+
+    BenchRunner runner(options);
+
+    Universe universe;
+    registerBenchComponents(universe, std::make_index_sequence<benchComponentCount>{});
+    universe.registerComponent<BenchBody>("BenchBody");
+    universe.registerComponent<BenchSplitBody>("BenchSplitBody");
+
+    benchChurn(runner, universe);
+    benchMigration(runner, universe);
+    benchQuery(runner, universe);
+    benchQueryFields(runner, universe);
+    benchRandomAccess(runner, universe);
+    benchArchetypes(runner);
+    benchTransforms(runner);
+
+    std::string const json = runner.results().dump(4);
+    if (options.output.empty()) {
+        std::cout << json << '\n';
+        return 0;
+    }
+
+    std::ofstream output(options.output, std::ios::binary | std::ios::trunc);
+    output << json << '\n';
+    if (output.fail()) {
+        std::cerr << "Failed to write to `" << options.output << "`\n";
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "chunk_allocator.h"
+
+#include "potato/runtime/assertion.h"
+#include "potato/runtime/virtual_memory.h"
+
+#include <algorithm>
+#include <new>
+
+up::ChunkAllocator::~ChunkAllocator() {
+    for (Slab& slab : _slabs) {
+        unmapVirtualMemory(slab.memory, slabBytes);
+    }
+}
+
+auto up::ChunkAllocator::allocate(ChunkSizeClass sizeClass) -> Chunk* {
+    // prefer the fullest slab of the class with room, so that emptier slabs have a chance to drain,
+    // and otherwise an empty slab, preferably one already carved for the class
+    Slab* slab = nullptr;
+    Slab* empty = nullptr;
+    for (Slab& candidate : _slabs) {
+        if (candidate.used == 0) {
+            if (empty == nullptr || candidate.sizeClass == sizeClass) {
+                empty = &candidate;
+            }
+        }
+        else if (
+            candidate.sizeClass == sizeClass && candidate.used < chunksPerSlab(sizeClass) &&
+            (slab == nullptr || candidate.used > slab->used)) {
+            slab = &candidate;
+        }
+    }
+
+    if (slab == nullptr) {
+        slab = empty != nullptr ? empty : _mapSlab();
+        if (slab == nullptr) {
+            return nullptr;
+        }
+    }
+
+    if (slab->used == 0) {
+        --_emptySlabs;
+        if (slab->sizeClass != sizeClass) {
+            *slab = Slab{.memory = slab->memory, .sizeClass = sizeClass};
+        }
+    }
+    ++slab->used;
+    ++_chunksInUse;
+    _bytesInUse += chunkSizeBytes(sizeClass);
+
+    if (Chunk* const chunk = slab->freeHead; chunk != nullptr) {
+        slab->freeHead = chunk->header.next;
+        chunk->header = Chunk::Header{.sizeClass = sizeClass};
+        return chunk;
+    }
+
+    UP_ASSERT(slab->carved < chunksPerSlab(sizeClass));
+    Chunk* const chunk = new (slab->memory + slab->carved++ * chunkSizeBytes(sizeClass)) Chunk;
+    chunk->header.sizeClass = sizeClass;
+    return chunk;
+}
+
+void up::ChunkAllocator::deallocate(Chunk* chunk) noexcept {
+    if (chunk == nullptr) {
+        return;
+    }
+
+    Slab* const slab = _findSlab(chunk);
+    UP_ASSERT(slab != nullptr, "Chunk was not allocated by this ChunkAllocator");
+    UP_ASSERT(slab->used != 0);
+    UP_ASSERT(chunk->header.sizeClass == slab->sizeClass);
+
+    chunk->header = Chunk::Header{.sizeClass = slab->sizeClass};
+    chunk->header.next = slab->freeHead;
+    slab->freeHead = chunk;
+
+    --_chunksInUse;
+    _bytesInUse -= chunkSizeBytes(slab->sizeClass);
+    if (--slab->used == 0) {
+        ++_emptySlabs;
+        _trim();
+    }
+}
+
+void up::ChunkAllocator::setRetainedBytes(size_t bytes) noexcept {
+    _retainedBytes = bytes;
+    _trim();
+}
+
+auto up::ChunkAllocator::stats() const noexcept -> ChunkMemoryStats {
+    ChunkMemoryStats stats;
+    stats.chunksInUse = _chunksInUse;
+    stats.bytesInUse = _bytesInUse;
+    for (Slab const& slab : _slabs) {
+        stats.chunksFree += chunksPerSlab(slab.sizeClass) - slab.used;
+    }
+    stats.slabsMapped = _slabs.size();
+    stats.bytesMapped = _slabs.size() * slabBytes;
+    stats.peakBytesMapped = _peakBytesMapped;
+    stats.slabsReleased = _slabsReleased;
+    return stats;
+}
+
+auto up::ChunkAllocator::_findSlab(Chunk const* chunk) noexcept -> Slab* {
+    // slabs are aligned to their size, so the owning slab's address is found by masking
+    auto* const memory =
+        reinterpret_cast<char*>(reinterpret_cast<uintptr>(chunk) & ~static_cast<uintptr>(slabBytes - 1));
+
+    auto const it = std::lower_bound(_slabs.begin(), _slabs.end(), memory, [](Slab const& slab, char const* memory) {
+        return slab.memory < memory;
+    });
+    return it != _slabs.end() && it->memory == memory ? it : nullptr;
+}
+
+auto up::ChunkAllocator::_mapSlab() -> Slab* {
+    auto* const memory = static_cast<char*>(mapVirtualMemory(slabBytes, slabBytes, _hugePages));
+    UP_ASSERT(memory != nullptr, "Failed to map memory for Chunks");
+    if (memory == nullptr) {
+        return nullptr;
+    }
+
+    auto const it = std::lower_bound(_slabs.begin(), _slabs.end(), memory, [](Slab const& slab, char const* memory) {
+        return slab.memory < memory;
+    });
+    Slab& slab = _slabs.insert(it, Slab{.memory = memory});
+
+    ++_emptySlabs;
+    if (_slabs.size() * slabBytes > _peakBytesMapped) {
+        _peakBytesMapped = _slabs.size() * slabBytes;
+    }
+
+    return &slab;
+}
+
+void up::ChunkAllocator::_trim() noexcept {
+    // walk backwards so that erasing a slab does not disturb those yet to be visited
+    for (auto index = _slabs.size(); index != 0 && _emptySlabs * slabBytes > _retainedBytes; --index) {
+        Slab& slab = _slabs[index - 1];
+        if (slab.used != 0) {
+            continue;
+        }
+
+        unmapVirtualMemory(slab.memory, slabBytes);
+        _slabs.erase(_slabs.begin() + (index - 1));
+        --_emptySlabs;
+        ++_slabsReleased;
+    }
+}
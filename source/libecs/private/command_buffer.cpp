@@ -0,0 +1,363 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "command_buffer.h"
+#include "entity_id.h"
+#include "shared_context.h"
+#include "world.h"
+
+#include "potato/runtime/assertion.h"
+#include "potato/spud/find.h"
+#include "potato/spud/sequence.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+up::EntityCommandBuffer::EntityCommandBuffer(rc<EcsSharedContext> context) : _context(std::move(context)) {}
+
+up::EntityCommandBuffer::~EntityCommandBuffer() {
+    clear();
+}
+
+up::EntityCommandBuffer::EntityCommandBuffer(EntityCommandBuffer&& rhs) noexcept
+    : _commands(std::move(rhs._commands))
+    , _components(std::move(rhs._components))
+    , _pages(std::move(rhs._pages))
+    , _currentPage(std::exchange(rhs._currentPage, 0))
+    , _pageOffset(std::exchange(rhs._pageOffset, 0))
+    , _createCount(std::exchange(rhs._createCount, 0))
+    , _context(std::move(rhs._context)) {}
+
+auto up::EntityCommandBuffer::operator=(EntityCommandBuffer&& rhs) noexcept -> EntityCommandBuffer& {
+    if (this != &rhs) {
+        // recorded components live in our pages, so they are destroyed before the pages are replaced
+        clear();
+
+        _commands = std::move(rhs._commands);
+        _components = std::move(rhs._components);
+        _pages = std::move(rhs._pages);
+        _currentPage = std::exchange(rhs._currentPage, 0);
+        _pageOffset = std::exchange(rhs._pageOffset, 0);
+        _createCount = std::exchange(rhs._createCount, 0);
+        _context = std::move(rhs._context);
+    }
+    return *this;
+}
+
+void up::EntityCommandBuffer::deleteEntity(EntityId entity) {
+    _commands.push_back({Op::DeleteEntity, entity});
+}
+
+void up::EntityCommandBuffer::removeComponent(EntityId entity, ComponentId component) {
+    reflex::TypeInfo const* const typeInfo = _context->findComponentById(component);
+    UP_ASSERT(typeInfo != nullptr);
+
+    _commands.push_back({Op::RemoveComponent, entity, static_cast<uint32>(_components.size()), 1});
+    _components.push_back({typeInfo, nullptr});
+}
+
+auto up::EntityCommandBuffer::_recordCreate(view<reflex::TypeInfo const*> components, view<void const*> data)
+    -> EntityId {
+    UP_ASSERT(components.size() == data.size());
+
+    auto const first = static_cast<uint32>(_components.size());
+    for (auto index : sequence(components.size())) {
+        _components.push_back(_storeComponent(*components[index], data[index]));
+    }
+
+    // components are kept in a canonical order so that every creation of the same
+    // archetype can be fed to a single bulk creation during playback
+    //
+    std::sort(
+        _components.begin() + first,
+        _components.end(),
+        [](RecordedComponent const& lhs, RecordedComponent const& rhs) noexcept {
+            return lhs.typeInfo->hash < rhs.typeInfo->hash;
+        });
+
+    EntityId const placeholder = makeDeferredEntityId(_createCount++);
+    _commands.push_back({Op::CreateEntity, placeholder, first, static_cast<uint32>(components.size())});
+    return placeholder;
+}
+
+void up::EntityCommandBuffer::_recordAdd(EntityId entity, reflex::TypeInfo const& typeInfo, void const* data) {
+    _commands.push_back({Op::AddComponent, entity, static_cast<uint32>(_components.size()), 1});
+    _components.push_back(_storeComponent(typeInfo, data));
+}
+
+auto up::EntityCommandBuffer::_storeComponent(reflex::TypeInfo const& typeInfo, void const* data)
+    -> RecordedComponent {
+    UP_ASSERT(typeInfo.size + typeInfo.alignment <= DataPage::SizeBytes);
+
+    // component data is bump-allocated from pages which are never reallocated, so recorded
+    // values never move and need not be relocatable
+    //
+    size_t offset = (_pageOffset + typeInfo.alignment - 1) & ~(typeInfo.alignment - 1);
+    if (_currentPage == _pages.size() || offset + typeInfo.size > DataPage::SizeBytes) {
+        if (_currentPage != _pages.size()) {
+            ++_currentPage;
+        }
+        if (_currentPage == _pages.size()) {
+            _pages.push_back(new_box<DataPage>());
+        }
+        offset = 0;
+    }
+
+    void* const memory = _pages[_currentPage]->bytes + offset;
+    _pageOffset = offset + typeInfo.size;
+
+    if (typeInfo.triviallyCopyable) {
+        std::memcpy(memory, data, typeInfo.size);
+    }
+    else {
+        typeInfo.ops.copyConstructor(memory, data);
+    }
+
+    return {&typeInfo, memory};
+}
+
+void up::EntityCommandBuffer::clear() noexcept {
+    for (RecordedComponent const& component : _components) {
+        if (component.data != nullptr && !component.typeInfo->triviallyCopyable) {
+            component.typeInfo->ops.destructor(component.data);
+        }
+    }
+
+    _commands.clear();
+    _components.clear();
+    _currentPage = 0;
+    _pageOffset = 0;
+    _createCount = 0;
+}
+
+void up::EntityCommandBuffer::playback(World& world) {
+    UP_ASSERT(world._context == _context);
+
+    vector<EntityId> created(_createCount);
+    _playbackCreates(world, created);
+    _playbackChanges(world, created);
+
+    clear();
+
+    world.notifyObservers();
+}
+
+void up::EntityCommandBuffer::_playbackChanges(World& world, view<EntityId> created) {
+    struct PendingMove {
+        EntityId entity = EntityId::None;
+        ArchetypeId source = ArchetypeId::Empty;
+        ArchetypeId target = ArchetypeId::Empty;
+        uint32 firstAdded = 0;
+        uint32 addedCount = 0;
+    };
+
+    vector<uint32> order;
+    for (auto index : sequence(_commands.size())) {
+        Command& command = _commands[index];
+        if (command.op == Op::CreateEntity) {
+            continue;
+        }
+
+        // placeholders are swapped for the entities created by this playback before grouping
+        if (isDeferredEntityId(command.entity)) {
+            auto const createIndex = getDeferredCreateIndex(command.entity);
+            command.entity = createIndex < created.size() ? created[createIndex] : EntityId::None;
+        }
+        order.push_back(static_cast<uint32>(index));
+    }
+    if (order.empty()) {
+        return;
+    }
+
+    // group commands by entity, preserving the order in which they were recorded
+    //
+    std::stable_sort(order.begin(), order.end(), [this](uint32 lhs, uint32 rhs) noexcept {
+        return _commands[lhs].entity < _commands[rhs].entity;
+    });
+
+    vector<EntityId> deletes;
+    vector<PendingMove> moves;
+    vector<World::ComponentData> added;
+    vector<reflex::TypeInfo const*> addedTypes;
+    vector<reflex::TypeInfo const*> removedTypes;
+
+    // collapse all commands for an entity into a single structural change
+    //
+    for (size_t first = 0, last = 0; first != order.size(); first = last) {
+        EntityId const entity = _commands[order[first]].entity;
+        for (last = first + 1; last != order.size() && _commands[order[last]].entity == entity; ++last) {
+        }
+
+        auto const location = world._parseEntityId(entity);
+        if (!location.success) {
+            continue;
+        }
+
+        auto const firstAdded = static_cast<uint32>(added.size());
+        bool deleted = false;
+        removedTypes.clear();
+
+        for (auto const commandIndex : order.subspan(first, last - first)) {
+            Command const& command = _commands[commandIndex];
+            if (command.op == Op::DeleteEntity) {
+                deleted = true;
+                break;
+            }
+
+            RecordedComponent const& component = _components[command.firstComponent];
+            auto const pending = added.subspan(firstAdded);
+            auto const existing = find(pending, component.typeInfo, {}, &World::ComponentData::typeInfo);
+
+            if (command.op == Op::AddComponent) {
+                if (existing != pending.end()) {
+                    existing->data = component.data;
+                }
+                else {
+                    added.push_back({component.typeInfo, component.data});
+                }
+                if (auto const removed = find(removedTypes, component.typeInfo); removed != removedTypes.end()) {
+                    removedTypes.erase(removed);
+                }
+            }
+            else {
+                if (existing != pending.end()) {
+                    added.erase(existing);
+                }
+                if (!contains(removedTypes, component.typeInfo)) {
+                    removedTypes.push_back(component.typeInfo);
+                }
+            }
+        }
+
+        if (deleted) {
+            added.resize(firstAdded);
+            deletes.push_back(entity);
+            continue;
+        }
+
+        addedTypes.clear();
+        for (World::ComponentData const& data : added.subspan(firstAdded)) {
+            if (!_context->isSharedComponent(static_cast<ComponentId>(data.typeInfo->hash))) {
+                addedTypes.push_back(data.typeInfo);
+            }
+        }
+
+        ArchetypeId target = addedTypes.empty() && removedTypes.empty()
+            ? location.archetype
+            : _context->acquireArchetype(location.archetype, addedTypes, removedTypes);
+
+        // a shared component's value selects the archetype, so it is applied as an edge and not stored
+        //
+        for (size_t index = added.size(); index-- != firstAdded;) {
+            World::ComponentData const shared = added[index];
+            if (_context->isSharedComponent(static_cast<ComponentId>(shared.typeInfo->hash))) {
+                target = _context->acquireSharedEdge(target, *shared.typeInfo, shared.data).target;
+                added.erase(added.begin() + index);
+            }
+        }
+
+        if (target == location.archetype && added.size() == firstAdded) {
+            continue;
+        }
+
+        moves.push_back(
+            {entity, location.archetype, target, firstAdded, static_cast<uint32>(added.size()) - firstAdded});
+    }
+
+    for (EntityId const entity : deletes) {
+        world.deleteEntity(entity);
+    }
+
+    if (moves.empty()) {
+        return;
+    }
+
+    // entities moving between the same pair of archetypes are applied as a single batch
+    //
+    std::stable_sort(moves.begin(), moves.end(), [](PendingMove const& lhs, PendingMove const& rhs) noexcept {
+        return lhs.source != rhs.source ? lhs.source < rhs.source : lhs.target < rhs.target;
+    });
+
+    vector<EntityId> batchEntities;
+    vector<view<World::ComponentData>> batchAdded;
+
+    for (size_t first = 0, last = 0; first != moves.size(); first = last) {
+        PendingMove const& head = moves[first];
+        batchEntities.clear();
+        batchAdded.clear();
+
+        for (last = first; last != moves.size() && moves[last].source == head.source &&
+             moves[last].target == head.target;
+             ++last) {
+            batchEntities.push_back(moves[last].entity);
+            batchAdded.push_back(added.subspan(moves[last].firstAdded, moves[last].addedCount));
+        }
+
+        world._moveEntitiesRaw(head.source, head.target, batchEntities, batchAdded);
+    }
+}
+
+void up::EntityCommandBuffer::_playbackCreates(World& world, span<EntityId> created) {
+    struct PendingCreate {
+        ArchetypeId archetype = ArchetypeId::Empty;
+        uint32 command = 0;
+    };
+
+    vector<PendingCreate> creates;
+    vector<reflex::TypeInfo const*> types;
+    vector<void const*> values;
+
+    for (auto index : sequence(_commands.size())) {
+        Command const& command = _commands[index];
+        if (command.op != Op::CreateEntity) {
+            continue;
+        }
+
+        // the values of shared components take part in the archetype, so they are resolved per creation
+        types.clear();
+        values.clear();
+        for (RecordedComponent const& component :
+             _components.subspan(command.firstComponent, command.componentCount)) {
+            types.push_back(component.typeInfo);
+            values.push_back(component.data);
+        }
+
+        creates.push_back({world._acquireArchetype(types, values), static_cast<uint32>(index)});
+    }
+
+    if (creates.empty()) {
+        return;
+    }
+
+    std::stable_sort(creates.begin(), creates.end(), [](PendingCreate const& lhs, PendingCreate const& rhs) noexcept {
+        return lhs.archetype < rhs.archetype;
+    });
+
+    vector<void const*> gathered;
+    vector<EntityId> entities;
+
+    for (size_t first = 0, last = 0; first != creates.size(); first = last) {
+        Command const& head = _commands[creates[first].command];
+
+        types.clear();
+        for (RecordedComponent const& component : _components.subspan(head.firstComponent, head.componentCount)) {
+            types.push_back(component.typeInfo);
+        }
+
+        gathered.clear();
+        for (last = first; last != creates.size() && creates[last].archetype == creates[first].archetype; ++last) {
+            Command const& command = _commands[creates[last].command];
+            for (RecordedComponent const& component :
+                 _components.subspan(command.firstComponent, command.componentCount)) {
+                gathered.push_back(component.data);
+            }
+        }
+
+        entities.resize(last - first);
+        world._createEntitiesRaw(creates[first].archetype, types, gathered, World::CreateData::Gathered, entities);
+
+        for (auto index : sequence(last - first)) {
+            created[getDeferredCreateIndex(_commands[creates[first + index].command].entity)] = entities[index];
+        }
+    }
+}
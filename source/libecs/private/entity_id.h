@@ -19,27 +19,17 @@ namespace up {
         return static_cast<uint64>(entity) >> 48;
     }
 
-    static constexpr auto makeMapped(uint16 generation, uint16 archetypeIndex, uint16 chunkIndex, uint16 entityIndex)
-        -> uint64 {
-        return (static_cast<uint64>(generation) << 48) | (static_cast<uint64>(archetypeIndex) << 32) |
-            (static_cast<uint64>(chunkIndex) << 16) | static_cast<uint64>(entityIndex);
+    // live entities never have generation 0, so it marks the placeholders handed out by command buffers
+    // for entities which will only be created on playback
+    static constexpr auto makeDeferredEntityId(uint64 createIndex) noexcept -> EntityId {
+        return makeEntityId(createIndex + 1, 0);
     }
 
-    static constexpr auto getMappedChunk(uint64 mapping) noexcept -> uint16 {
-        return static_cast<uint16>(mapping >> 16);
+    static constexpr auto isDeferredEntityId(EntityId entity) noexcept -> bool {
+        return entity != EntityId::None && getEntityGeneration(entity) == 0;
     }
 
-    static constexpr auto getMappedIndex(uint64 mapping) noexcept -> uint16 { return static_cast<uint16>(mapping); }
-
-    static constexpr auto getMappedGeneration(uint64 mapping) noexcept -> uint16 {
-        return static_cast<uint16>(mapping >> 48);
-    }
-
-    static constexpr auto getMappedArchetype(uint64 mapping) noexcept -> uint16 {
-        return static_cast<uint16>(mapping >> 32);
-    }
-
-    static constexpr auto makeFreeEntry(uint16 generation, uint64 index) noexcept -> uint64 {
-        return (static_cast<uint64>(generation) << 48) | index;
+    static constexpr auto getDeferredCreateIndex(EntityId entity) noexcept -> uint64 {
+        return getEntityMappingIndex(entity) - 1;
     }
 } // namespace up
@@ -0,0 +1,122 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "hierarchy.h"
+#include "universe.h"
+#include "world.h"
+
+#include "potato/runtime/assertion.h"
+#include "potato/spud/vector.h"
+
+namespace up {
+    // unlinks an entity from its siblings and its parent's list of children
+    static void detachFromParent(World& world, EntityId child, EntityId parent) {
+        components::Parent const link = *world.readComponentSlow<components::Parent>(child);
+
+        if (link.previousSibling != EntityId::None) {
+            world.getComponentSlow<components::Parent>(link.previousSibling)->nextSibling = link.nextSibling;
+        }
+        if (link.nextSibling != EntityId::None) {
+            world.getComponentSlow<components::Parent>(link.nextSibling)->previousSibling = link.previousSibling;
+        }
+
+        auto* const children = world.getComponentSlow<components::Children>(parent);
+        UP_ASSERT(children != nullptr);
+        if (children->first == child) {
+            children->first = link.nextSibling;
+        }
+        if (children->last == child) {
+            children->last = link.previousSibling;
+        }
+        if (children->first == EntityId::None) {
+            world.removeComponent<components::Children>(parent);
+        }
+    }
+} // namespace up
+
+void up::registerHierarchyComponents(Universe& universe) {
+    universe.registerComponent<components::Parent>("Parent");
+    universe.registerComponent<components::Children>("Children");
+    universe.registerSharedComponent<components::HierarchyDepth>("HierarchyDepth");
+}
+
+auto up::isHierarchyComponent(reflex::TypeInfo const& typeInfo) noexcept -> bool {
+    return typeInfo.schema == &reflex::getSchema<components::Parent>() ||
+        typeInfo.schema == &reflex::getSchema<components::Children>() ||
+        typeInfo.schema == &reflex::getSchema<components::HierarchyDepth>();
+}
+
+void up::setParent(World& world, EntityId child, EntityId parent) {
+    EntityId const previous = parentOf(world, child);
+    if (parent == previous) {
+        return;
+    }
+
+    for (EntityId ancestor = parent; ancestor != EntityId::None; ancestor = parentOf(world, ancestor)) {
+        if (ancestor == child) {
+            UP_ASSERT(false, "An Entity cannot be attached to itself or to its own descendants");
+            return;
+        }
+    }
+
+    if (previous != EntityId::None) {
+        detachFromParent(world, child, previous);
+    }
+
+    if (parent == EntityId::None) {
+        world.removeComponent<components::Parent>(child);
+        world.removeComponent<components::HierarchyDepth>(child);
+    }
+    else {
+        // children are appended, so they are listed in the order they were attached
+        EntityId last = EntityId::None;
+        if (auto* const children = world.getComponentSlow<components::Children>(parent); children != nullptr) {
+            last = children->last;
+            children->last = child;
+            world.getComponentSlow<components::Parent>(last)->nextSibling = child;
+        }
+        else {
+            world.addComponent(parent, components::Children{.first = child, .last = child});
+        }
+
+        world.addComponent(
+            child,
+            components::Parent{.entity = parent, .previousSibling = last, .nextSibling = EntityId::None});
+        world.addComponent(child, components::HierarchyDepth{.depth = depthOf(world, parent) + 1});
+    }
+
+    // every descendant moves by the same number of levels; links are by id, so they remain
+    // valid while each depth change moves an entity to another archetype
+    vector<EntityId> pending;
+    pending.push_back(child);
+    while (!pending.empty()) {
+        EntityId const entity = pending.back();
+        pending.pop_back();
+
+        uint32 const depth = depthOf(world, entity) + 1;
+        for (EntityId descendant = firstChildOf(world, entity); descendant != EntityId::None;
+             descendant = nextSiblingOf(world, descendant)) {
+            world.addComponent(descendant, components::HierarchyDepth{.depth = depth});
+            pending.push_back(descendant);
+        }
+    }
+}
+
+auto up::parentOf(World const& world, EntityId entity) noexcept -> EntityId {
+    auto const* const link = world.readComponentSlow<components::Parent>(entity);
+    return link != nullptr ? link->entity : EntityId::None;
+}
+
+auto up::firstChildOf(World const& world, EntityId entity) noexcept -> EntityId {
+    auto const* const children = world.readComponentSlow<components::Children>(entity);
+    return children != nullptr ? children->first : EntityId::None;
+}
+
+auto up::nextSiblingOf(World const& world, EntityId entity) noexcept -> EntityId {
+    auto const* const link = world.readComponentSlow<components::Parent>(entity);
+    return link != nullptr ? link->nextSibling : EntityId::None;
+}
+
+auto up::depthOf(World const& world, EntityId entity) noexcept -> uint32 {
+    auto const* const depth = world.readComponentSlow<components::HierarchyDepth>(entity);
+    return depth != nullptr ? depth->depth : 0;
+}
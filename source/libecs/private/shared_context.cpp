@@ -1,68 +1,270 @@
 // Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
 
 #include "shared_context.h"
+#include "ecs_schema.h"
 
+#include "potato/reflex/serialize.h"
+#include "potato/runtime/lock_guard.h"
 #include "potato/spud/find.h"
+#include "potato/spud/sequence.h"
 #include "potato/spud/sort.h"
 #include "potato/spud/utility.h"
 
+#include <cstring>
+#include <new>
+
+namespace up {
+    // threads are spread across the chunk caches in the order they first use one
+    static auto chunkCacheIndex() noexcept -> uint32 {
+        static std::atomic<uint32> nextIndex = 0;
+        thread_local uint32 const index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+        return index % EcsSharedContext::chunkCacheCount;
+    }
+
+    static auto chunkCacheLimitFor(ChunkSizeClass sizeClass, size_t retainedBytes) noexcept -> uint32 {
+        size_t const perCache =
+            retainedBytes / chunkSizeClassCount / chunkSizeBytes(sizeClass) / EcsSharedContext::chunkCacheCount;
+        return static_cast<uint32>(
+            perCache < EcsSharedContext::maxCachedChunks ? perCache : EcsSharedContext::maxCachedChunks);
+    }
+
+    static auto allocateValue(reflex::TypeInfo const& typeInfo) -> void* {
+        return ::operator new(typeInfo.size, std::align_val_t(typeInfo.alignment));
+    }
+
+    static void freeValue(reflex::TypeInfo const& typeInfo, void* data) noexcept {
+        typeInfo.ops.destructor(data);
+        ::operator delete(data, std::align_val_t(typeInfo.alignment));
+    }
+
+    // each field's sub-column is as wide as the gap to the next field, so sub-columns tile the component
+    static auto splitFieldsFor(reflex::TypeInfo const& typeInfo) -> vector<SplitField> {
+        vector<SplitField> fields;
+        if (typeInfo.schema == nullptr || queryAnnotation<schema::SplitFields>(*typeInfo.schema) == nullptr) {
+            return fields;
+        }
+
+        UP_ASSERT(typeInfo.triviallyCopyable, "Split components must be trivially copyable");
+        UP_ASSERT(typeInfo.size <= maxSplitComponentSize, "Split component is too large");
+        UP_ASSERT(typeInfo.alignment <= alignof(std::max_align_t), "Split component is over-aligned");
+        UP_ASSERT(typeInfo.schema->baseSchema == nullptr, "Split components cannot inherit fields");
+        UP_ASSERT(!typeInfo.schema->fields.empty(), "Split components must have fields");
+
+        for (reflex::SchemaField const& field : typeInfo.schema->fields) {
+            fields.push_back({.offset = static_cast<uint16>(field.offset)});
+        }
+        sort(fields, {}, &SplitField::offset);
+        for (auto index : sequence(fields.size())) {
+            size_t const end = index + 1 != fields.size() ? fields[index + 1].offset : typeInfo.size;
+            fields[index].width = static_cast<uint16>(end - fields[index].offset);
+        }
+        return fields;
+    }
+} // namespace up
+
+up::EcsSharedContext::EcsSharedContext() {
+    for (uint32 sizeClass = 0; sizeClass != chunkSizeClassCount; ++sizeClass) {
+        _chunkCacheLimits[sizeClass].store(
+            chunkCacheLimitFor(static_cast<ChunkSizeClass>(sizeClass), _chunkAllocator.retainedBytes()),
+            std::memory_order_relaxed);
+    }
+
+    // the empty archetype always exists, and has room only for entity ids; with no rows its signature is zero
+    ArchetypeId const empty = _publishArchetype(
+        {.maxEntitiesPerChunk = Chunk::payloadBytes(ChunkSizeClass::Small) / sizeof(EntityId),
+         .sizeClass = ChunkSizeClass::Small});
+    _indexArchetype(0, empty);
+}
+
+up::EcsSharedContext::~EcsSharedContext() {
+    for (box<SharedValue> const& shared : _sharedValues) {
+        if (shared->constructed) {
+            shared->typeInfo->ops.destructor(shared->data);
+        }
+        ::operator delete(shared->data, std::align_val_t(shared->typeInfo->alignment));
+    }
+}
+
+void up::EcsSharedContext::registerComponent(reflex::TypeInfo const& typeInfo, bool shared) {
+    UP_ASSERT(!_componentsByHash.contains(typeInfo.hash));
+    UP_ASSERT(!_componentsByName.contains(typeInfo.name));
+    UP_ASSERT(!shared || typeInfo.schema != nullptr, "Shared components require a schema to compare values");
+
+    auto const index = static_cast<uint32>(components.size());
+    components.push_back(&typeInfo);
+    _sharedComponents.push_back(shared);
+    _splitFields.push_back(splitFieldsFor(typeInfo));
+    UP_ASSERT(!shared || _splitFields.back().empty(), "Shared components cannot be split");
+    _componentsByHash.insert(typeInfo.hash, index);
+    _componentsByName.insert(typeInfo.name, index);
+}
+
+auto up::EcsSharedContext::isSharedComponent(ComponentId id) const noexcept -> bool {
+    auto const found = _componentsByHash.find(static_cast<uint64>(id));
+    return found && _sharedComponents[found->value];
+}
+
+auto up::EcsSharedContext::splitFieldsOf(ComponentId id) const noexcept -> view<SplitField> {
+    auto const found = _componentsByHash.find(static_cast<uint64>(id));
+    return found ? view<SplitField>(_splitFields[found->value]) : view<SplitField>{};
+}
+
+auto up::EcsSharedContext::indexOfComponent(ComponentId id) const noexcept -> int {
+    auto const found = _componentsByHash.find(static_cast<uint64>(id));
+    return found ? static_cast<int>(found->value) : -1;
+}
+
 auto up::EcsSharedContext::findComponentById(ComponentId id) const noexcept -> reflex::TypeInfo const* {
-    auto const* it = find(components, static_cast<uint64>(id), equality{}, &reflex::TypeInfo::hash);
-    return it != components.end() ? *it : nullptr;
+    return _findComponentByTypeHash(static_cast<uint64>(id));
 }
 
 auto up::EcsSharedContext::findComponentByName(string_view name) const noexcept -> reflex::TypeInfo const* {
-    auto const* it = find(components, name, equality{}, &reflex::TypeInfo::name);
-    return it != components.end() ? *it : nullptr;
+    auto const found = _componentsByName.find(name);
+    return found ? components[found->value] : nullptr;
 }
 
 auto up::EcsSharedContext::_findComponentByTypeHash(uint64 typeHash) const noexcept -> reflex::TypeInfo const* {
-    auto const* it = find(components, typeHash, equality{}, &reflex::TypeInfo::hash);
-    return it != components.end() ? *it : nullptr;
+    auto const found = _componentsByHash.find(typeHash);
+    return found ? components[found->value] : nullptr;
 }
 
-auto up::EcsSharedContext::acquireChunk() -> Chunk* {
-    if (freeChunkHead != nullptr) {
-        Chunk* const chunk = freeChunkHead;
-        freeChunkHead = chunk->header.next;
-        chunk->header.next = nullptr;
-        return chunk;
+auto up::EcsSharedContext::acquireChunk(ArchetypeId archetype) -> Chunk* {
+    ArchetypeLayout const& layout = archetypeLayout(archetype);
+    if (layout.hasSharedValues || layout.sizeClass != layout.preferredSizeClass) {
+        _retainArchetype(archetype);
     }
 
-    Chunk* const chunk = allocatedChunks.push_back(new_box<Chunk>()).get();
+    Chunk* const chunk = _acquireChunk(layout.sizeClass);
+    chunk->header.archetype = archetype;
     return chunk;
 }
 
+auto up::EcsSharedContext::_acquireChunk(ChunkSizeClass sizeClass) -> Chunk* {
+    ChunkCache& cache = _chunkCaches[to_underlying(sizeClass)][chunkCacheIndex()];
+    {
+        LockGuard _(cache.lock);
+        if (Chunk* const chunk = cache.head; chunk != nullptr) {
+            cache.head = chunk->header.next;
+            --cache.count;
+            chunk->header = Chunk::Header{.sizeClass = sizeClass};
+            return chunk;
+        }
+    }
+
+    LockGuard _(_chunkLock);
+    return _chunkAllocator.allocate(sizeClass);
+}
+
 void up::EcsSharedContext::recycleChunk(Chunk* chunk) noexcept {
     if (chunk == nullptr) {
         return;
     }
 
-    chunk->header.archetype = ArchetypeId::Empty;
-    chunk->header.entities = 0;
-    chunk->header.next = freeChunkHead;
-    freeChunkHead = chunk;
+    if (ArchetypeLayout const& layout = archetypeLayout(chunk->header.archetype);
+        layout.hasSharedValues || layout.sizeClass != layout.preferredSizeClass) {
+        _releaseArchetype(chunk->header.archetype);
+    }
+
+    auto const sizeClass = to_underlying(chunk->header.sizeClass);
+    ChunkCache& cache = _chunkCaches[sizeClass][chunkCacheIndex()];
+    {
+        LockGuard _(cache.lock);
+        if (cache.count < _chunkCacheLimits[sizeClass].load(std::memory_order_relaxed)) {
+            chunk->header.next = cache.head;
+            cache.head = chunk;
+            ++cache.count;
+            return;
+        }
+    }
+
+    LockGuard _(_chunkLock);
+    _chunkAllocator.deallocate(chunk);
+}
+
+auto up::EcsSharedContext::chunkMemoryStats() const noexcept -> ChunkMemoryStats {
+    size_t cached = 0;
+    size_t cachedBytes = 0;
+    for (uint32 sizeClass = 0; sizeClass != chunkSizeClassCount; ++sizeClass) {
+        for (ChunkCache& cache : _chunkCaches[sizeClass]) {
+            LockGuard _(cache.lock);
+            cached += cache.count;
+            cachedBytes += cache.count * chunkSizeBytes(static_cast<ChunkSizeClass>(sizeClass));
+        }
+    }
+
+    LockGuard _(_chunkLock);
+    ChunkMemoryStats stats = _chunkAllocator.stats();
+    stats.chunksInUse -= cached;
+    stats.bytesInUse -= cachedBytes;
+    stats.chunksFree += cached;
+    return stats;
+}
+
+void up::EcsSharedContext::setChunkRetainedBytes(size_t bytes) noexcept {
+    for (uint32 sizeClass = 0; sizeClass != chunkSizeClassCount; ++sizeClass) {
+        uint32 const limit = chunkCacheLimitFor(static_cast<ChunkSizeClass>(sizeClass), bytes);
+        _chunkCacheLimits[sizeClass].store(limit, std::memory_order_relaxed);
+        _trimChunkCaches(static_cast<ChunkSizeClass>(sizeClass), limit);
+    }
+
+    LockGuard _(_chunkLock);
+    _chunkAllocator.setRetainedBytes(bytes);
+}
+
+void up::EcsSharedContext::_trimChunkCaches(ChunkSizeClass sizeClass, uint32 limit) noexcept {
+    for (ChunkCache& cache : _chunkCaches[to_underlying(sizeClass)]) {
+        Chunk* released = nullptr;
+        {
+            LockGuard _(cache.lock);
+            while (cache.count > limit) {
+                Chunk* const chunk = cache.head;
+                cache.head = chunk->header.next;
+                --cache.count;
+                chunk->header.next = released;
+                released = chunk;
+            }
+        }
+
+        LockGuard _(_chunkLock);
+        while (released != nullptr) {
+            Chunk* const chunk = released;
+            released = chunk->header.next;
+            _chunkAllocator.deallocate(chunk);
+        }
+    }
 }
 
 auto up::EcsSharedContext::_bindArchetypeOffets(
     ArchetypeId archetype,
-    view<ComponentId> componentIds,
-    span<int> offsets) const noexcept -> bool {
-    UP_ASSERT(componentIds.size() == offsets.size());
+    view<QueryBinding> bindings,
+    span<int> offsets,
+    span<int> versionOffsets,
+    span<void const*> sharedValues) const noexcept -> bool {
+    UP_ASSERT(bindings.size() == offsets.size());
+    UP_ASSERT(bindings.size() == versionOffsets.size());
+    UP_ASSERT(bindings.size() == sharedValues.size());
 
     auto const layout = layoutOf(archetype);
 
-    if (layout.size() < componentIds.size()) {
-        return false;
-    }
+    for (QueryBinding const& binding : bindings) {
+        auto const desc = find(layout, binding.component, {}, &LayoutRow::component);
+        bool const found = desc != layout.end();
 
-    for (ComponentId const component : componentIds) {
-        auto const desc = find(layout, component, {}, &LayoutRow::component);
-        if (desc == layout.end()) {
+        if (binding.match == QueryMatch::Required && !found) {
+            return false;
+        }
+        if (binding.match == QueryMatch::Excluded && found) {
             return false;
         }
-        offsets.front() = desc->offset;
+
+        // missing optional components and excluded components are bound as -1, as are
+        // shared components, which are bound to their value instead
+        offsets.front() = found && desc->sharedValue == nullptr ? desc->offset : -1;
         offsets.pop_front();
+        versionOffsets.front() = found && desc->stored() ? desc->versionOffset : -1;
+        versionOffsets.pop_front();
+        sharedValues.front() = found ? desc->sharedValue : nullptr;
+        sharedValues.pop_front();
     }
 
     return true;
@@ -72,60 +274,200 @@ auto up::EcsSharedContext::acquireArchetype(
     ArchetypeId original,
     view<reflex::TypeInfo const*> include,
     view<reflex::TypeInfo const*> exclude) -> ArchetypeId {
-    // attempt to find any existing archetype with the same component set
+    LockGuard _(_archetypeLock);
+
+    bool const singleAdd = include.size() == 1 && exclude.empty();
+    bool const singleRemove = exclude.size() == 1 && include.empty();
+    if (!singleAdd && !singleRemove) {
+        return _promotedEdge(original, {.target = _acquireArchetypeSlow(original, include, exclude)}).target;
+    }
+
+    reflex::TypeInfo const& typeInfo = singleAdd ? *include.front() : *exclude.front();
+    return _promotedEdge(original, _acquireEdge(original, typeInfo, singleAdd)).target;
+}
+
+auto up::EcsSharedContext::acquireAddEdge(ArchetypeId original, reflex::TypeInfo const& typeInfo) -> ArchetypeEdge {
+    LockGuard _(_archetypeLock);
+    return _promotedEdge(original, _acquireEdge(original, typeInfo, true));
+}
+
+auto up::EcsSharedContext::acquireRemoveEdge(ArchetypeId original, reflex::TypeInfo const& typeInfo)
+    -> ArchetypeEdge {
+    LockGuard _(_archetypeLock);
+    return _promotedEdge(original, _acquireEdge(original, typeInfo, false));
+}
+
+auto up::EcsSharedContext::acquireSharedEdge(ArchetypeId original, reflex::TypeInfo const& typeInfo, void const* value)
+    -> ArchetypeEdge {
+    UP_ASSERT(isSharedComponent(static_cast<ComponentId>(typeInfo.hash)));
+
+    LockGuard _(_archetypeLock);
+
+    SharedValue const& shared = _internSharedValue(typeInfo, value);
+
+    SharedEdgeKey const key{original, shared.data};
+    if (auto const edge = _sharedEdges.find(key)) {
+        return _promotedEdge(original, edge->value);
+    }
+
+    reflex::TypeInfo const* const typeInfoPtr = &typeInfo;
+    ArchetypeId const target = _acquireArchetypeSlow(original, view{&typeInfoPtr, 1}, {}, &shared);
+
+    ArchetypeEdge const edge = _buildRowMap(original, target);
+    _sharedEdges.insert(key, edge);
+    return _promotedEdge(original, edge);
+}
+
+auto up::EcsSharedContext::_promotedEdge(ArchetypeId original, ArchetypeEdge edge) const noexcept -> ArchetypeEdge {
+    // an archetype and its promoted variant have identical rows, so the edge's row map holds for both
     //
-    {
-        auto const originalLayout = layoutOf(original);
-        for (size_t index = 0; index != archetypes.size(); ++index) {
-            auto const layout = layoutOf(ArchetypeId(index));
-            if (any(exclude, [&layout](reflex::TypeInfo const* typeInfo) noexcept {
-                    return contains(layout, typeInfo, {}, &LayoutRow::typeInfo);
-                })) {
-                continue;
-            }
-            if (!all(include, [&layout](reflex::TypeInfo const* typeInfo) noexcept {
-                    return contains(layout, typeInfo, {}, &LayoutRow::typeInfo);
-                })) {
-                continue;
-            }
-            if (!all(originalLayout, [&layout](auto const& row) noexcept {
-                    return contains(layout, row.typeInfo, {}, &LayoutRow::typeInfo);
-                })) {
-                continue;
-            }
-            return ArchetypeId(index);
-        }
+    auto const index = to_underlying(edge.target);
+    if (edge.target != original && index < _promotedTo.size() && _promotedTo[index] != ArchetypeId::Empty) {
+        edge.target = _promotedTo[index];
+    }
+    return edge;
+}
+
+auto up::EcsSharedContext::_acquireEdge(ArchetypeId original, reflex::TypeInfo const& typeInfo, bool add)
+    -> ArchetypeEdge {
+    // adding or removing a single component is by far the most common structural change,
+    // so we cache the result as an edge in the archetype graph
+    //
+    ArchetypeEdgeKey const key{original, static_cast<ComponentId>(typeInfo.hash)};
+
+    auto& edges = add ? _addEdges : _removeEdges;
+    if (auto const edge = edges.find(key)) {
+        return edge->value;
     }
 
-    // allocate a new Archetype entry
-    auto id = ArchetypeId(archetypes.size());
-    auto& archData = archetypes.push_back({static_cast<uint32>(chunkRows.size())});
+    reflex::TypeInfo const* const typeInfoPtr = &typeInfo;
+    view<reflex::TypeInfo const*> const changed{&typeInfoPtr, 1};
+    ArchetypeId const target =
+        add ? _acquireArchetypeSlow(original, changed, {}) : _acquireArchetypeSlow(original, {}, changed);
 
-    // append component from the original archetype
+    ArchetypeEdge const edge = _buildRowMap(original, target);
+    edges.insert(key, edge);
+
+    // the inverse edge is known for free, unless the change was a no-op; re-adding a removed
+    // shared component would give it a default value rather than restore the original one
     //
-    // NOTE: be careful since we're pushing into the container that stores the
-    // original layout, so we can't safely use a span here!
+    bool const restoresValue = !add && isSharedComponent(key.component);
+    if (target != original && !restoresValue) {
+        auto& inverseEdges = add ? _removeEdges : _addEdges;
+        inverseEdges.insert(ArchetypeEdgeKey{target, key.component}, _buildRowMap(target, original));
+    }
+
+    return edge;
+}
+
+auto up::EcsSharedContext::_buildRowMap(ArchetypeId original, ArchetypeId target) -> ArchetypeEdge {
+    auto const originalLayout = layoutOf(original);
+    auto const targetLayout = layoutOf(target);
+
+    span<int16> const rowMap = _edgeRowMaps.allocate(originalLayout.size());
+    for (auto rowIndex : sequence(originalLayout.size())) {
+        rowMap[rowIndex] = -1;
+        for (auto index : sequence(targetLayout.size())) {
+            if (targetLayout[index].component == originalLayout[rowIndex].component) {
+                rowMap[rowIndex] = static_cast<int16>(index);
+                break;
+            }
+        }
+    }
+    return {.target = target, .rowMap = rowMap.data(), .rowMapLength = static_cast<uint16>(rowMap.size())};
+}
+
+auto up::EcsSharedContext::_acquireArchetypeSlow(
+    ArchetypeId original,
+    view<reflex::TypeInfo const*> include,
+    view<reflex::TypeInfo const*> exclude,
+    SharedValue const* shared) -> ArchetypeId {
+    // build the sorted set of components for the target archetype, along with the values
+    // of its shared components
     //
-    auto const& originalArch = archetypes[to_underlying(original)];
-    for (int index = 0; index != originalArch.layoutLength; ++index) {
-        auto const rowIndex = originalArch.layoutOffset + index;
-        auto const& row = chunkRows[rowIndex];
+    _scratchRows.clear();
+    for (LayoutRow const& row : layoutOf(original)) {
         if (!contains(exclude, row.typeInfo)) {
-            chunkRows.push_back(chunkRows[rowIndex]);
+            _scratchRows.push_back(
+                {.component = row.component, .typeInfo = row.typeInfo, .sharedValue = row.sharedValue});
         }
     }
+    for (reflex::TypeInfo const* typeInfo : include) {
+        auto const component = static_cast<ComponentId>(typeInfo->hash);
+        if (!contains(_scratchRows, component, {}, &LayoutRow::component)) {
+            _scratchRows.push_back({.component = component, .typeInfo = typeInfo});
+        }
+    }
+    for (LayoutRow& row : _scratchRows) {
+        if (shared != nullptr && row.typeInfo == shared->typeInfo) {
+            row.sharedValue = shared->data;
+        }
+        else if (row.sharedValue == nullptr && isSharedComponent(row.component)) {
+            row.sharedValue = _defaultSharedValue(*row.typeInfo).data;
+        }
+    }
+    sort(_scratchRows, {}, &LayoutRow::component);
 
-    // append all the new components
+    // interned shared values are unique, so their addresses identify them
     //
-    for (reflex::TypeInfo const* typeInfo : include) {
-        chunkRows.push_back({static_cast<ComponentId>(typeInfo->hash), typeInfo});
+    uint64 signature = 0;
+    for (LayoutRow const& row : _scratchRows) {
+        signature = hash_combine(signature, row.typeInfo->hash);
+        if (row.sharedValue != nullptr) {
+            signature = hash_combine(signature, hash_value(reinterpret_cast<uintptr>(row.sharedValue)));
+        }
+    }
+
+    if (auto const [success, archetype] = _findArchetype(signature, _scratchRows); success) {
+        return archetype;
     }
 
-    // now that all components are added, we can calculate the total number of them
-    // excluding all the duplicates
+    return _createArchetype(signature, _scratchRows);
+}
+
+auto up::EcsSharedContext::_findArchetype(uint64 signature, view<LayoutRow> rows) noexcept -> FindResult {
+    auto const matches = [this, rows](ArchetypeId archetype) noexcept {
+        auto const layout = layoutOf(archetype);
+        if (layout.size() != rows.size()) {
+            return false;
+        }
+        for (size_t index = 0; index != layout.size(); ++index) {
+            if (layout[index].typeInfo != rows[index].typeInfo ||
+                layout[index].sharedValue != rows[index].sharedValue) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // archetypes are indexed by a hash of their sorted component set and shared values, and
+    // only archetypes whose signatures collide need to be compared
     //
-    archData.layoutLength = static_cast<uint16>(chunkRows.size() - archData.layoutOffset);
-    auto const newLayout = chunkRows.subspan(archData.layoutOffset, archData.layoutLength);
+    auto const found = _archetypesBySignature.find(signature);
+    if (!found) {
+        return {};
+    }
+
+    ArchetypeId archetype = found->value;
+    do {
+        if (matches(archetype)) {
+            return {true, archetype};
+        }
+        archetype = _nextWithSignature[to_underlying(archetype)];
+    } while (archetype != ArchetypeId::Empty);
+
+    return {};
+}
+
+auto up::EcsSharedContext::_createArchetype(uint64 signature, view<LayoutRow> rows, bool promoted) -> ArchetypeId {
+    // the new Archetype is filled in completely before it is published to other threads
+    auto const newLayout = _layoutRows.allocate(rows.size());
+    for (auto index : sequence(rows.size())) {
+        newLayout[index] = {rows[index].component, rows[index].typeInfo};
+        newLayout[index].sharedValue = rows[index].sharedValue;
+    }
+
+    ArchetypeLayout archData{.rows = newLayout.data(), .layoutLength = static_cast<uint16>(rows.size())};
 
     // sort rows by alignment for ideal packing
     //
@@ -134,30 +476,72 @@ auto up::EcsSharedContext::acquireArchetype(
     // calculate total size of all components including padding, used to determine how many
     // entities we can store in a chunk for this archetype
     //
+    // tags hold no data and shared components are stored outside of the chunk, so they take no space in it
+    //
     size_t size = sizeof(EntityId);
     size_t padding = 0;
-    for (auto const& row : newLayout) {
+    size_t dataRows = 0;
+    for (auto& row : newLayout) {
+        row.tag = row.typeInfo->empty;
+        archData.hasSharedValues |= row.sharedValue != nullptr;
+        if (!row.stored()) {
+            continue;
+        }
         padding += align_to(size, row.typeInfo->alignment) - size;
         size += row.typeInfo->size;
+        ++dataRows;
     }
 
+    // each row with data has a write version, stored at the end of the chunk payload
+    //
+    size_t const versionsSize = sizeof(uint32) * dataRows;
+
+    // prefer the smallest chunks that hold enough entities to make iterating them worthwhile, so that
+    // narrow archetypes don't hold on to mostly-empty chunks, and wide archetypes still get large batches
+    //
+    // until a wide archetype has filled a few chunks it may only ever have a handful of entities, so it
+    // starts in chunks just large enough to hold some of them; see promoteAfterChunks
+    //
+    auto const smallestHolding = [&](size_t count) noexcept {
+        auto sizeClass = ChunkSizeClass::Small;
+        while (sizeClass != ChunkSizeClass::Large &&
+               (Chunk::payloadBytes(sizeClass) - versionsSize - padding) / size < count) {
+            sizeClass = static_cast<ChunkSizeClass>(to_underlying(sizeClass) + 1);
+        }
+        return sizeClass;
+    };
+    archData.preferredSizeClass = smallestHolding(minEntitiesPerChunk);
+    archData.sizeClass = promoted ? archData.preferredSizeClass : smallestHolding(minEntitiesPerNewChunk);
+    size_t const versionsOffset = Chunk::payloadBytes(archData.sizeClass) - versionsSize;
+
     // calculate how many entities with this layout can fit in a single chunk
     //
-    archData.maxEntitiesPerChunk = size != 0 ? static_cast<uint32>((sizeof(Chunk::Payload) - padding) / size) : 0;
+    archData.maxEntitiesPerChunk = static_cast<uint16>((versionsOffset - padding) / size);
     UP_ASSERT(archData.maxEntitiesPerChunk > 0);
 
     // calculate the chunk offsets for each row of components in a chunk
     //
     size_t offset = sizeof(EntityId) * archData.maxEntitiesPerChunk;
+    size_t versionOffset = versionsOffset;
     for (auto& row : newLayout) {
-        offset = align_to(offset, row.typeInfo->alignment);
-
         row.component = static_cast<ComponentId>(row.typeInfo->hash);
+
+        // rows without storage have a width of zero, so every entity's instance shares the same offset
+        if (!row.stored()) {
+            continue;
+        }
+
+        // split rows keep the same footprint, carved into one sub-column per field
+        row.fields = splitFieldsOf(row.component);
+
+        offset = align_to(offset, row.typeInfo->alignment);
         row.offset = static_cast<uint32>(offset);
         row.width = static_cast<uint16>(row.typeInfo->size);
+        row.versionOffset = static_cast<uint16>(versionOffset);
 
         offset += row.width * archData.maxEntitiesPerChunk;
-        UP_ASSERT(offset <= sizeof(Chunk::payload));
+        versionOffset += sizeof(uint32);
+        UP_ASSERT(offset <= versionsOffset);
     }
 
     // sort all rows by component id in the new layout, so we can use binary search for
@@ -165,5 +549,181 @@ auto up::EcsSharedContext::acquireArchetype(
     //
     sort(newLayout, {}, &LayoutRow::component);
 
+    for (LayoutRow const& row : newLayout) {
+        archData.components.set(static_cast<size_t>(indexOfComponent(row.component)));
+    }
+
+    ArchetypeId const id = _publishArchetype(std::move(archData));
+
+    // lookups only find the original of a promoted variant, and then follow it to the variant
+    //
+    if (promoted) {
+        _nextWithSignature.push_back(ArchetypeId::Empty);
+    }
+    else {
+        _indexArchetype(signature, id);
+    }
+
     return id;
 }
+
+void up::EcsSharedContext::_indexArchetype(uint64 signature, ArchetypeId archetype) {
+    UP_ASSERT(to_underlying(archetype) == _nextWithSignature.size());
+    _nextWithSignature.push_back(ArchetypeId::Empty);
+
+    // colliding archetypes are linked in after the first one indexed with the signature; the empty
+    // archetype is indexed before any other, so it can only head a chain and Empty ends every chain
+    //
+    if (auto const found = _archetypesBySignature.find(signature); found) {
+        ArchetypeId& head = _nextWithSignature[to_underlying(found->value)];
+        _nextWithSignature.back() = head;
+        head = archetype;
+    }
+    else {
+        _archetypesBySignature.insert(signature, archetype);
+    }
+}
+
+auto up::EcsSharedContext::_publishArchetype(ArchetypeLayout layout) -> ArchetypeId {
+    auto const index = _archetypeCount.load(std::memory_order_relaxed);
+    UP_ASSERT(index < archetypesPerPage * maxArchetypePages, "Too many archetypes");
+
+    if (index % archetypesPerPage == 0) {
+        auto& page = _archetypeStorage.emplace_back();
+        page.resize(archetypesPerPage);
+        _archetypePages[index / archetypesPerPage] = page.data();
+    }
+    _archetypePages[index / archetypesPerPage][index % archetypesPerPage] = std::move(layout);
+
+    // readers only look at archetypes below the published count
+    _archetypeCount.store(index + 1, std::memory_order_release);
+    return ArchetypeId(index);
+}
+
+auto up::EcsSharedContext::_internSharedValue(reflex::TypeInfo const& typeInfo, void const* value)
+    -> SharedValue const& {
+    // values are identified by their binary encoding, so that equal values share a single copy
+    //
+    vector<byte> encoding;
+    [[maybe_unused]] bool const encoded = reflex::encodeToBinaryRaw(encoding, *typeInfo.schema, value);
+    UP_ASSERT(encoded, "Shared component value could not be encoded");
+
+    default_hash hasher;
+    hasher.append_bytes(reinterpret_cast<char const*>(encoding.data()), encoding.size());
+    uint64 const hash = hash_combine(typeInfo.hash, static_cast<uint64>(hasher.finalize()));
+
+    auto const matches = [&typeInfo, &encoding](SharedValue const& shared) noexcept {
+        return shared.typeInfo == &typeInfo && shared.encoding.size() == encoding.size() &&
+            std::memcmp(shared.encoding.data(), encoding.data(), encoding.size()) == 0;
+    };
+
+    // values whose hashes collide are chained from the first value indexed with the hash
+    //
+    auto const found = _sharedValuesByHash.find(hash);
+    for (uint32 index = found ? found->value : noSharedValue; index != noSharedValue;
+         index = _sharedValues[index]->nextWithHash) {
+        if (matches(*_sharedValues[index])) {
+            return *_sharedValues[index];
+        }
+    }
+
+    void* const data = allocateValue(typeInfo);
+    typeInfo.ops.copyConstructor(data, value);
+
+    auto const index = static_cast<uint32>(_sharedValues.size());
+    _sharedValues.push_back(new_box<SharedValue>(SharedValue{&typeInfo, data, std::move(encoding)}));
+    _sharedValuesByData.insert(reinterpret_cast<uintptr>(data), index);
+    if (found) {
+        uint32& head = _sharedValues[found->value]->nextWithHash;
+        _sharedValues.back()->nextWithHash = head;
+        head = index;
+    }
+    else {
+        _sharedValuesByHash.insert(hash, index);
+    }
+    return *_sharedValues.back();
+}
+
+void up::EcsSharedContext::_retainArchetype(ArchetypeId archetype) {
+    LockGuard _(_archetypeLock);
+
+    auto const archIndex = to_underlying(archetype);
+    if (archIndex >= _liveChunks.size()) {
+        _liveChunks.resize(archIndex + 1, 0);
+    }
+    uint32 const liveChunks = ++_liveChunks[archIndex];
+
+    ArchetypeLayout const& layout = archetypeLayout(archetype);
+    if (liveChunks == promoteAfterChunks && layout.sizeClass != layout.preferredSizeClass) {
+        _promoteArchetype(archetype);
+    }
+    if (liveChunks != 1 || !layout.hasSharedValues) {
+        return;
+    }
+
+    // a released value is rebuilt from its encoding before any chunk can expose it again
+    //
+    for (LayoutRow const& row : layoutOf(archetype)) {
+        if (row.sharedValue == nullptr) {
+            continue;
+        }
+        auto const found = _sharedValuesByData.find(reinterpret_cast<uintptr>(row.sharedValue));
+        UP_ASSERT(found);
+        SharedValue& shared = *_sharedValues[found->value];
+        if (shared.liveArchetypes++ != 0 || shared.constructed) {
+            continue;
+        }
+
+        shared.typeInfo->ops.defaultConstructor(shared.data);
+        view<byte> encoding = shared.encoding;
+        [[maybe_unused]] bool const decoded =
+            reflex::decodeFromBinaryRaw(encoding, *shared.typeInfo->schema, shared.data);
+        UP_ASSERT(decoded, "Shared component value could not be decoded");
+        shared.constructed = true;
+    }
+}
+
+void up::EcsSharedContext::_releaseArchetype(ArchetypeId archetype) noexcept {
+    LockGuard _(_archetypeLock);
+
+    auto const archIndex = to_underlying(archetype);
+    UP_ASSERT(archIndex < _liveChunks.size() && _liveChunks[archIndex] != 0);
+    if (--_liveChunks[archIndex] != 0 || !archetypeLayout(archetype).hasSharedValues) {
+        return;
+    }
+
+    for (LayoutRow const& row : layoutOf(archetype)) {
+        if (row.sharedValue == nullptr) {
+            continue;
+        }
+        auto const found = _sharedValuesByData.find(reinterpret_cast<uintptr>(row.sharedValue));
+        UP_ASSERT(found);
+        SharedValue& shared = *_sharedValues[found->value];
+        if (--shared.liveArchetypes == 0) {
+            shared.typeInfo->ops.destructor(shared.data);
+            shared.constructed = false;
+        }
+    }
+}
+
+void up::EcsSharedContext::_promoteArchetype(ArchetypeId archetype) {
+    auto const archIndex = to_underlying(archetype);
+    if (archIndex < _promotedTo.size() && _promotedTo[archIndex] != ArchetypeId::Empty) {
+        return;
+    }
+
+    ArchetypeId const variant = _createArchetype(0, layoutOf(archetype), true);
+
+    if (archIndex >= _promotedTo.size()) {
+        _promotedTo.resize(archIndex + 1, ArchetypeId::Empty);
+    }
+    _promotedTo[archIndex] = variant;
+}
+
+auto up::EcsSharedContext::_defaultSharedValue(reflex::TypeInfo const& typeInfo) -> SharedValue const& {
+    void* const data = allocateValue(typeInfo);
+    typeInfo.ops.defaultConstructor(data);
+    SharedValue const& shared = _internSharedValue(typeInfo, data);
+    freeValue(typeInfo, data);
+    return shared;
+}
@@ -0,0 +1,205 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "system_scheduler.h"
+#include "world.h"
+
+#include "potato/runtime/assertion.h"
+#include "potato/runtime/scheduler.h"
+
+#include <chrono>
+#include <thread>
+
+namespace up {
+    namespace {
+        auto nowNanoseconds() noexcept -> uint64 {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        bool conflicts(view<ComponentAccess> first, view<ComponentAccess> second) noexcept {
+            for (ComponentAccess const& lhs : first) {
+                for (ComponentAccess const& rhs : second) {
+                    if (lhs.component == rhs.component && (lhs.writable || rhs.writable)) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+    } // namespace
+
+    struct SystemScheduler::Node {
+        Node(string name, box<System> system, rc<EcsSharedContext> context)
+            : name(std::move(name))
+            , system(std::move(system))
+            , commands(std::move(context)) {}
+
+        string name;
+        box<System> system;
+        // Systems which must complete before this one may start
+        vector<int> dependencies;
+        // Systems which wait on this one
+        vector<int> dependents;
+        std::atomic<int> remaining = 0;
+        EntityCommandBuffer commands;
+        uint64 start = 0;
+        uint64 end = 0;
+    };
+} // namespace up
+
+up::SystemScheduler::SystemScheduler(rc<EcsSharedContext> context, Scheduler& scheduler)
+    : _context(std::move(context))
+    , _scheduler(scheduler) {}
+
+up::SystemScheduler::~SystemScheduler() = default;
+
+void up::SystemScheduler::_addSystem(string name, box<System> system) {
+    UP_ASSERT(_world == nullptr, "Systems cannot be added while the SystemScheduler is running");
+
+    _nodes.push_back(new_box<Node>(std::move(name), std::move(system), _context));
+    _built = false;
+}
+
+void up::SystemScheduler::run(World& world) {
+    _build();
+
+    if (_nodes.empty()) {
+        _timings.clear();
+        _frameNanoseconds = _criticalPathNanoseconds = 0;
+        return;
+    }
+
+    _world = &world;
+    _pending.store(static_cast<int>(_nodes.size()), std::memory_order_relaxed);
+    for (box<Node>& node : _nodes) {
+        node->remaining.store(static_cast<int>(node->dependencies.size()), std::memory_order_relaxed);
+    }
+
+    _frameStart = nowNanoseconds();
+
+    // every System without dependencies may start immediately; the calling thread
+    // takes the first of them and hands the remainder to the workers
+    int first = -1;
+    for (int index = 0; index != static_cast<int>(_nodes.size()); ++index) {
+        if (!_nodes[index]->dependencies.empty()) {
+            continue;
+        }
+        if (first == -1) {
+            first = index;
+        }
+        else {
+            _scheduler.submit([this, index] { _execute(index); });
+        }
+    }
+    _execute(first);
+
+    while (_pending.load(std::memory_order_acquire) != 0) {
+        if (!_scheduler.tryRunPending()) {
+            std::this_thread::yield();
+        }
+    }
+
+    _frameNanoseconds = nowNanoseconds() - _frameStart;
+    _world = nullptr;
+
+    _computeCriticalPath();
+
+    for (box<Node>& node : _nodes) {
+        if (!node->commands.empty()) {
+            node->commands.playback(world);
+        }
+    }
+}
+
+void up::SystemScheduler::_build() {
+    if (_built) {
+        return;
+    }
+
+    for (box<Node>& node : _nodes) {
+        node->dependencies.clear();
+        node->dependents.clear();
+    }
+
+    // conflicting Systems are ordered by registration, so edges only ever point
+    // forward and registration order is always a valid topological order
+    for (int index = 0; index != static_cast<int>(_nodes.size()); ++index) {
+        auto const access = _nodes[index]->system->access();
+        for (int previous = 0; previous != index; ++previous) {
+            if (conflicts(_nodes[previous]->system->access(), access)) {
+                _nodes[index]->dependencies.push_back(previous);
+                _nodes[previous]->dependents.push_back(index);
+            }
+        }
+    }
+
+    _built = true;
+}
+
+void up::SystemScheduler::_execute(int index) {
+    while (index != -1) {
+        Node& node = *_nodes[index];
+
+        node.start = nowNanoseconds();
+        SystemContext context{*_world, _scheduler, node.commands};
+        node.system->run(context);
+        node.end = nowNanoseconds();
+
+        // continue with the first newly-ready dependent on this thread, rather than
+        // round-tripping through the queue, and hand any others to the workers
+        index = -1;
+        for (int const dependent : node.dependents) {
+            if (_nodes[dependent]->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                continue;
+            }
+            if (index == -1) {
+                index = dependent;
+            }
+            else {
+                _scheduler.submit([this, dependent] { _execute(dependent); });
+            }
+        }
+
+        _pending.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void up::SystemScheduler::_computeCriticalPath() {
+    auto const count = _nodes.size();
+
+    _timings.resize(count);
+
+    // longest chain of durations ending at each System, and the dependency it came through
+    vector<uint64> finish(count, 0);
+    vector<int> through(count, -1);
+
+    size_t last = 0;
+    for (size_t index = 0; index != count; ++index) {
+        Node const& node = *_nodes[index];
+        SystemTiming& timing = _timings[index];
+
+        timing.name = node.name;
+        timing.startNanoseconds = node.start - _frameStart;
+        timing.durationNanoseconds = node.end - node.start;
+        timing.critical = false;
+
+        uint64 longest = 0;
+        for (int const dependency : node.dependencies) {
+            if (finish[dependency] > longest) {
+                longest = finish[dependency];
+                through[index] = dependency;
+            }
+        }
+        finish[index] = longest + timing.durationNanoseconds;
+
+        if (finish[index] > finish[last]) {
+            last = index;
+        }
+    }
+
+    _criticalPathNanoseconds = finish[last];
+    for (int index = static_cast<int>(last); index != -1; index = through[index]) {
+        _timings[index].critical = true;
+    }
+}
@@ -0,0 +1,108 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "transforms.h"
+
+#include "potato/runtime/assertion.h"
+#include "potato/spud/platform.h"
+
+#include <glm/gtx/transform.hpp>
+#include <cstddef>
+
+#if UP_ARCH_INTEL
+#    include <xmmintrin.h>
+#endif
+
+void up::composeTransforms(
+    span<glm::vec3 const> positions,
+    span<glm::quat const> rotations,
+    span<glm::mat4x4> out) noexcept {
+    UP_ASSERT(positions.size() == out.size() && rotations.size() == out.size());
+
+    size_t index = 0;
+
+#if UP_ARCH_INTEL
+    static_assert(sizeof(glm::vec3) == 12 && sizeof(glm::quat) == 16 && sizeof(glm::mat4x4) == 64);
+    static_assert(offsetof(glm::quat, x) == 0 && offsetof(glm::quat, w) == 12, "Quaternions must be stored xyzw");
+
+    // four entities at a time, one per lane; the split sub-columns make each load a contiguous run
+    auto const* const pos = reinterpret_cast<float const*>(positions.data());
+    auto const* const rot = reinterpret_cast<float const*>(rotations.data());
+    auto* const mat = reinterpret_cast<float*>(out.data());
+    __m128 const zero = _mm_setzero_ps();
+    __m128 const one = _mm_set1_ps(1.f);
+    __m128 const two = _mm_set1_ps(2.f);
+    for (; index + 4 <= out.size(); index += 4) {
+        // deinterleave x0y0z0x1 y1z1x2y2 z2x3y3z3 into a register per axis
+        __m128 const p0 = _mm_loadu_ps(pos + index * 3);
+        __m128 const p1 = _mm_loadu_ps(pos + index * 3 + 4);
+        __m128 const p2 = _mm_loadu_ps(pos + index * 3 + 8);
+        __m128 const xy23 = _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(2, 1, 3, 2));
+        __m128 const yz01 = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(1, 0, 2, 1));
+        __m128 px = _mm_shuffle_ps(p0, xy23, _MM_SHUFFLE(2, 0, 3, 0));
+        __m128 py = _mm_shuffle_ps(yz01, xy23, _MM_SHUFFLE(3, 1, 2, 0));
+        __m128 pz = _mm_shuffle_ps(yz01, p2, _MM_SHUFFLE(3, 0, 3, 1));
+        __m128 pw = one;
+
+        __m128 qx = _mm_loadu_ps(rot + index * 4);
+        __m128 qy = _mm_loadu_ps(rot + index * 4 + 4);
+        __m128 qz = _mm_loadu_ps(rot + index * 4 + 8);
+        __m128 qw = _mm_loadu_ps(rot + index * 4 + 12);
+        _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+        // same terms as glm::mat4_cast
+        __m128 const x2 = _mm_mul_ps(qx, two);
+        __m128 const y2 = _mm_mul_ps(qy, two);
+        __m128 const z2 = _mm_mul_ps(qz, two);
+        __m128 const xx = _mm_mul_ps(qx, x2);
+        __m128 const yy = _mm_mul_ps(qy, y2);
+        __m128 const zz = _mm_mul_ps(qz, z2);
+        __m128 const xy = _mm_mul_ps(qx, y2);
+        __m128 const xz = _mm_mul_ps(qx, z2);
+        __m128 const yz = _mm_mul_ps(qy, z2);
+        __m128 const wx = _mm_mul_ps(qw, x2);
+        __m128 const wy = _mm_mul_ps(qw, y2);
+        __m128 const wz = _mm_mul_ps(qw, z2);
+
+        __m128 m00 = _mm_sub_ps(one, _mm_add_ps(yy, zz));
+        __m128 m01 = _mm_add_ps(xy, wz);
+        __m128 m02 = _mm_sub_ps(xz, wy);
+        __m128 m03 = zero;
+        __m128 m10 = _mm_sub_ps(xy, wz);
+        __m128 m11 = _mm_sub_ps(one, _mm_add_ps(xx, zz));
+        __m128 m12 = _mm_add_ps(yz, wx);
+        __m128 m13 = zero;
+        __m128 m20 = _mm_add_ps(xz, wy);
+        __m128 m21 = _mm_sub_ps(yz, wx);
+        __m128 m22 = _mm_sub_ps(one, _mm_add_ps(xx, yy));
+        __m128 m23 = zero;
+
+        // translating a rotation only replaces its last column with the position
+        _MM_TRANSPOSE4_PS(m00, m01, m02, m03);
+        _MM_TRANSPOSE4_PS(m10, m11, m12, m13);
+        _MM_TRANSPOSE4_PS(m20, m21, m22, m23);
+        _MM_TRANSPOSE4_PS(px, py, pz, pw);
+
+        float* const dest = mat + index * 16;
+        _mm_storeu_ps(dest + 0, m00);
+        _mm_storeu_ps(dest + 4, m10);
+        _mm_storeu_ps(dest + 8, m20);
+        _mm_storeu_ps(dest + 12, px);
+        _mm_storeu_ps(dest + 16, m01);
+        _mm_storeu_ps(dest + 20, m11);
+        _mm_storeu_ps(dest + 24, m21);
+        _mm_storeu_ps(dest + 28, py);
+        _mm_storeu_ps(dest + 32, m02);
+        _mm_storeu_ps(dest + 36, m12);
+        _mm_storeu_ps(dest + 40, m22);
+        _mm_storeu_ps(dest + 44, pz);
+        _mm_storeu_ps(dest + 48, m03);
+        _mm_storeu_ps(dest + 52, m13);
+        _mm_storeu_ps(dest + 56, m23);
+        _mm_storeu_ps(dest + 60, pw);
+    }
+#endif
+
+    for (; index != out.size(); ++index) {
+        out[index] = glm::translate(positions[index]) * glm::mat4_cast(rotations[index]);
+    }
+}
@@ -13,7 +13,6 @@ auto up::Universe::findComponentByName(string_view name) const noexcept -> refle
     return _context->findComponentByName(name);
 }
 
-void up::Universe::_registerComponent(reflex::TypeInfo const& typeInfo) {
-    UP_ASSERT(_context->_findComponentByTypeHash(typeInfo.hash) == nullptr);
-    _context->components.push_back(&typeInfo);
+void up::Universe::_registerComponent(reflex::TypeInfo const& typeInfo, bool shared) {
+    _context->registerComponent(typeInfo, shared);
 }
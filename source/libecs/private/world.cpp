@@ -5,10 +5,14 @@
 #include "shared_context.h"
 
 #include "potato/runtime/assertion.h"
+#include "potato/runtime/lock_guard.h"
+#include "potato/spud/erase.h"
 #include "potato/spud/find.h"
 #include "potato/spud/sequence.h"
 
 #include <algorithm>
+#include <cstring>
+#include <utility>
 
 namespace up {
     static auto findRowDesc(view<LayoutRow> layout, ComponentId component) noexcept -> LayoutRow const* {
@@ -19,19 +23,139 @@ namespace up {
         }
         return nullptr;
     }
+
+    static auto nextWorldSerial() noexcept -> uint64 {
+        static std::atomic<uint64> serial = 0;
+        return serial.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    // split rows have no contiguous elements; see gatherSplitElement and scatterSplitElement
+    static auto elementAt(LayoutRow const& row, Chunk& chunk, size_t index) noexcept -> char* {
+        UP_ASSERT(!row.split());
+        return chunk.payload + row.offset + row.width * index;
+    }
+
+    // moves consecutive components of a row to new memory, leaving nothing behind to destroy
+    static void relocateRow(
+        LayoutRow const& toRow,
+        Chunk& to,
+        size_t toIndex,
+        LayoutRow const& fromRow,
+        Chunk& from,
+        size_t fromIndex,
+        size_t count) noexcept {
+        if (!toRow.stored()) {
+            return;
+        }
+
+        // split components are trivially copyable, so each sub-column moves as a single block
+        if (toRow.split()) {
+            for (SplitField const& field : toRow.fields) {
+                std::memcpy(
+                    to.payload + splitFieldOffset(toRow, field, to.header.capacity) + field.width * toIndex,
+                    from.payload + splitFieldOffset(fromRow, field, from.header.capacity) + field.width * fromIndex,
+                    field.width * count);
+            }
+            return;
+        }
+
+        char* const target = elementAt(toRow, to, toIndex);
+        char* const source = elementAt(fromRow, from, fromIndex);
+        if (toRow.typeInfo->triviallyRelocatable) {
+            std::memcpy(target, source, toRow.width * count);
+            return;
+        }
+        for (size_t index = 0; index != count; ++index) {
+            toRow.typeInfo->ops.relocator(target + toRow.width * index, source + toRow.width * index);
+        }
+    }
+
+    static void destroyRow(LayoutRow const& row, Chunk& chunk, size_t first, size_t count) noexcept {
+        if (!row.stored() || row.typeInfo->triviallyDestructible) {
+            return;
+        }
+        char* const data = elementAt(row, chunk, first);
+        for (size_t index = 0; index != count; ++index) {
+            row.typeInfo->ops.destructor(data + row.width * index);
+        }
+    }
+
+    // constructs an element in an uninitialized slot, from a value or by default when there is none
+    static void constructElement(LayoutRow const& row, Chunk& chunk, size_t index, void const* value) {
+        if (!row.stored()) {
+            return;
+        }
+        if (row.split()) {
+            alignas(std::max_align_t) char temp[maxSplitComponentSize];
+            if (value == nullptr) {
+                row.typeInfo->ops.defaultConstructor(temp);
+                value = temp;
+            }
+            scatterSplitElement(row, chunk.payload, chunk.header.capacity, index, value);
+            return;
+        }
+        if (value == nullptr) {
+            row.typeInfo->ops.defaultConstructor(elementAt(row, chunk, index));
+            return;
+        }
+        row.typeInfo->ops.copyConstructor(elementAt(row, chunk, index), value);
+    }
+
+    static void assignElement(LayoutRow const& row, Chunk& chunk, size_t index, void const* value) {
+        if (!row.stored()) {
+            return;
+        }
+        if (row.split()) {
+            scatterSplitElement(row, chunk.payload, chunk.header.capacity, index, value);
+            return;
+        }
+        row.typeInfo->ops.copyAssignment(elementAt(row, chunk, index), value);
+    }
 } // namespace up
 
-up::World::World(rc<EcsSharedContext> context) : _context(std::move(context)) {}
+up::World::World(rc<EcsSharedContext> context) : _serial(nextWorldSerial()), _context(std::move(context)) {}
+
+up::World::World(World const& source)
+    : _chunkCount(source._chunkCount)
+    , _mappingCount(source._mappingCount)
+    , _freeEntityHead(source._freeEntityHead)
+    , _version(source._version.load(std::memory_order_relaxed))
+    , _serial(nextWorldSerial())
+    , _context(source._context) {
+    _mappingPages.reserve(source._mappingPages.size());
+    for (box<MappingPage> const& page : source._mappingPages) {
+        _mappingPages.push_back(new_box<MappingPage>(*page));
+    }
 
-up::World::~World() = default;
+    _archetypeChunks.reserve(source._archetypeChunks.size());
+    for (ArchetypeChunks const& sourceData : source._archetypeChunks) {
+        ArchetypeChunks& data = _archetypeChunks.emplace_back();
+        data.chunks.reserve(sourceData.chunks.size());
+        for (Chunk* const chunk : sourceData.chunks) {
+            std::atomic_ref<uint32>(chunk->header.references).fetch_add(1, std::memory_order_relaxed);
+            data.chunks.push_back(chunk);
+        }
+        data.available.reserve(sourceData.available.size());
+        for (uint32 const chunkIndex : sourceData.available) {
+            data.available.push_back(chunkIndex);
+        }
+        data.availableSlots.reserve(sourceData.availableSlots.size());
+        for (uint32 const slot : sourceData.availableSlots) {
+            data.availableSlots.push_back(slot);
+        }
+    }
+}
+
+up::World::~World() {
+    _clear();
+}
 
 auto up::World::chunksOf(ArchetypeId arch) const noexcept -> view<Chunk*> {
     auto const archIndex = to_underlying(arch);
-    if (archIndex < 0 || archIndex >= _archetypeChunkRanges.size()) {
+    if (archIndex >= _archetypeChunks.size()) {
         return {};
     }
-    auto const& range = _archetypeChunkRanges[archIndex];
-    return _chunks.subspan(range.offset, range.length);
+    return _archetypeChunks[archIndex].chunks;
 }
 
 void* up::World::getComponentSlowUnsafe(EntityId entity, ComponentId component) noexcept {
@@ -39,41 +163,124 @@ void* up::World::getComponentSlowUnsafe(EntityId entity, ComponentId component)
         auto const layout = _context->layoutOf(archetypeId);
 
         if (auto const row = findRowDesc(layout, component); row != nullptr) {
-            auto& chunk = *_getChunk(archetypeId, chunkIndex);
+            // shared values are interned and held by many entities, and split components have
+            // no contiguous value, so neither has a pointer that may be written through
+            if (row->sharedValue != nullptr || row->split()) {
+                return nullptr;
+            }
+
+            auto& chunk = *_writableChunk(archetypeId, chunkIndex);
+            // the caller may write through the pointer, so the row must be considered modified
+            if (!row->tag) {
+                chunk.rowVersion(row->versionOffset) = advanceVersion();
+            }
             return chunk.payload + row->offset + row->width * index;
         }
     }
     return nullptr;
 }
 
+bool up::World::hasComponent(EntityId entity, ComponentId component) const noexcept {
+    if (auto [success, archetypeId, chunkIndex, index] = _parseEntityId(entity); success) {
+        return findRowDesc(_context->layoutOf(archetypeId), component) != nullptr;
+    }
+    return false;
+}
+
+auto up::World::archetypeOf(EntityId entity) const noexcept -> ArchetypeId {
+    auto const location = _parseEntityId(entity);
+    return location.success ? location.archetype : ArchetypeId::Empty;
+}
+
+void const* up::World::readComponentSlowUnsafe(EntityId entity, ComponentId component) const noexcept {
+    if (auto [success, archetypeId, chunkIndex, index] = _parseEntityId(entity); success) {
+        if (auto const row = findRowDesc(_context->layoutOf(archetypeId), component); row != nullptr) {
+            if (row->sharedValue != nullptr) {
+                return row->sharedValue;
+            }
+            if (row->split()) {
+                return nullptr;
+            }
+            return _getChunk(archetypeId, chunkIndex)->payload + row->offset + row->width * index;
+        }
+    }
+    return nullptr;
+}
+
+void const* up::World::readFieldSlowUnsafe(EntityId entity, ComponentId component, size_t offset) const noexcept {
+    if (auto [success, archetypeId, chunkIndex, index] = _parseEntityId(entity); success) {
+        if (auto const row = findRowDesc(_context->layoutOf(archetypeId), component); row != nullptr) {
+            if (row->sharedValue != nullptr) {
+                return static_cast<char const*>(row->sharedValue) + offset;
+            }
+
+            Chunk const& chunk = *_getChunk(archetypeId, chunkIndex);
+            if (!row->split()) {
+                return chunk.payload + row->offset + row->width * index + offset;
+            }
+
+            // the offset may also fall inside a field, e.g. for a member of a nested struct
+            for (SplitField const& field : row->fields) {
+                if (offset >= field.offset && offset < field.offset + field.width) {
+                    return chunk.payload + splitFieldOffset(*row, field, chunk.header.capacity) +
+                        field.width * index + (offset - field.offset);
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
 void up::World::deleteEntity(EntityId entity) noexcept {
     auto [success, archetypeId, chunkIndex, index] = _parseEntityId(entity);
     if (success) {
         _deleteEntityData(archetypeId, chunkIndex, index);
         _recycleEntityId(entity);
+        _recordChange(archetypeId, ArchetypeId::Empty, {&entity, 1}, true);
+    }
+}
+
+void up::World::_deleteEntityData(ArchetypeId archetypeId, uint32 chunkIndex, uint16 index) noexcept {
+    // if this is the last entity, let go of the whole chunk; a shared chunk need not be copied first
+    //
+    if (Chunk* const chunk = _getChunk(archetypeId, chunkIndex); chunk->header.entities == 1) {
+        _removeChunk(archetypeId, chunkIndex);
+        _releaseChunk(chunk);
+        return;
     }
+
+    Chunk* const chunk = _writableChunk(archetypeId, chunkIndex);
+    _destroyAt(archetypeId, *chunk, index);
+    _vacateEntityData(archetypeId, chunkIndex, index);
 }
 
-void up::World::_deleteEntityData(ArchetypeId archetypeId, uint16 chunkIndex, uint16 index) noexcept {
-    Chunk* chunk = _getChunk(archetypeId, chunkIndex);
+void up::World::_vacateEntityData(ArchetypeId archetypeId, uint32 chunkIndex, uint16 index) noexcept {
+    // the slot's components are already gone, so the caller must have made the chunk writable
+    Chunk* const chunk = _getChunk(archetypeId, chunkIndex);
+    UP_ASSERT(chunk->header.references == 1);
+
+    auto const lastIndex = static_cast<uint16>(chunk->header.entities - 1);
+    if (lastIndex == 0) {
+        chunk->header.entities = 0;
+        _removeChunk(archetypeId, chunkIndex);
+        _releaseChunk(chunk);
+        return;
+    }
 
-    // Copy the last element over the to-be-removed element, so we don't have holes in our array
+    // Relocate the last element into the vacated slot, so we don't have holes in our array
     //
-    auto const lastIndex = static_cast<int>(chunk->header.entities - 1);
-    if (static_cast<int>(index) != lastIndex) {
+    if (index != lastIndex) {
         auto const movedEntity = chunk->entities()[index] = chunk->entities()[lastIndex];
-        _moveTo(archetypeId, *chunk, index, *chunk, lastIndex);
+        for (LayoutRow const& row : _context->layoutOf(archetypeId)) {
+            relocateRow(row, *chunk, index, row, *chunk, lastIndex, 1);
+        }
         _remapEntityId(movedEntity, archetypeId, chunkIndex, index);
     }
 
-    _destroyAt(archetypeId, *chunk, lastIndex);
+    --chunk->header.entities;
 
-    // if this was the last entity, deallocate the whole chunk
-    //
-    if (--chunk->header.entities == 0) {
-        _removeChunk(archetypeId, chunkIndex);
-        _context->recycleChunk(chunk);
-    }
+    _markChanged(archetypeId, *chunk);
+    _updateAvailability(archetypeId, chunkIndex);
 }
 
 void up::World::removeComponent(EntityId entityId, ComponentId componentId) noexcept {
@@ -81,33 +288,52 @@ void up::World::removeComponent(EntityId entityId, ComponentId componentId) noex
     UP_ASSERT(typeInfo != nullptr);
 
     if (auto [success, archetypeId, chunkIndex, index] = _parseEntityId(entityId); success) {
-        ArchetypeId newArchetype = _context->acquireArchetype(archetypeId, {}, {&typeInfo, 1});
-        auto [newChunk, newChunkIndex, newIndex] = _allocateEntitySpace(newArchetype);
+        auto const edge = _context->acquireRemoveEdge(archetypeId, *typeInfo);
+        if (edge.target == archetypeId) {
+            return;
+        }
+        auto [newChunk, newChunkIndex, newIndex] = _allocateEntitySpace(edge.target);
 
-        auto* oldChunk = _getChunk(archetypeId, chunkIndex);
-        _moveTo(newArchetype, newChunk, newIndex, archetypeId, *oldChunk, index);
+        auto* oldChunk = _writableChunk(archetypeId, chunkIndex);
+        _relocateTo(_context->rowMapOf(edge), edge.target, newChunk, newIndex, archetypeId, *oldChunk, index);
 
         newChunk.entities()[newIndex] = entityId;
 
-        _deleteEntityData(archetypeId, chunkIndex, index);
-        _remapEntityId(entityId, newArchetype, newChunkIndex, newIndex);
+        _vacateEntityData(archetypeId, chunkIndex, index);
+        _remapEntityId(entityId, edge.target, newChunkIndex, newIndex);
+        _recordChange(archetypeId, edge.target, {&entityId, 1});
     }
 }
 
 void* up::World::addComponentDefault(EntityId entityId, reflex::TypeInfo const& typeInfo) {
     if (auto [success, archetypeId, chunkIndex, index] = _parseEntityId(entityId); success) {
         // find the target archetype and allocate an entry in it
-        reflex::TypeInfo const* infoPtr = &typeInfo;
-        ArchetypeId newArchetype = _context->acquireArchetype(archetypeId, {&infoPtr, 1}, {});
-        auto [newChunk, newChunkIndex, newIndex] = _allocateEntitySpace(newArchetype);
+        auto const edge = _context->acquireAddEdge(archetypeId, typeInfo);
+        auto const component = static_cast<ComponentId>(typeInfo.hash);
+        if (edge.target == archetypeId) {
+            // a shared component is reset by moving to the archetype holding its default value
+            auto const row = findRowDesc(_context->layoutOf(archetypeId), component);
+            if (row->sharedValue != nullptr) {
+                removeComponent(entityId, component);
+                return addComponentDefault(entityId, typeInfo);
+            }
+
+            // the component is already present, so it is reset in place
+            Chunk& chunk = *_writableChunk(archetypeId, chunkIndex);
+            destroyRow(*row, chunk, index, 1);
+            _markChanged(archetypeId, chunk);
+            return _constructAt(archetypeId, chunk, index, component);
+        }
+        auto [newChunk, newChunkIndex, newIndex] = _allocateEntitySpace(edge.target);
 
-        auto* chunk = _getChunk(archetypeId, chunkIndex);
+        auto* chunk = _writableChunk(archetypeId, chunkIndex);
         newChunk.entities()[newIndex] = entityId;
-        _moveTo(newArchetype, newChunk, newIndex, archetypeId, *chunk, index);
-        void* const data = _constructAt(newArchetype, newChunk, newIndex, static_cast<ComponentId>(typeInfo.hash));
+        _relocateTo(_context->rowMapOf(edge), edge.target, newChunk, newIndex, archetypeId, *chunk, index);
+        void* const data = _constructAt(edge.target, newChunk, newIndex, component);
 
-        _deleteEntityData(archetypeId, chunkIndex, index);
-        _remapEntityId(entityId, newArchetype, newChunkIndex, newIndex);
+        _vacateEntityData(archetypeId, chunkIndex, index);
+        _remapEntityId(entityId, edge.target, newChunkIndex, newIndex);
+        _recordChange(archetypeId, edge.target, {&entityId, 1});
 
         return data;
     }
@@ -119,25 +345,81 @@ void up::World::_addComponentRaw(
     reflex::TypeInfo const& typeInfo,
     void const* componentData) noexcept {
     if (auto [success, archetypeId, chunkIndex, index] = _parseEntityId(entityId); success) {
+        auto const component = static_cast<ComponentId>(typeInfo.hash);
+
+        // a shared component's value selects the archetype, so adding or replacing it moves the entity
+        if (_context->isSharedComponent(component)) {
+            auto const edge = _context->acquireSharedEdge(archetypeId, typeInfo, componentData);
+            if (edge.target == archetypeId) {
+                return;
+            }
+            auto [newChunk, newChunkIndex, newIndex] = _allocateEntitySpace(edge.target);
+
+            auto* chunk = _writableChunk(archetypeId, chunkIndex);
+            newChunk.entities()[newIndex] = entityId;
+            _relocateTo(_context->rowMapOf(edge), edge.target, newChunk, newIndex, archetypeId, *chunk, index);
+
+            _vacateEntityData(archetypeId, chunkIndex, index);
+            _remapEntityId(entityId, edge.target, newChunkIndex, newIndex);
+            _recordChange(archetypeId, edge.target, {&entityId, 1});
+            return;
+        }
+
         // find the target archetype and allocate an entry in it
-        reflex::TypeInfo const* infoPtr = &typeInfo;
-        ArchetypeId newArchetype = _context->acquireArchetype(archetypeId, {&infoPtr, 1}, {});
-        auto [newChunk, newChunkIndex, newIndex] = _allocateEntitySpace(newArchetype);
+        auto const edge = _context->acquireAddEdge(archetypeId, typeInfo);
+        if (edge.target == archetypeId) {
+            // the component is already present, so only its value is replaced
+            Chunk& chunk = *_writableChunk(archetypeId, chunkIndex);
+            auto const row = findRowDesc(_context->layoutOf(archetypeId), component);
+            assignElement(*row, chunk, index, componentData);
+            _markChanged(archetypeId, chunk);
+            return;
+        }
+        auto [newChunk, newChunkIndex, newIndex] = _allocateEntitySpace(edge.target);
 
-        auto* chunk = _getChunk(archetypeId, chunkIndex);
+        auto* chunk = _writableChunk(archetypeId, chunkIndex);
         newChunk.entities()[newIndex] = entityId;
-        _moveTo(newArchetype, newChunk, newIndex, archetypeId, *chunk, index);
-        _copyTo(newArchetype, newChunk, newIndex, static_cast<ComponentId>(typeInfo.hash), componentData);
+        _relocateTo(_context->rowMapOf(edge), edge.target, newChunk, newIndex, archetypeId, *chunk, index);
+        _copyTo(edge.target, newChunk, newIndex, component, componentData);
 
-        _deleteEntityData(archetypeId, chunkIndex, index);
-        _remapEntityId(entityId, newArchetype, newChunkIndex, newIndex);
+        _vacateEntityData(archetypeId, chunkIndex, index);
+        _remapEntityId(entityId, edge.target, newChunkIndex, newIndex);
+        _recordChange(archetypeId, edge.target, {&entityId, 1});
     }
 }
 
+auto up::World::_acquireArchetype(view<reflex::TypeInfo const*> components, view<void const*> data) -> ArchetypeId {
+    UP_ASSERT(components.size() == data.size());
+
+    auto const isShared = [this](reflex::TypeInfo const* typeInfo) {
+        return _context->isSharedComponent(static_cast<ComponentId>(typeInfo->hash));
+    };
+    if (!any(components, isShared)) {
+        return _context->acquireArchetype(ArchetypeId::Empty, components, {});
+    }
+
+    // shared components are added one at a time, so that no archetype is created for their default values
+    //
+    vector<reflex::TypeInfo const*> unshared;
+    for (reflex::TypeInfo const* const typeInfo : components) {
+        if (!isShared(typeInfo)) {
+            unshared.push_back(typeInfo);
+        }
+    }
+
+    ArchetypeId archetype = _context->acquireArchetype(ArchetypeId::Empty, unshared, {});
+    for (auto index : sequence(components.size())) {
+        if (isShared(components[index])) {
+            archetype = _context->acquireSharedEdge(archetype, *components[index], data[index]).target;
+        }
+    }
+    return archetype;
+}
+
 auto up::World::_createEntityRaw(view<reflex::TypeInfo const*> components, view<void const*> data) -> EntityId {
     UP_ASSERT(components.size() == data.size());
 
-    ArchetypeId newArchetype = _context->acquireArchetype(ArchetypeId::Empty, components, {});
+    ArchetypeId newArchetype = _acquireArchetype(components, data);
     auto [newChunk, newChunkIndex, newIndex] = _allocateEntitySpace(newArchetype);
 
     // Allocate EntityId
@@ -148,103 +430,608 @@ auto up::World::_createEntityRaw(view<reflex::TypeInfo const*> components, view<
         _copyTo(newArchetype, newChunk, newIndex, static_cast<ComponentId>(components[index]->hash), data[index]);
     }
 
+    _recordChange(ArchetypeId::Empty, newArchetype, {&entity, 1});
     return entity;
 }
 
-auto up::World::_allocateEntitySpace(ArchetypeId archetype) -> AllocatedLocation {
-    auto const chunks = chunksOf(archetype);
+void up::World::_createEntitiesRaw(
+    view<reflex::TypeInfo const*> components,
+    view<void const*> data,
+    CreateData mode,
+    span<EntityId> outEntities) {
+    UP_ASSERT(
+        mode == CreateData::Gathered ? data.size() == components.size() * outEntities.size()
+                                     : data.size() == components.size());
+
+    if (outEntities.empty()) {
+        return;
+    }
+
+    // only a prototype gives every new entity the same values of shared components
+    UP_ASSERT(
+        mode == CreateData::Prototype ||
+            !any(components,
+                 [this](reflex::TypeInfo const* typeInfo) {
+                     return _context->isSharedComponent(static_cast<ComponentId>(typeInfo->hash));
+                 }),
+        "Shared components can only be given to entities created from a prototype");
+    ArchetypeId const newArchetype = mode == CreateData::Prototype
+        ? _acquireArchetype(components, data)
+        : _context->acquireArchetype(ArchetypeId::Empty, components, {});
+
+    _createEntitiesRaw(newArchetype, components, data, mode, outEntities);
+}
+
+void up::World::_createEntitiesRaw(
+    ArchetypeId newArchetype,
+    view<reflex::TypeInfo const*> components,
+    view<void const*> data,
+    CreateData mode,
+    span<EntityId> outEntities) {
+    UP_ASSERT(
+        mode == CreateData::Gathered ? data.size() == components.size() * outEntities.size()
+                                     : data.size() == components.size());
+
+    if (outEntities.empty()) {
+        return;
+    }
+
+    auto const layout = _context->layoutOf(newArchetype);
+
+    size_t created = 0;
+    while (created != outEntities.size()) {
+        auto [chunk, chunkIndex, first, count] = _allocateEntityRange(newArchetype, outEntities.size() - created);
+
+        EntityId* const entities = chunk.entities().data();
+        for (uint16 index = 0; index != count; ++index) {
+            entities[first + index] = outEntities[created + index] =
+                _allocateEntityId(newArchetype, chunkIndex, first + index);
+        }
+
+        for (auto componentIndex : sequence(components.size())) {
+            auto const component = static_cast<ComponentId>(components[componentIndex]->hash);
+            // the values of shared components are held by the archetype itself
+            LayoutRow const* const row = findRowDesc(layout, component);
+            if (!row->stored()) {
+                continue;
+            }
+            reflex::TypeInfo const& typeInfo = *row->typeInfo;
+
+            // split components are scattered into their sub-columns one entity at a time
+            if (row->split()) {
+                for (uint16 index = 0; index != count; ++index) {
+                    void const* source = data[componentIndex];
+                    if (mode == CreateData::PerEntity) {
+                        source = static_cast<char const*>(source) + typeInfo.size * (created + index);
+                    }
+                    else if (mode == CreateData::Gathered) {
+                        source = data[(created + index) * components.size() + componentIndex];
+                    }
+                    scatterSplitElement(*row, chunk.payload, chunk.header.capacity, first + index, source);
+                }
+                continue;
+            }
+
+            char* const dest = chunk.payload + row->offset + row->width * first;
+
+            switch (mode) {
+                case CreateData::Prototype: {
+                    char const* const source = static_cast<char const*>(data[componentIndex]);
+                    if (typeInfo.triviallyCopyable) {
+                        // seed the first slot, then repeatedly double the initialized region
+                        std::memcpy(dest, source, typeInfo.size);
+                        size_t filled = 1;
+                        while (filled != count) {
+                            size_t const batch = filled < count - filled ? filled : count - filled;
+                            std::memcpy(dest + row->width * filled, dest, row->width * batch);
+                            filled += batch;
+                        }
+                    }
+                    else {
+                        for (uint16 index = 0; index != count; ++index) {
+                            typeInfo.ops.copyConstructor(dest + row->width * index, source);
+                        }
+                    }
+                    break;
+                }
+                case CreateData::PerEntity: {
+                    char const* const source = static_cast<char const*>(data[componentIndex]) + typeInfo.size * created;
+                    if (typeInfo.triviallyCopyable) {
+                        std::memcpy(dest, source, typeInfo.size * count);
+                    }
+                    else {
+                        for (uint16 index = 0; index != count; ++index) {
+                            typeInfo.ops.copyConstructor(dest + row->width * index, source + typeInfo.size * index);
+                        }
+                    }
+                    break;
+                }
+                case CreateData::Gathered:
+                    for (uint16 index = 0; index != count; ++index) {
+                        void const* const source = data[(created + index) * components.size() + componentIndex];
+                        if (typeInfo.triviallyCopyable) {
+                            std::memcpy(dest + row->width * index, source, typeInfo.size);
+                        }
+                        else {
+                            typeInfo.ops.copyConstructor(dest + row->width * index, source);
+                        }
+                    }
+                    break;
+            }
+        }
+
+        created += count;
+    }
+
+    _recordChange(ArchetypeId::Empty, newArchetype, outEntities);
+}
+
+void up::World::_moveEntitiesRaw(
+    ArchetypeId sourceArchetype,
+    ArchetypeId targetArchetype,
+    view<EntityId> entities,
+    view<view<ComponentData>> added) {
+    UP_ASSERT(added.empty() || added.size() == entities.size());
+
+    auto const sourceLayout = _context->layoutOf(sourceArchetype);
+    auto const targetLayout = _context->layoutOf(targetArchetype);
+
+    auto const findAdded = [&added](size_t entityIndex, ComponentId component) -> void const* {
+        if (added.empty()) {
+            return nullptr;
+        }
+        for (ComponentData const& data : added[entityIndex]) {
+            if (static_cast<ComponentId>(data.typeInfo->hash) == component) {
+                return data.data;
+            }
+        }
+        return nullptr;
+    };
+
+    // without an archetype change, only the values of already-present components are replaced
+    //
+    if (sourceArchetype == targetArchetype) {
+        for (auto entityIndex : sequence(entities.size())) {
+            auto const [success, archetype, chunkIndex, index] = _parseEntityId(entities[entityIndex]);
+            UP_ASSERT(success && archetype == sourceArchetype);
+            Chunk* const chunk = _writableChunk(archetype, chunkIndex);
+            for (LayoutRow const& row : targetLayout) {
+                if (void const* const data = findAdded(entityIndex, row.component); data != nullptr) {
+                    assignElement(row, *chunk, index, data);
+                }
+            }
+            _markChanged(archetype, *chunk);
+        }
+        return;
+    }
+
+    // every entity in the batch shares the same pair of layouts, so match up rows once
+    //
+    vector<LayoutRow const*> sourceRows;
+    sourceRows.reserve(targetLayout.size());
+    for (LayoutRow const& row : targetLayout) {
+        sourceRows.push_back(findRowDesc(sourceLayout, row.component));
+    }
+    vector<LayoutRow const*> droppedRows;
+    for (LayoutRow const& row : sourceLayout) {
+        if (findRowDesc(targetLayout, row.component) == nullptr) {
+            droppedRows.push_back(&row);
+        }
+    }
+
+    size_t moved = 0;
+    while (moved != entities.size()) {
+        auto [chunk, chunkIndex, first, count] = _allocateEntityRange(targetArchetype, entities.size() - moved);
+
+        uint16 offset = 0;
+        while (offset != count) {
+            auto const [success, archetype, sourceChunkIndex, sourceFirst] = _parseEntityId(entities[moved + offset]);
+            UP_ASSERT(success && archetype == sourceArchetype);
+
+            // entities stored next to each other in the source are relocated as a single run
+            uint16 run = 1;
+            while (offset + run != count) {
+                auto const next = _parseEntityId(entities[moved + offset + run]);
+                if (next.chunk != sourceChunkIndex || next.index != sourceFirst + run) {
+                    break;
+                }
+                ++run;
+            }
+
+            Chunk* const sourceChunk = _writableChunk(sourceArchetype, sourceChunkIndex);
+            auto const targetFirst = static_cast<uint16>(first + offset);
+            std::memcpy(
+                chunk.entities().data() + targetFirst,
+                sourceChunk->entities().data() + sourceFirst,
+                run * sizeof(EntityId));
+
+            for (auto rowIndex : sequence(targetLayout.size())) {
+                LayoutRow const& row = targetLayout[rowIndex];
+                if (!row.stored()) {
+                    continue;
+                }
+                LayoutRow const* const sourceRow = sourceRows[rowIndex];
+
+                if (sourceRow != nullptr) {
+                    relocateRow(row, chunk, targetFirst, *sourceRow, *sourceChunk, sourceFirst, run);
+                }
+                for (uint16 index = 0; index != run; ++index) {
+                    void const* const data = findAdded(moved + offset + index, row.component);
+                    if (sourceRow == nullptr) {
+                        constructElement(row, chunk, targetFirst + index, data);
+                    }
+                    else if (data != nullptr) {
+                        assignElement(row, chunk, targetFirst + index, data);
+                    }
+                }
+            }
+            for (LayoutRow const* const row : droppedRows) {
+                destroyRow(*row, *sourceChunk, sourceFirst, run);
+            }
+
+            // vacate back to front, so that the rest of the run stays in place until it is reached
+            for (uint16 index = run; index-- != 0;) {
+                _vacateEntityData(sourceArchetype, sourceChunkIndex, sourceFirst + index);
+            }
+            for (uint16 index = 0; index != run; ++index) {
+                _remapEntityId(entities[moved + offset + index], targetArchetype, chunkIndex, targetFirst + index);
+            }
+
+            offset += run;
+        }
+
+        moved += count;
+    }
+
+    _recordChange(sourceArchetype, targetArchetype, entities);
+}
+
+auto up::World::occupancy() const noexcept -> ChunkOccupancy {
+    ChunkOccupancy result;
+    for (ArchetypeChunks const& data : _archetypeChunks) {
+        for (Chunk const* const chunk : data.chunks) {
+            ++result.chunks;
+            result.entities += chunk->header.entities;
+            result.capacity += chunk->header.capacity;
+        }
+    }
+    return result;
+}
+
+auto up::World::compact(size_t budget) -> CompactionResult {
+    CompactionResult result;
+    result.before = occupancy();
+
+    // resume with the archetype a previous call ran out of budget on
+    for (; _compactCursor < _archetypeChunks.size(); ++_compactCursor) {
+        result.movedEntities +=
+            _compactArchetype(static_cast<ArchetypeId>(_compactCursor), budget - result.movedEntities);
+        if (result.movedEntities == budget) {
+            break;
+        }
+    }
+
+    result.complete = _compactCursor == _archetypeChunks.size();
+    if (result.complete) {
+        _compactCursor = 0;
+    }
+
+    result.after = occupancy();
+    return result;
+}
+
+auto up::World::_compactArchetype(ArchetypeId archetype, size_t budget) -> size_t {
+    ArchetypeChunks& data = _archetypeChunks[to_underlying(archetype)];
+    auto const layout = _context->layoutOf(archetype);
+
+    size_t moved = 0;
+    while (moved != budget && data.available.size() >= 2) {
+        // the emptiest chunk is drained into the fullest chunk that still has room
+        uint32 sourceIndex = data.available[0];
+        uint32 targetIndex = data.available[1];
+        size_t freeSlots = 0;
+        for (uint32 const chunkIndex : data.available) {
+            Chunk const* const chunk = data.chunks[chunkIndex];
+            freeSlots += chunk->header.capacity - chunk->header.entities;
+            if (chunk->header.entities < data.chunks[sourceIndex]->header.entities) {
+                sourceIndex = chunkIndex;
+            }
+        }
+        for (uint32 const chunkIndex : data.available) {
+            if (chunkIndex != sourceIndex &&
+                (targetIndex == sourceIndex ||
+                 data.chunks[chunkIndex]->header.entities > data.chunks[targetIndex]->header.entities)) {
+                targetIndex = chunkIndex;
+            }
+        }
+
+        // stop once no amount of shuffling could free up a whole chunk
+        if (freeSlots < data.chunks[targetIndex]->header.capacity) {
+            break;
+        }
+
+        Chunk& source = *_writableChunk(archetype, sourceIndex);
+        Chunk& target = *_writableChunk(archetype, targetIndex);
+
+        auto const room = target.header.capacity - target.header.entities;
+        auto const count = static_cast<uint16>(std::min<size_t>({source.header.entities, room, budget - moved}));
+
+        // take entities from the end of the source chunk, so that no holes are left behind
+        auto const sourceFirst = static_cast<uint16>(source.header.entities - count);
+        auto const targetFirst = static_cast<uint16>(target.header.entities);
+
+        for (LayoutRow const& row : layout) {
+            relocateRow(row, target, targetFirst, row, source, sourceFirst, count);
+        }
+
+        for (uint16 index = 0; index != count; ++index) {
+            EntityId const entity = source.entities()[sourceFirst + index];
+            target.entities()[targetFirst + index] = entity;
+            _remapEntityId(entity, archetype, targetIndex, static_cast<uint16>(targetFirst + index));
+        }
+
+        target.header.entities += count;
+        source.header.entities -= count;
+        moved += count;
+
+        _markChanged(archetype, target);
+        _updateAvailability(archetype, targetIndex);
+
+        if (source.header.entities == 0) {
+            _removeChunk(archetype, sourceIndex);
+            _releaseChunk(&source);
+        }
+    }
+
+    return moved;
+}
+
+void up::World::_clear() noexcept {
+    for (ArchetypeChunks const& archetype : _archetypeChunks) {
+        for (Chunk* const chunk : archetype.chunks) {
+            _releaseChunk(chunk);
+        }
+    }
+
+    _archetypeChunks.clear();
+    _chunkCount = 0;
+    _compactCursor = 0;
+    _mappingPages.clear();
+    _mappingCount = 0;
+    _freeEntityHead = freeEntityIndex;
+}
+
+auto up::World::observeUnsafe(ObserverEvent event, ComponentId component, delegate<void(view<EntityId>)> callback)
+    -> ObserverId {
+    UP_ASSERT(_context->findComponentById(component) != nullptr);
+    UP_ASSERT(callback);
+
+    auto const id = static_cast<ObserverId>(++_nextObserverId);
+    _observers.push_back(new_box<Observer>(Observer{
+        .id = id,
+        .event = event,
+        .component = component,
+        .callback = std::move(callback),
+    }));
+    return id;
+}
+
+void up::World::unobserve(ObserverId observer) noexcept {
+    for (auto index : sequence(_observers.size())) {
+        if (_observers[index]->id != observer) {
+            continue;
+        }
+        // an observer may be removed by a callback, so while notifying it is only marked for removal
+        if (_notifying) {
+            _observers[index]->id = ObserverId::None;
+            _observers[index]->pending.clear();
+        }
+        else {
+            _observers.erase(_observers.begin() + index);
+        }
+        return;
+    }
+}
 
-    for (auto chunkIndex : sequence(chunks.size())) {
-        Chunk* const chunk = chunks[chunkIndex];
-        if (chunk->header.entities < chunk->header.capacity) {
-            uint16 index = chunk->header.entities++;
-            return {*chunk, static_cast<uint16>(chunkIndex), index};
+void up::World::notifyObservers() {
+    if (_notifying) {
+        return;
+    }
+    _notifying = true;
+
+    // observers registered by a callback only hear about later changes
+    vector<EntityId> entities;
+    size_t const count = _observers.size();
+    for (size_t index = 0; index != count; ++index) {
+        Observer& observer = *_observers[index];
+        if (observer.pending.empty()) {
+            continue;
+        }
+        // the recorded entities are swapped out, so callbacks may record new changes
+        entities.clear();
+        std::swap(entities, observer.pending);
+        observer.callback(entities);
+    }
+
+    _notifying = false;
+    erase(_observers, ObserverId::None, [](box<Observer> const& observer) { return observer->id; });
+}
+
+void up::World::_recordChange(ArchetypeId source, ArchetypeId target, view<EntityId> entities, bool deleted) {
+    if (_observers.empty() || entities.empty()) {
+        return;
+    }
+
+    auto const sourceLayout = _context->layoutOf(source);
+    auto const targetLayout = _context->layoutOf(target);
+    for (box<Observer> const& observer : _observers) {
+        bool const before = findRowDesc(sourceLayout, observer->component) != nullptr;
+        bool const after = !deleted && findRowDesc(targetLayout, observer->component) != nullptr;
+
+        bool matched = false;
+        switch (observer->event) {
+            case ObserverEvent::Added:
+                matched = !before && after;
+                break;
+            case ObserverEvent::Removed:
+                matched = before && !after && !deleted;
+                break;
+            case ObserverEvent::Deleted:
+                matched = before && deleted;
+                break;
+        }
+        if (matched && observer->id != ObserverId::None) {
+            observer->pending.insert(observer->pending.end(), entities.begin(), entities.end());
         }
     }
+}
+
+void up::World::_markChanged(ArchetypeId archetype, Chunk& chunk) noexcept {
+    uint32 const version = advanceVersion();
+    for (LayoutRow const& row : _context->layoutOf(archetype)) {
+        if (row.stored()) {
+            chunk.rowVersion(row.versionOffset) = version;
+        }
+    }
+}
+
+auto up::World::_findAvailableChunk(ArchetypeId archetype) -> uint32 {
+    auto const archIndex = to_underlying(archetype);
+    if (archIndex < _archetypeChunks.size() && !_archetypeChunks[archIndex].available.empty()) {
+        return _archetypeChunks[archIndex].available.back();
+    }
+
+    return _addChunk(archetype, _context->acquireChunk(archetype));
+}
+
+void up::World::_updateAvailability(ArchetypeId archetype, uint32 chunkIndex) noexcept {
+    ArchetypeChunks& data = _archetypeChunks[to_underlying(archetype)];
+    Chunk const* const chunk = data.chunks[chunkIndex];
+    _setAvailable(data, chunkIndex, chunk->header.entities < chunk->header.capacity);
+}
+
+void up::World::_setAvailable(ArchetypeChunks& data, uint32 chunkIndex, bool available) noexcept {
+    uint32& slot = data.availableSlots[chunkIndex];
+
+    if (available && slot == notAvailable) {
+        slot = static_cast<uint32>(data.available.size());
+        data.available.push_back(chunkIndex);
+    }
+    else if (!available && slot != notAvailable) {
+        // swap the last available chunk into the vacated slot
+        uint32 const last = data.available.back();
+        data.available[slot] = last;
+        data.availableSlots[last] = slot;
+        data.available.pop_back();
+        slot = notAvailable;
+    }
+}
+
+auto up::World::_allocateEntitySpace(ArchetypeId archetype) -> AllocatedLocation {
+    auto const chunkIndex = _findAvailableChunk(archetype);
+    Chunk* const chunk = _writableChunk(archetype, chunkIndex);
 
-    Chunk* const chunk = _context->acquireChunk();
-    auto const chunkIndex = _addChunk(archetype, chunk);
     uint16 const index = chunk->header.entities++;
+    _updateAvailability(archetype, chunkIndex);
+    _markChanged(archetype, *chunk);
     return {*chunk, chunkIndex, index};
 }
 
-auto up::World::_allocateEntityId(ArchetypeId archetype, uint16 chunk, uint16 index) -> EntityId {
+auto up::World::_allocateEntityRange(ArchetypeId archetype, size_t count) -> AllocatedRange {
+    UP_ASSERT(count != 0);
+
+    auto const chunkIndex = _findAvailableChunk(archetype);
+    Chunk* const chunk = _writableChunk(archetype, chunkIndex);
+
+    auto const available = chunk->header.capacity - chunk->header.entities;
+    auto const allocated = static_cast<uint16>(count < available ? count : available);
+    auto const first = static_cast<uint16>(chunk->header.entities);
+    chunk->header.entities += allocated;
+    _updateAvailability(archetype, chunkIndex);
+    _markChanged(archetype, *chunk);
+    return {*chunk, chunkIndex, first, allocated};
+}
+
+auto up::World::_allocateEntityId(ArchetypeId archetype, uint32 chunk, uint16 index) -> EntityId {
     // if there's a free ID, recycle it
     if (_freeEntityHead != freeEntityIndex) {
         auto const mappingIndex = _freeEntityHead;
-        auto const mapping = _entityMapping[mappingIndex];
-        auto const generation = getMappedGeneration(mapping);
-
-        auto const newGeneration = generation + 1;
+        EntityMapping& mapping = _mappingAt(mappingIndex);
+        auto const nextGeneration = static_cast<uint16>(mapping.generation + 1);
+        auto const newGeneration = nextGeneration != 0 ? nextGeneration : uint16{1};
 
-        _freeEntityHead = getMappedIndex(_entityMapping[mappingIndex]);
+        _freeEntityHead = mapping.chunk;
 
-        _entityMapping[mappingIndex] = makeMapped(newGeneration, to_underlying(archetype), chunk, index);
+        mapping = {to_underlying(archetype), chunk, index, newGeneration};
 
         return makeEntityId(mappingIndex, newGeneration);
     }
 
     // there was no ID to recycle, so create a new one
-    auto const mappingIndex = static_cast<uint32>(_entityMapping.size());
-    _entityMapping.push_back(makeMapped(1, to_underlying(archetype), chunk, index));
+    auto const mappingIndex = _mappingCount++;
+    UP_ASSERT(mappingIndex < freeEntityIndex, "Too many entities in a single world");
+    if ((mappingIndex & (mappingPageSize - 1)) == 0) {
+        _mappingPages.push_back(new_box<MappingPage>());
+    }
+    _mappingAt(mappingIndex) = {to_underlying(archetype), chunk, index, 1};
     return makeEntityId(mappingIndex, 1);
 }
 
 void up::World::_recycleEntityId(EntityId entity) noexcept {
     auto const entityMappingIndex = getEntityMappingIndex(entity);
-    auto const newGeneration = getEntityGeneration(entity) + 1;
+    auto const newGeneration = static_cast<uint16>(getEntityGeneration(entity) + 1);
 
-    _entityMapping[entityMappingIndex] = makeFreeEntry(newGeneration != 0 ? newGeneration : 1, _freeEntityHead);
+    _mappingAt(entityMappingIndex) = {
+        .chunk = _freeEntityHead,
+        .generation = newGeneration != 0 ? newGeneration : uint16{1}};
 
-    _freeEntityHead = entityMappingIndex;
+    _freeEntityHead = static_cast<uint32>(entityMappingIndex);
 }
 
 auto up::World::_parseEntityId(EntityId entity) const noexcept -> EntityLocation {
     auto const mappingIndex = getEntityMappingIndex(entity);
-    if (mappingIndex < 0 || mappingIndex >= _entityMapping.size()) {
+    if (mappingIndex >= _mappingCount) {
         return {false};
     }
 
-    auto const mapped = _entityMapping[mappingIndex];
-    auto const mappedGen = getMappedGeneration(_entityMapping[mappingIndex]);
-    auto const entityGen = getEntityGeneration(entity);
-    if (mappedGen != entityGen) {
+    EntityMapping const& mapped = _mappingAt(mappingIndex);
+    if (mapped.generation != getEntityGeneration(entity)) {
         return {false};
     }
 
-    return {true, ArchetypeId(getMappedArchetype(mapped)), getMappedChunk(mapped), getMappedIndex(mapped)};
+    return {true, ArchetypeId(mapped.archetype), mapped.chunk, mapped.index};
 }
 
-void up::World::_remapEntityId(EntityId entity, ArchetypeId newArchetype, uint16 newChunk, uint16 newIndex) noexcept {
-    auto const entityMappingIndex = getEntityMappingIndex(entity);
-    auto const mapped = _entityMapping[entityMappingIndex];
-    auto const mappedGen = getMappedGeneration(mapped);
-    UP_ASSERT(mappedGen == getEntityGeneration(entity));
-    _entityMapping[entityMappingIndex] = makeMapped(mappedGen, to_underlying(newArchetype), newChunk, newIndex);
+void up::World::_remapEntityId(EntityId entity, ArchetypeId newArchetype, uint32 newChunk, uint16 newIndex) noexcept {
+    EntityMapping& mapped = _mappingAt(getEntityMappingIndex(entity));
+    UP_ASSERT(mapped.generation == getEntityGeneration(entity));
+    mapped.archetype = to_underlying(newArchetype);
+    mapped.chunk = newChunk;
+    mapped.index = newIndex;
 }
 
-void up::World::_moveTo(
+void up::World::_relocateTo(
+    view<int16> rowMap,
     ArchetypeId destArch,
     Chunk& destChunk,
     int destIndex,
     ArchetypeId srcArch,
     Chunk& srcChunk,
-    int srcIndex) {
+    int srcIndex) noexcept {
     auto const srcLayout = _context->layoutOf(srcArch);
-    for (LayoutRow const& row : _context->layoutOf(destArch)) {
-        if (auto const srcRow = findRowDesc(srcLayout, row.component); srcRow != nullptr) {
-            row.typeInfo->ops.moveAssignment(
-                destChunk.payload + row.offset + row.width * destIndex,
-                srcChunk.payload + srcRow->offset + srcRow->width * srcIndex);
+    auto const destLayout = _context->layoutOf(destArch);
+    UP_ASSERT(rowMap.size() == srcLayout.size());
+
+    for (auto rowIndex : sequence(srcLayout.size())) {
+        LayoutRow const& row = srcLayout[rowIndex];
+
+        // components missing from the destination are being removed
+        if (rowMap[rowIndex] < 0) {
+            destroyRow(row, srcChunk, srcIndex, 1);
+            continue;
         }
-    }
-}
 
-void up::World::_moveTo(ArchetypeId arch, Chunk& destChunk, int destIndex, Chunk& srcChunk, int srcIndex) {
-    for (LayoutRow const& layout : _context->layoutOf(arch)) {
-        layout.typeInfo->ops.moveAssignment(
-            destChunk.payload + layout.offset + layout.width * destIndex,
-            srcChunk.payload + layout.offset + layout.width * srcIndex);
+        relocateRow(destLayout[rowMap[rowIndex]], destChunk, destIndex, row, srcChunk, srcIndex, 1);
     }
 }
 
@@ -255,70 +1042,149 @@ void up::World::_copyTo(
     ComponentId srcComponent,
     void const* srcData) {
     auto const destRow = findRowDesc(_context->layoutOf(destArch), srcComponent);
-    destRow->typeInfo->ops.copyConstructor(destChunk.payload + destRow->offset + destRow->width * destIndex, srcData);
+    constructElement(*destRow, destChunk, destIndex, srcData);
 }
 
 void* up::World::_constructAt(ArchetypeId arch, Chunk& chunk, int index, ComponentId component) {
     auto const row = findRowDesc(_context->layoutOf(arch), component);
+    if (row->sharedValue != nullptr) {
+        return const_cast<void*>(row->sharedValue);
+    }
+    if (row->split()) {
+        constructElement(*row, chunk, index, nullptr);
+        return nullptr;
+    }
     void* data = chunk.payload + row->offset + row->width * index;
-    row->typeInfo->ops.defaultConstructor(data);
+    if (!row->tag) {
+        row->typeInfo->ops.defaultConstructor(data);
+    }
     return data;
 }
 
-void up::World::_destroyAt(ArchetypeId arch, Chunk& chunk, int index) {
-    for (LayoutRow const& layout : _context->layoutOf(arch)) {
-        layout.typeInfo->ops.destructor(chunk.payload + layout.offset + layout.width * index);
+void up::World::_destroyAt(ArchetypeId arch, Chunk& chunk, int index) noexcept {
+    for (LayoutRow const& row : _context->layoutOf(arch)) {
+        destroyRow(row, chunk, index, 1);
     }
 }
 
-auto up::World::_addChunk(ArchetypeId arch, Chunk* chunk) -> uint16 {
+auto up::World::_addChunk(ArchetypeId arch, Chunk* chunk) -> uint32 {
     UP_ASSERT(chunk != nullptr);
 
     auto const archIndex = to_underlying(arch);
-    UP_ASSERT(archIndex >= 0 && archIndex < _context->archetypes.size());
+    UP_ASSERT(archIndex < _context->archetypeCount());
 
     chunk->header.archetype = arch;
-    chunk->header.capacity = _context->archetypes[archIndex].maxEntitiesPerChunk;
+    chunk->header.capacity = _context->archetypeLayout(arch).maxEntitiesPerChunk;
 
-    if (archIndex >= _archetypeChunkRanges.size()) {
-        _archetypeChunkRanges.resize(archIndex + 1, {static_cast<uint32>(_chunks.size()), 0});
+    if (archIndex >= _archetypeChunks.size()) {
+        _archetypeChunks.resize(archIndex + 1);
     }
 
-    auto& range = _archetypeChunkRanges[archIndex];
+    ArchetypeChunks& data = _archetypeChunks[archIndex];
+    UP_ASSERT(data.chunks.size() < notAvailable, "Too many chunks in a single archetype");
 
-    auto const chunkIndex = narrow_cast<uint16>(range.length);
+    auto const chunkIndex = narrow_cast<uint32>(data.chunks.size());
+    data.chunks.push_back(chunk);
+    data.availableSlots.push_back(notAvailable);
+    ++_chunkCount;
 
-    _chunks.insert(_chunks.begin() + range.offset + range.length, chunk);
-    ++range.length;
+    _updateAvailability(arch, chunkIndex);
+    return chunkIndex;
+}
+
+void up::World::_removeChunk(ArchetypeId arch, uint32 chunkIndex) noexcept {
+    auto const archIndex = to_underlying(arch);
+    UP_ASSERT(archIndex < _archetypeChunks.size());
+
+    ArchetypeChunks& data = _archetypeChunks[archIndex];
+    UP_ASSERT(chunkIndex < data.chunks.size());
+
+    auto const last = static_cast<uint32>(data.chunks.size() - 1);
+
+    _setAvailable(data, chunkIndex, false);
+
+    // move the archetype's last chunk into the vacated position, so only its entities need remapping
+    if (chunkIndex != last) {
+        Chunk const* const moved = data.chunks[last];
+        data.chunks[chunkIndex] = data.chunks[last];
+        data.availableSlots[chunkIndex] = data.availableSlots[last];
+        if (data.availableSlots[chunkIndex] != notAvailable) {
+            data.available[data.availableSlots[chunkIndex]] = chunkIndex;
+        }
 
-    for (auto& updateRange : _archetypeChunkRanges.subspan(archIndex + 1)) {
-        ++updateRange.offset;
+        for (uint16 entityIndex = 0; entityIndex != moved->header.entities; ++entityIndex) {
+            _remapEntityId(moved->entities()[entityIndex], arch, chunkIndex, entityIndex);
+        }
     }
 
-    return chunkIndex;
+    data.chunks.pop_back();
+    data.availableSlots.pop_back();
+    --_chunkCount;
 }
 
-void up::World::_removeChunk(ArchetypeId arch, int chunkIndex) noexcept {
-    auto const archIndex = to_underlying(arch);
-    UP_ASSERT(archIndex >= 0 && archIndex < _archetypeChunkRanges.size());
+auto up::World::_unshareChunk(ArchetypeId archetype, uint32 chunkIndex) -> Chunk* {
+    // the chunk is only replaced while the lock is held, so this world's reference keeps it alive while copying
+    LockGuard _(_unshareLock);
+
+    Chunk*& slot = _archetypeChunks[to_underlying(archetype)].chunks[chunkIndex];
+    Chunk* const shared = slot;
+    if (std::atomic_ref<uint32>(shared->header.references).load(std::memory_order_acquire) == 1) {
+        // another thread already made a private copy, or the other world released its reference
+        return shared;
+    }
+
+    Chunk* const chunk = _context->acquireChunk(archetype);
+
+    chunk->header.archetype = shared->header.archetype;
+    chunk->header.entities = shared->header.entities;
+    chunk->header.capacity = shared->header.capacity;
+
+    auto const count = shared->header.entities;
+    std::memcpy(chunk->payload, shared->payload, count * sizeof(EntityId));
+    for (LayoutRow const& row : _context->layoutOf(archetype)) {
+        if (!row.stored()) {
+            continue;
+        }
+        char const* const from = shared->payload + row.offset;
+        char* const to = chunk->payload + row.offset;
+        if (row.split()) {
+            // sub-columns are spread over the whole capacity of the row
+            std::memcpy(to, from, row.width * chunk->header.capacity);
+        }
+        else if (row.typeInfo->triviallyCopyable) {
+            std::memcpy(to, from, row.width * count);
+        }
+        else {
+            for (unsigned index = 0; index != count; ++index) {
+                row.typeInfo->ops.copyConstructor(to + row.width * index, from + row.width * index);
+            }
+        }
+        chunk->rowVersion(row.versionOffset) = shared->rowVersion(row.versionOffset);
+    }
 
-    auto& range = _archetypeChunkRanges[archIndex];
-    UP_ASSERT(chunkIndex >= 0 && chunkIndex < static_cast<int>(range.length));
+    std::atomic_ref<Chunk*>(slot).store(chunk, std::memory_order_release);
+    _releaseChunk(shared);
+    return chunk;
+}
 
-    _chunks.erase(_chunks.begin() + range.offset + chunkIndex);
-    --range.length;
+void up::World::_releaseChunk(Chunk* chunk) noexcept {
+    // the last world holding a chunk is responsible for destroying its components
+    if (std::atomic_ref<uint32>(chunk->header.references).fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
 
-    for (auto& updateRange : _archetypeChunkRanges.subspan(archIndex + 1)) {
-        --updateRange.offset;
+    for (LayoutRow const& row : _context->layoutOf(chunk->header.archetype)) {
+        destroyRow(row, *chunk, 0, chunk->header.entities);
     }
+    _context->recycleChunk(chunk);
 }
 
-auto up::World::_getChunk(ArchetypeId arch, int chunkIndex) const noexcept -> Chunk* {
+auto up::World::_getChunk(ArchetypeId arch, uint32 chunkIndex) const noexcept -> Chunk* {
     auto const archIndex = to_underlying(arch);
-    if (archIndex < 0 || archIndex >= _archetypeChunkRanges.size()) {
+    if (archIndex >= _archetypeChunks.size()) {
         return nullptr;
     }
-    auto& range = _archetypeChunkRanges[archIndex];
-    UP_ASSERT(chunkIndex >= 0 && chunkIndex < static_cast<int>(range.length));
-    return _chunks[range.offset + chunkIndex];
+    auto const& chunks = _archetypeChunks[archIndex].chunks;
+    UP_ASSERT(chunkIndex < chunks.size());
+    return chunks[chunkIndex];
 }
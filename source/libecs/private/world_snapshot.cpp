@@ -0,0 +1,369 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "entity_id.h"
+#include "shared_context.h"
+#include "world.h"
+
+#include "potato/reflex/serialize.h"
+#include "potato/runtime/assertion.h"
+#include "potato/spud/find.h"
+
+#include <cstring>
+#include <new>
+
+// Snapshot layout; all values are native-endian and unaligned.
+//
+//   header:     magic, version (uint32 each)
+//   components: count (uint32), then per component its hash (uint64), size (uint32),
+//               trivially copyable flag (uint8), shared flag (uint8), and name (uint32 length + characters)
+//   entities:   mapping count (uint64), free list head (uint32), then the raw entity mapping entries
+//   archetypes: count (uint32), then per archetype its component count (uint32), component
+//               table indices (uint32 each), the reflex binary encoding of each shared component's
+//               value, and chunk count (uint32), followed by each chunk: entity count (uint32),
+//               entity ids, then one array per component. Trivially copyable components are raw
+//               element arrays; others are reflex binary encodings. Tags and shared components
+//               have no array.
+//
+namespace up {
+    static constexpr uint32 snapshotMagic = 0x53575055; // 'UPWS'
+    static constexpr uint32 snapshotVersion = 3;
+
+    static void writeBytes(vector<byte>& out, void const* data, size_t size) {
+        auto const offset = out.size();
+        out.resize(offset + size);
+        std::memcpy(out.data() + offset, data, size);
+    }
+
+    template <typename T>
+    static void writeValue(vector<byte>& out, T const& value) {
+        writeBytes(out, &value, sizeof(value));
+    }
+
+    static auto readBytes(view<byte>& in, void* data, size_t size) noexcept -> bool {
+        if (in.size() < size) {
+            return false;
+        }
+        std::memcpy(data, in.data(), size);
+        in = in.subspan(size);
+        return true;
+    }
+
+    template <typename T>
+    static auto readValue(view<byte>& in, T& value) noexcept -> bool {
+        return readBytes(in, &value, sizeof(value));
+    }
+
+    static auto findRow(view<LayoutRow> layout, reflex::TypeInfo const* typeInfo) noexcept -> LayoutRow const* {
+        for (LayoutRow const& row : layout) {
+            if (row.typeInfo == typeInfo) {
+                return &row;
+            }
+        }
+        return nullptr;
+    }
+} // namespace up
+
+auto up::World::saveSnapshot(vector<byte>& out) const -> bool {
+    // only components used by populated archetypes are recorded
+    vector<reflex::TypeInfo const*> components;
+    uint32 archetypeCount = 0;
+    for (size_t archIndex = 0; archIndex != _archetypeChunks.size(); ++archIndex) {
+        if (_archetypeChunks[archIndex].chunks.empty()) {
+            continue;
+        }
+        ++archetypeCount;
+        for (LayoutRow const& row : _context->layoutOf(static_cast<ArchetypeId>(archIndex))) {
+            if (!contains(components, row.typeInfo)) {
+                components.push_back(row.typeInfo);
+            }
+        }
+    }
+
+    writeValue(out, snapshotMagic);
+    writeValue(out, snapshotVersion);
+
+    writeValue(out, static_cast<uint32>(components.size()));
+    for (reflex::TypeInfo const* const typeInfo : components) {
+        writeValue(out, typeInfo->hash);
+        writeValue(out, static_cast<uint32>(typeInfo->size));
+        writeValue(out, static_cast<uint8>(typeInfo->triviallyCopyable));
+        writeValue(out, static_cast<uint8>(_context->isSharedComponent(static_cast<ComponentId>(typeInfo->hash))));
+        writeValue(out, static_cast<uint32>(typeInfo->name.size()));
+        writeBytes(out, typeInfo->name.data(), typeInfo->name.size());
+    }
+
+    writeValue(out, _mappingCount);
+    writeValue(out, _freeEntityHead);
+    for (uint64 first = 0; first < _mappingCount; first += mappingPageSize) {
+        auto const count = _mappingCount - first < mappingPageSize ? _mappingCount - first : mappingPageSize;
+        writeBytes(out, &_mappingAt(first), count * sizeof(EntityMapping));
+    }
+
+    bool success = true;
+    writeValue(out, archetypeCount);
+    for (size_t archIndex = 0; archIndex != _archetypeChunks.size(); ++archIndex) {
+        ArchetypeChunks const& data = _archetypeChunks[archIndex];
+        if (data.chunks.empty()) {
+            continue;
+        }
+
+        auto const layout = _context->layoutOf(static_cast<ArchetypeId>(archIndex));
+        writeValue(out, static_cast<uint32>(layout.size()));
+        for (LayoutRow const& row : layout) {
+            writeValue(out, static_cast<uint32>(find(components, row.typeInfo) - components.begin()));
+        }
+        for (LayoutRow const& row : layout) {
+            if (row.sharedValue != nullptr) {
+                success = reflex::encodeToBinaryRaw(out, *row.typeInfo->schema, row.sharedValue) && success;
+            }
+        }
+
+        writeValue(out, static_cast<uint32>(data.chunks.size()));
+        for (Chunk const* const chunk : data.chunks) {
+            auto const count = chunk->header.entities;
+            writeValue(out, static_cast<uint32>(count));
+            writeBytes(out, chunk->entities().data(), count * sizeof(EntityId));
+
+            for (LayoutRow const& row : layout) {
+                if (!row.stored()) {
+                    continue;
+                }
+                // split components are written as whole values, so the format does not depend on chunk capacity
+                if (row.split()) {
+                    alignas(std::max_align_t) char value[maxSplitComponentSize];
+                    for (size_t index = 0; index != count; ++index) {
+                        gatherSplitElement(row, chunk->payload, chunk->header.capacity, index, value);
+                        writeBytes(out, value, row.typeInfo->size);
+                    }
+                    continue;
+                }
+
+                char const* const rowData = chunk->payload + row.offset;
+                if (row.typeInfo->triviallyCopyable) {
+                    writeBytes(out, rowData, row.width * count);
+                    continue;
+                }
+
+                UP_ASSERT(row.typeInfo->schema != nullptr);
+                for (size_t index = 0; index != count; ++index) {
+                    success =
+                        reflex::encodeToBinaryRaw(out, *row.typeInfo->schema, rowData + row.width * index) && success;
+                }
+            }
+        }
+    }
+
+    return success;
+}
+
+auto up::World::loadSnapshot(view<byte> data) -> bool {
+    UP_ASSERT(_chunkCount == 0 && _mappingCount == 0, "Snapshots can only be loaded into an empty World");
+
+    uint32 magic = 0;
+    uint32 version = 0;
+    if (!readValue(data, magic) || !readValue(data, version) || magic != snapshotMagic ||
+        version != snapshotVersion) {
+        return false;
+    }
+
+    // resolve the component table against this world's registered components
+    uint32 componentCount = 0;
+    if (!readValue(data, componentCount)) {
+        return false;
+    }
+    vector<reflex::TypeInfo const*> components;
+    components.reserve(componentCount);
+    for (uint32 index = 0; index != componentCount; ++index) {
+        uint64 hash = 0;
+        uint32 size = 0;
+        uint8 triviallyCopyable = 0;
+        uint8 shared = 0;
+        uint32 nameLength = 0;
+        if (!readValue(data, hash) || !readValue(data, size) || !readValue(data, triviallyCopyable) ||
+            !readValue(data, shared) || !readValue(data, nameLength) || data.size() < nameLength) {
+            return false;
+        }
+        data = data.subspan(nameLength);
+
+        auto const component = static_cast<ComponentId>(hash);
+        reflex::TypeInfo const* const typeInfo = _context->findComponentById(component);
+        if (typeInfo == nullptr || typeInfo->size != size ||
+            typeInfo->triviallyCopyable != (triviallyCopyable != 0) ||
+            _context->isSharedComponent(component) != (shared != 0)) {
+            return false;
+        }
+        if (!typeInfo->triviallyCopyable && typeInfo->schema == nullptr) {
+            return false;
+        }
+        components.push_back(typeInfo);
+    }
+
+    uint64 mappingCount = 0;
+    uint32 freeEntityHead = freeEntityIndex;
+    if (!readValue(data, mappingCount) || !readValue(data, freeEntityHead) || mappingCount >= freeEntityIndex ||
+        data.size() / sizeof(EntityMapping) < mappingCount) {
+        return false;
+    }
+    for (uint64 first = 0; first < mappingCount; first += mappingPageSize) {
+        auto const count = mappingCount - first < mappingPageSize ? mappingCount - first : mappingPageSize;
+        _mappingPages.push_back(new_box<MappingPage>());
+        readBytes(data, _mappingPages.back()->entries, count * sizeof(EntityMapping));
+    }
+    _mappingCount = mappingCount;
+    _freeEntityHead = freeEntityHead;
+
+    auto const fail = [this] {
+        _clear();
+        return false;
+    };
+
+    uint32 archetypeCount = 0;
+    if (!readValue(data, archetypeCount)) {
+        return fail();
+    }
+
+    // every mapping entry must end up either claimed by exactly one entity in a chunk or on the free list,
+    // so that no live-looking entry can point at an archetype or chunk that does not exist
+    vector<bool> claimed(_mappingCount, false);
+
+    vector<reflex::TypeInfo const*> archetypeComponents;
+    vector<reflex::TypeInfo const*> unsharedComponents;
+    for (uint32 archetypeIndex = 0; archetypeIndex != archetypeCount; ++archetypeIndex) {
+        uint32 rowCount = 0;
+        if (!readValue(data, rowCount) || rowCount > components.size()) {
+            return fail();
+        }
+        archetypeComponents.clear();
+        unsharedComponents.clear();
+        for (uint32 rowIndex = 0; rowIndex != rowCount; ++rowIndex) {
+            uint32 componentIndex = 0;
+            if (!readValue(data, componentIndex) || componentIndex >= components.size()) {
+                return fail();
+            }
+            archetypeComponents.push_back(components[componentIndex]);
+            if (!_context->isSharedComponent(static_cast<ComponentId>(components[componentIndex]->hash))) {
+                unsharedComponents.push_back(components[componentIndex]);
+            }
+        }
+
+        // the archetype is resolved once, and every chunk after it shares the result; shared
+        // components are decoded into a temporary value to find the archetype holding it
+        ArchetypeId archetype = _context->acquireArchetype(ArchetypeId::Empty, unsharedComponents, {});
+        for (reflex::TypeInfo const* const typeInfo : archetypeComponents) {
+            if (contains(unsharedComponents, typeInfo)) {
+                continue;
+            }
+
+            void* const value = ::operator new(typeInfo->size, std::align_val_t(typeInfo->alignment));
+            typeInfo->ops.defaultConstructor(value);
+            bool const decoded = reflex::decodeFromBinaryRaw(data, *typeInfo->schema, value);
+            if (decoded) {
+                archetype = _context->acquireSharedEdge(archetype, *typeInfo, value).target;
+            }
+            typeInfo->ops.destructor(value);
+            ::operator delete(value, std::align_val_t(typeInfo->alignment));
+
+            if (!decoded) {
+                return fail();
+            }
+        }
+        auto const layout = _context->layoutOf(archetype);
+        if (layout.size() != rowCount) {
+            return fail();
+        }
+
+        uint32 chunkCount = 0;
+        if (!readValue(data, chunkCount) || chunkCount >= notAvailable) {
+            return fail();
+        }
+        for (uint32 chunkIndex = 0; chunkIndex != chunkCount; ++chunkIndex) {
+            uint32 count = 0;
+            if (!readValue(data, count) || count == 0 ||
+                count > _context->archetypeLayout(archetype).maxEntitiesPerChunk) {
+                return fail();
+            }
+
+            Chunk* const chunk = _context->acquireChunk(archetype);
+            auto const index = _addChunk(archetype, chunk);
+            if (!readBytes(data, chunk->payload, count * sizeof(EntityId))) {
+                return fail();
+            }
+
+            auto const* const entities = reinterpret_cast<EntityId const*>(chunk->payload);
+            for (uint16 entityIndex = 0; entityIndex != count; ++entityIndex) {
+                EntityId const entity = entities[entityIndex];
+                auto const mappingIndex = getEntityMappingIndex(entity);
+                if (mappingIndex >= _mappingCount || claimed[mappingIndex] ||
+                    _mappingAt(mappingIndex).generation != getEntityGeneration(entity)) {
+                    return fail();
+                }
+                claimed[mappingIndex] = true;
+                _remapEntityId(entity, archetype, index, entityIndex);
+            }
+
+            // schema-encoded components are decoded in place, so every row must be constructed
+            // before the chunk claims its entities and could be cleaned up after a failure
+            for (LayoutRow const& row : layout) {
+                if (row.stored() && !row.typeInfo->triviallyCopyable) {
+                    for (uint32 entityIndex = 0; entityIndex != count; ++entityIndex) {
+                        row.typeInfo->ops.defaultConstructor(chunk->payload + row.offset + row.width * entityIndex);
+                    }
+                }
+            }
+            chunk->header.entities = count;
+            _updateAvailability(archetype, index);
+
+            for (reflex::TypeInfo const* const typeInfo : archetypeComponents) {
+                LayoutRow const* const row = findRow(layout, typeInfo);
+                if (!row->stored()) {
+                    continue;
+                }
+                if (row->split()) {
+                    alignas(std::max_align_t) char value[maxSplitComponentSize];
+                    for (uint32 entityIndex = 0; entityIndex != count; ++entityIndex) {
+                        if (!readBytes(data, value, typeInfo->size)) {
+                            return fail();
+                        }
+                        scatterSplitElement(*row, chunk->payload, chunk->header.capacity, entityIndex, value);
+                    }
+                    continue;
+                }
+
+                char* const rowData = chunk->payload + row->offset;
+                if (typeInfo->triviallyCopyable) {
+                    if (!readBytes(data, rowData, row->width * count)) {
+                        return fail();
+                    }
+                    continue;
+                }
+
+                for (uint32 entityIndex = 0; entityIndex != count; ++entityIndex) {
+                    if (!reflex::decodeFromBinaryRaw(data, *typeInfo->schema, rowData + row->width * entityIndex)) {
+                        return fail();
+                    }
+                }
+            }
+
+            _markChanged(archetype, *chunk);
+        }
+    }
+
+    // trailing data means the snapshot was not understood correctly
+    if (!data.empty()) {
+        return fail();
+    }
+
+    // the free list must stay in range and must not loop, which marking visited entries also rules out
+    for (uint32 free = _freeEntityHead; free != freeEntityIndex; free = _mappingAt(free).chunk) {
+        if (free >= _mappingCount || claimed[free]) {
+            return fail();
+        }
+        claimed[free] = true;
+    }
+    for (bool const used : claimed) {
+        if (!used) {
+            return fail();
+        }
+    }
+    return true;
+}
@@ -7,21 +7,48 @@
 #include "potato/spud/span.h"
 
 namespace up {
+    /// @brief Checks if a write version is newer than another, tolerating wrap-around.
+    constexpr bool isNewerVersion(uint32 version, uint32 since) noexcept {
+        return static_cast<int32>(version - since) > 0;
+    }
+
+    /// @brief The sizes of Chunk that may be allocated; each Archetype uses a single class for all of its Chunks.
+    enum class ChunkSizeClass : uint8 { Small, Medium, Large };
+
+    constexpr uint32 chunkSizeClassCount = 3;
+
+    /// @brief Size in bytes of a Chunk of the given class, including its header.
+    constexpr auto chunkSizeBytes(ChunkSizeClass sizeClass) noexcept -> uint32 {
+        return (16 * 1024) << (2 * static_cast<uint32>(sizeClass));
+    }
+
     /// Chunks are the storage mechanism of Entities and their Components. A Chunk
     /// is allocated to an Archetype and will store a list of Components according
     /// to the Archetype's specified layout.
     ///
+    /// Chunks come in several size classes. The Chunk type describes the largest, and only the
+    /// first payloadBytes() of the payload of a smaller Chunk may be accessed.
+    ///
     struct alignas(64) Chunk {
-        static constexpr uint32 SizeBytes = 64 * 1024;
+        static constexpr uint32 MaxSizeBytes = chunkSizeBytes(ChunkSizeClass::Large);
 
         struct Header {
             ArchetypeId archetype = ArchetypeId::Empty;
             unsigned int entities = 0;
             unsigned int capacity = 0;
+            /// Number of Worlds sharing this Chunk; see World::clone.
+            uint32 references = 1;
             Chunk* next = nullptr;
+            /// Set by the allocator, and kept for the lifetime of the Chunk's memory.
+            ChunkSizeClass sizeClass = ChunkSizeClass::Medium;
         };
 
-        using Payload = char[SizeBytes - sizeof(Header)];
+        using Payload = char[MaxSizeBytes - sizeof(Header)];
+
+        /// @brief Size in bytes of the payload of a Chunk of the given class.
+        static constexpr auto payloadBytes(ChunkSizeClass sizeClass) noexcept -> uint32 {
+            return chunkSizeBytes(sizeClass) - sizeof(Header);
+        }
 
         /// @brief Retrieves a span of EntityIds associated with this Chunk
         auto entities() noexcept -> span<EntityId> { return {reinterpret_cast<EntityId*>(payload), header.entities}; }
@@ -31,11 +58,19 @@ namespace up {
             return {reinterpret_cast<EntityId const*>(payload), header.entities};
         }
 
+        /// @brief Retrieves the write version of a component row, given the row's versionOffset.
+        ///
+        /// The version is updated whenever the row may have been modified, e.g. by a Query
+        /// requesting mutable access or by Entities moving into or within the Chunk.
+        ///
+        auto rowVersion(uint32 versionOffset) noexcept -> uint32& {
+            return *reinterpret_cast<uint32*>(payload + versionOffset);
+        }
+
         Header header;
-        Payload payload = {
-            0,
-        };
+        /// Left uninitialized, as constructing a small Chunk must not touch memory beyond its end.
+        Payload payload;
     }; // namespace up
 
-    static_assert(sizeof(Chunk) == Chunk::SizeBytes, "Chunk has incorrect size; possibly unexpected member padding");
+    static_assert(sizeof(Chunk) == Chunk::MaxSizeBytes, "Chunk has incorrect size; possibly unexpected member padding");
 } // namespace up
@@ -0,0 +1,98 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#pragma once
+
+#include "_export.h"
+#include "chunk.h"
+
+#include "potato/spud/int_types.h"
+#include "potato/spud/vector.h"
+
+namespace up {
+    /// Memory usage of a ChunkAllocator.
+    struct ChunkMemoryStats {
+        /// Chunks currently handed out to Worlds.
+        size_t chunksInUse = 0;
+        /// Bytes of the Chunks currently handed out to Worlds.
+        size_t bytesInUse = 0;
+        /// Chunks in mapped slabs that are available for reuse.
+        size_t chunksFree = 0;
+        size_t slabsMapped = 0;
+        size_t bytesMapped = 0;
+        /// Highest value bytesMapped has reached.
+        size_t peakBytesMapped = 0;
+        /// Total number of slabs that have been returned to the OS.
+        size_t slabsReleased = 0;
+    };
+
+    /// Allocates Chunks out of large, aligned slabs of memory mapped directly from the OS.
+    ///
+    /// Each slab holds Chunks of a single size class. New Chunks are taken from the fullest
+    /// slab of their class that has room, so that lightly-used slabs drain over time. Slabs
+    /// which become entirely free may be reused for any class, and are returned to the OS once
+    /// the memory held by such slabs exceeds a retention budget, which keeps a small reserve
+    /// to absorb churn without repeatedly mapping and unmapping memory.
+    ///
+    /// A ChunkAllocator is not internally synchronized.
+    ///
+    class ChunkAllocator {
+    public:
+        /// Slabs are sized to match a typical huge page.
+        static constexpr size_t slabBytes = 2 * 1024 * 1024;
+        static constexpr size_t defaultRetainedBytes = 2 * slabBytes;
+
+        static_assert(slabBytes % Chunk::MaxSizeBytes == 0, "Slabs must hold a whole number of the largest Chunks");
+
+        static constexpr auto chunksPerSlab(ChunkSizeClass sizeClass) noexcept -> uint32 {
+            return static_cast<uint32>(slabBytes / chunkSizeBytes(sizeClass));
+        }
+
+        ChunkAllocator() = default;
+        UP_ECS_API ~ChunkAllocator();
+
+        ChunkAllocator(ChunkAllocator const&) = delete;
+        ChunkAllocator& operator=(ChunkAllocator const&) = delete;
+
+        UP_ECS_API auto allocate(ChunkSizeClass sizeClass) -> Chunk*;
+        UP_ECS_API void deallocate(Chunk* chunk) noexcept;
+
+        /// @brief Sets how much memory in entirely free slabs may be kept for reuse.
+        ///
+        /// Any free slabs in excess of the new budget are returned to the OS immediately;
+        /// a budget of zero releases every free slab.
+        ///
+        UP_ECS_API void setRetainedBytes(size_t bytes) noexcept;
+        auto retainedBytes() const noexcept -> size_t { return _retainedBytes; }
+
+        /// @brief Enables or disables the transparent huge page hint for newly-mapped slabs.
+        void setHugePages(bool enabled) noexcept { _hugePages = enabled; }
+
+        UP_ECS_API auto stats() const noexcept -> ChunkMemoryStats;
+
+    private:
+        struct Slab {
+            char* memory = nullptr;
+            Chunk* freeHead = nullptr;
+            // Chunks currently allocated from this slab
+            uint32 used = 0;
+            // Chunks are carved out of the slab on demand, so untouched memory stays uncommitted
+            uint32 carved = 0;
+            // changed only while the slab is empty, which discards its carved Chunks
+            ChunkSizeClass sizeClass = ChunkSizeClass::Medium;
+        };
+
+        auto _findSlab(Chunk const* chunk) noexcept -> Slab*;
+        auto _mapSlab() -> Slab*;
+        void _trim() noexcept;
+
+        // sorted by address, so the owning slab of a Chunk can be found with a binary search
+        vector<Slab> _slabs;
+        size_t _retainedBytes = defaultRetainedBytes;
+        size_t _emptySlabs = 0;
+        size_t _chunksInUse = 0;
+        size_t _bytesInUse = 0;
+        size_t _peakBytesMapped = 0;
+        size_t _slabsReleased = 0;
+        bool _hugePages = true;
+    };
+} // namespace up
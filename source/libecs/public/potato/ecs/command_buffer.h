@@ -0,0 +1,146 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#pragma once
+
+#include "_export.h"
+#include "common.h"
+#include "shared_context.h"
+
+#include "potato/reflex/type.h"
+#include "potato/spud/box.h"
+#include "potato/spud/int_types.h"
+#include "potato/spud/rc.h"
+#include "potato/spud/span.h"
+#include "potato/spud/vector.h"
+
+namespace up {
+    class World;
+
+    /// Records structural changes to be applied to a World at a later safe point.
+    ///
+    /// Creating or deleting Entities and adding or removing Components moves Entities
+    /// between Chunks, so these changes cannot be made while a Query is iterating the
+    /// World. Systems instead record them into an EntityCommandBuffer, which is played
+    /// back once iteration has finished.
+    ///
+    /// A buffer is not internally synchronized. Each thread should record into its own
+    /// buffer, which keeps recording free of locks.
+    ///
+    /// Entities created through a buffer are identified by placeholder EntityIds until
+    /// playback. Placeholders may be used in any later command recorded into the same buffer
+    /// and are replaced by the real EntityId when the buffer is played back.
+    ///
+    /// The values of shared Components select an Entity's Archetype, so recorded creations
+    /// are batched by the Archetype their values resolve to.
+    ///
+    class EntityCommandBuffer {
+    public:
+        UP_ECS_API explicit EntityCommandBuffer(rc<EcsSharedContext> context);
+        UP_ECS_API ~EntityCommandBuffer();
+
+        UP_ECS_API EntityCommandBuffer(EntityCommandBuffer&& rhs) noexcept;
+        UP_ECS_API EntityCommandBuffer& operator=(EntityCommandBuffer&& rhs) noexcept;
+
+        /// @brief Checks if any commands have been recorded.
+        bool empty() const noexcept { return _commands.empty(); }
+
+        /// @brief Records the creation of a new Entity with the provided list of Component data.
+        ///
+        /// @returns A placeholder EntityId which is only meaningful to commands recorded into this buffer.
+        template <typename... Components>
+        EntityId createEntity(Components const&... components);
+
+        /// @brief Records the deletion of an existing Entity.
+        UP_ECS_API void deleteEntity(EntityId entity);
+
+        /// @brief Records adding a Component to an existing Entity.
+        ///
+        /// If the Entity already has the Component by the time the buffer is played back,
+        /// the existing value is replaced.
+        ///
+        template <typename Component>
+        void addComponent(EntityId entity, Component const& component);
+
+        /// @brief Records removing a Component from an existing Entity.
+        UP_ECS_API void removeComponent(EntityId entity, ComponentId component);
+
+        /// @brief Records removing a Component from an existing Entity.
+        template <typename Component>
+        void removeComponent(EntityId entity) {
+            reflex::TypeInfo const* const typeInfo = _context->findComponentByType<Component>();
+            removeComponent(entity, static_cast<ComponentId>(typeInfo->hash));
+        }
+
+        /// @brief Applies all recorded commands to a World and then clears the buffer.
+        ///
+        /// New Entities are created in bulk per Archetype first, so that commands recorded
+        /// against their placeholders apply to the created Entities.
+        ///
+        /// Commands affecting the same Entity are collapsed into a single structural change.
+        /// Changes are then sorted by their source and destination Archetypes so that each
+        /// group is applied as one batch.
+        ///
+        /// Commands targeting Entities that no longer exist are ignored. The World's observers
+        /// are notified once every change has been applied.
+        ///
+        UP_ECS_API void playback(World& world);
+
+        /// @brief Discards all recorded commands.
+        UP_ECS_API void clear() noexcept;
+
+    private:
+        enum class Op : uint8 { CreateEntity, DeleteEntity, AddComponent, RemoveComponent };
+
+        struct Command {
+            Op op = Op::CreateEntity;
+            EntityId entity = EntityId::None;
+            uint32 firstComponent = 0;
+            uint32 componentCount = 0;
+        };
+
+        struct RecordedComponent {
+            reflex::TypeInfo const* typeInfo = nullptr;
+            void* data = nullptr;
+        };
+
+        struct alignas(64) DataPage {
+            static constexpr size_t SizeBytes = 16 * 1024;
+
+            char bytes[SizeBytes];
+        };
+
+        UP_ECS_API auto _recordCreate(view<reflex::TypeInfo const*> components, view<void const*> data) -> EntityId;
+        UP_ECS_API void _recordAdd(EntityId entity, reflex::TypeInfo const& typeInfo, void const* data);
+        auto _storeComponent(reflex::TypeInfo const& typeInfo, void const* data) -> RecordedComponent;
+
+        void _playbackChanges(World& world, view<EntityId> created);
+        void _playbackCreates(World& world, span<EntityId> created);
+
+        vector<Command> _commands;
+        vector<RecordedComponent> _components;
+        vector<box<DataPage>> _pages;
+        size_t _currentPage = 0;
+        size_t _pageOffset = 0;
+        uint32 _createCount = 0;
+        rc<EcsSharedContext> _context;
+    };
+
+    template <typename... Components>
+    EntityId EntityCommandBuffer::createEntity(Components const&... components) {
+        if constexpr (sizeof...(Components) != 0) {
+            reflex::TypeInfo const* const typeInfos[] = {_context->findComponentByType<Components>()...};
+            void const* const componentData[] = {&components...};
+
+            return _recordCreate(typeInfos, componentData);
+        }
+        else {
+            return _recordCreate({}, {});
+        }
+    }
+
+    template <typename Component>
+    void EntityCommandBuffer::addComponent(EntityId entity, Component const& component) {
+        reflex::TypeInfo const* const typeInfo = _context->findComponentByType<Component>();
+        _recordAdd(entity, *typeInfo, &component);
+    }
+} // namespace up
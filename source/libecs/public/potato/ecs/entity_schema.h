@@ -0,0 +1,16 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#pragma once
+
+#include "common.h"
+
+#include "potato/reflex/schema.h"
+
+/// Entity ids are reflected as their underlying integer, so that components may refer to other Entities.
+template <>
+struct up::reflex::SchemaHolder<up::EntityId> {
+    static Schema const& get() noexcept {
+        static constexpr Schema schema{.name = "EntityId"_zsv, .primitive = SchemaPrimitive::UInt64};
+        return schema;
+    }
+};
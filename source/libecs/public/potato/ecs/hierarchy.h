@@ -0,0 +1,56 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#pragma once
+
+#include "_export.h"
+#include "common.h"
+#include "ecs_schema.h"
+
+#include "potato/reflex/type.h"
+
+namespace up {
+    class Universe;
+    class World;
+
+    /// @brief Registers the Parent, Children, and HierarchyDepth components, which link Entities into a hierarchy.
+    ///
+    /// The children of an Entity form a doubly linked list through their Parent components, so
+    /// attaching and detaching never allocate, and every hierarchy component is trivially copyable.
+    ///
+    /// HierarchyDepth is registered as a shared component, so Entities at different depths never
+    /// share a Chunk. A Query binding Shared<HierarchyDepth> can then walk a hierarchy one depth at
+    /// a time with Query::selectChunksParallelByLevel, e.g. to compute world transforms from the
+    /// already computed transforms of each parent, without recursion.
+    ///
+    UP_ECS_API void registerHierarchyComponents(Universe& universe);
+
+    /// @brief Checks if a component is one of those maintained by setParent.
+    ///
+    /// They refer to other Entities by id, which is not meaningful outside of their World, so tools
+    /// should neither edit nor serialize them; the hierarchy is rebuilt with setParent instead.
+    ///
+    UP_ECS_API auto isHierarchyComponent(reflex::TypeInfo const& typeInfo) noexcept -> bool;
+
+    /// @brief Attaches an Entity to a new parent, or detaches it if the parent is EntityId::None.
+    ///
+    /// Updates the Parent and HierarchyDepth of the child, the links of its old and new siblings, the
+    /// Children of the old and new parents, and the HierarchyDepth of every descendant of the child.
+    /// An Entity cannot be attached to itself or to one of its own descendants.
+    ///
+    /// Deleting an Entity does not update the hierarchy, so Entities should be detached from their
+    /// parent, and their children detached or deleted, beforehand.
+    ///
+    UP_ECS_API void setParent(World& world, EntityId child, EntityId parent);
+
+    /// @returns the parent of an Entity, or EntityId::None for a root.
+    UP_ECS_API auto parentOf(World const& world, EntityId entity) noexcept -> EntityId;
+
+    /// @returns the first child of an Entity, or EntityId::None if it has none.
+    UP_ECS_API auto firstChildOf(World const& world, EntityId entity) noexcept -> EntityId;
+
+    /// @returns the next child of an Entity's parent, in the order they were attached, or EntityId::None.
+    UP_ECS_API auto nextSiblingOf(World const& world, EntityId entity) noexcept -> EntityId;
+
+    /// @returns the number of ancestors of an Entity, which is zero for a root.
+    UP_ECS_API auto depthOf(World const& world, EntityId entity) noexcept -> uint32;
+} // namespace up
@@ -5,14 +5,109 @@
 #include "common.h"
 
 #include "potato/reflex/type.h"
+#include "potato/spud/span.h"
+
+#include <cstddef>
+#include <cstring>
 
 namespace up {
+    /// Largest component whose fields may be split into sub-columns; see LayoutRow::fields.
+    constexpr size_t maxSplitComponentSize = 256;
+
+    /// @brief A field of a component stored in its own sub-column.
+    struct SplitField {
+        /// Offset of the field within the component.
+        uint16 offset = 0;
+        /// Distance to the next field, or to the end of the component; the stride of the sub-column.
+        uint16 width = 0;
+    };
+
     /// @brief Describes the information about how components are laid out in an Archetype
     ///
     struct LayoutRow {
         ComponentId component = ComponentId::Unknown;
         reflex::TypeInfo const* typeInfo = nullptr;
-        uint16 offset = 0;
+        uint32 offset = 0;
         uint16 width = 0;
+        /// Offset in the chunk payload of the row's write version.
+        uint32 versionOffset = 0;
+        /// Tags hold no data; their rows have a width of zero and no write version.
+        bool tag = false;
+        /// Shared components hold a single value for the whole Archetype, stored outside of its chunks.
+        /// Like tags, their rows have a width of zero and no write version.
+        void const* sharedValue = nullptr;
+        /// Components annotated with SplitFields store each of their fields in a separate sub-column
+        /// of the row; see splitFieldOffset. Empty for all other components.
+        view<SplitField> fields{};
+
+        /// @brief Checks if the row has an element per entity in the chunk; tags and shared components do not.
+        constexpr bool stored() const noexcept { return !tag && sharedValue == nullptr; }
+
+        /// @brief Checks if the row's elements are split across a sub-column per field.
+        constexpr bool split() const noexcept { return !fields.empty(); }
+    };
+
+    /// @brief Offset in a chunk's payload of the sub-column holding a field of a split row.
+    ///
+    /// Each sub-column starts at the field's offset within the component scaled by the chunk's
+    /// capacity, so the sub-columns exactly tile the space the row would occupy unsplit.
+    ///
+    constexpr auto splitFieldOffset(LayoutRow const& row, SplitField const& field, uint32 capacity) noexcept -> uint32 {
+        return row.offset + field.offset * capacity;
+    }
+
+    /// @brief Offset of a data member within its class, e.g. to locate a field of a split row.
+    template <typename Class, typename Field>
+    auto memberOffset(Field Class::*member) noexcept -> size_t {
+        // only the address of the member is taken, so no object is ever constructed or accessed
+        alignas(Class) static char const storage[sizeof(Class)] = {};
+        auto const& object = *reinterpret_cast<Class const*>(storage);
+        return static_cast<size_t>(reinterpret_cast<char const*>(&(object.*member)) - storage);
+    }
+
+    /// @brief Copies an element of a split row out of its sub-columns into a contiguous value.
+    inline void gatherSplitElement(
+        LayoutRow const& row,
+        char const* payload,
+        uint32 capacity,
+        size_t index,
+        void* value) noexcept {
+        for (SplitField const& field : row.fields) {
+            std::memcpy(
+                static_cast<char*>(value) + field.offset,
+                payload + splitFieldOffset(row, field, capacity) + field.width * index,
+                field.width);
+        }
+    }
+
+    /// @brief Copies a contiguous value into the sub-columns of an element of a split row.
+    inline void scatterSplitElement(
+        LayoutRow const& row,
+        char* payload,
+        uint32 capacity,
+        size_t index,
+        void const* value) noexcept {
+        for (SplitField const& field : row.fields) {
+            std::memcpy(
+                payload + splitFieldOffset(row, field, capacity) + field.width * index,
+                static_cast<char const*>(value) + field.offset,
+                field.width);
+        }
+    }
+
+    /// @brief How a Component participates in matching a Query against an Archetype.
+    enum class QueryMatch : uint8 {
+        /// The Archetype must contain the Component.
+        Required,
+        /// The Archetype may or may not contain the Component.
+        Optional,
+        /// The Archetype must not contain the Component.
+        Excluded,
+    };
+
+    /// @brief A Component requested by a Query, and how it must match.
+    struct QueryBinding {
+        ComponentId component = ComponentId::Unknown;
+        QueryMatch match = QueryMatch::Required;
     };
 } // namespace up
@@ -6,17 +6,205 @@
 #include "shared_context.h"
 #include "world.h"
 
+#include "potato/runtime/scheduler.h"
+#include "potato/spud/bit_set.h"
 #include "potato/spud/span.h"
 #include "potato/spud/traits.h"
 #include "potato/spud/typelist.h"
 #include "potato/spud/utility.h"
 #include "potato/spud/vector.h"
 
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
 namespace up {
+    /// Query term binding a Component as read-only; equivalent to requesting `Component const`.
+    template <typename Component>
+    struct Read {};
+
+    /// Query term binding a Component which matching Archetypes may lack.
+    ///
+    /// The callback receives a pointer, which is null for Chunks without the Component.
+    ///
+    template <typename Component>
+    struct Optional {};
+
+    /// Query term requiring a Component without binding it to the callback, e.g. for tags.
+    template <typename Component>
+    struct With {};
+
+    /// Query term excluding all Archetypes which contain a Component.
+    template <typename Component>
+    struct Without {};
+
+    /// Query term binding a shared Component; see Universe::registerSharedComponent.
+    ///
+    /// Every Entity in a Chunk holds the same value, so chunk callbacks receive a single
+    /// read-only reference rather than an array.
+    ///
+    template <typename Component>
+    struct Shared {};
+
+    /// Query term binding a split Component; see the SplitFields schema attribute.
+    ///
+    /// Callbacks receive the Component's FieldColumns rather than pointers, as the values
+    /// of each field are stored contiguously in their own sub-column of the Chunk.
+    ///
+    template <typename Component>
+    struct Fields {};
+
+    /// The sub-columns of a split Component for a range of Entities in a Chunk.
+    ///
+    /// Each field is accessed as a span through a pointer to its member, e.g.
+    /// `columns(&Transform::position)`, which suits SIMD kernels processing many Entities at once.
+    ///
+    template <typename Component>
+    class FieldColumns {
+        using Bare = std::remove_const_t<Component>;
+
+    public:
+        template <typename Field>
+        using Element = std::conditional_t<std::is_const_v<Component>, Field const, Field>;
+
+        FieldColumns(char* row, uint32 capacity, size_t first, size_t count, view<SplitField> fields) noexcept
+            : _row(row)
+            , _capacity(capacity)
+            , _first(first)
+            , _count(count)
+            , _fields(fields) {}
+
+        /// @brief Number of Entities covered by each span.
+        auto size() const noexcept -> size_t { return _count; }
+
+        /// @brief Retrieves the values of a field, one per Entity.
+        template <typename Field>
+        auto operator()(Field Bare::*member) const noexcept -> span<Element<Field>> {
+            auto const offset = memberOffset(member);
+            UP_ASSERT(_hasField(offset, sizeof(Field)), "Field is not a sub-column of the split component");
+            char* const column = _row + offset * _capacity + sizeof(Field) * _first;
+            return {static_cast<Element<Field>*>(static_cast<void*>(column)), _count};
+        }
+
+    private:
+        auto _hasField(size_t offset, size_t width) const noexcept -> bool {
+            for (SplitField const& field : _fields) {
+                if (field.offset == offset) {
+                    return field.width == width;
+                }
+            }
+            return false;
+        }
+
+        char* _row = nullptr;
+        uint32 _capacity = 0;
+        size_t _first = 0;
+        size_t _count = 0;
+        view<SplitField> _fields;
+    };
+
+    /// Describes how a Query accesses a Component, e.g. for scheduling Systems.
+    struct ComponentAccess {
+        ComponentId component = ComponentId::Unknown;
+        bool writable = false;
+    };
+
+    namespace _detail {
+        template <typename Term>
+        struct QueryTermTraits {
+            using Type = Term;
+            using ChunkArgs = std::tuple<Type*>;
+            using EntityArgs = std::tuple<Type&>;
+            static constexpr QueryMatch match = QueryMatch::Required;
+            static constexpr bool bound = true;
+            static constexpr bool shared = false;
+            static constexpr bool split = false;
+        };
+
+        template <typename Component>
+        struct QueryTermTraits<Read<Component>> : QueryTermTraits<Component const> {};
+
+        template <typename Component>
+        struct QueryTermTraits<Optional<Component>> {
+            using Type = typename QueryTermTraits<Component>::Type;
+            using ChunkArgs = std::tuple<Type*>;
+            using EntityArgs = std::tuple<Type*>;
+            static constexpr QueryMatch match = QueryMatch::Optional;
+            static constexpr bool bound = true;
+            static constexpr bool shared = false;
+            static constexpr bool split = false;
+        };
+
+        template <typename Component>
+        struct QueryTermTraits<With<Component>> {
+            using Type = Component const;
+            using ChunkArgs = std::tuple<>;
+            using EntityArgs = std::tuple<>;
+            static constexpr QueryMatch match = QueryMatch::Required;
+            static constexpr bool bound = false;
+            static constexpr bool shared = false;
+            static constexpr bool split = false;
+        };
+
+        template <typename Component>
+        struct QueryTermTraits<Without<Component>> {
+            using Type = Component const;
+            using ChunkArgs = std::tuple<>;
+            using EntityArgs = std::tuple<>;
+            static constexpr QueryMatch match = QueryMatch::Excluded;
+            static constexpr bool bound = false;
+            static constexpr bool shared = false;
+            static constexpr bool split = false;
+        };
+
+        template <typename Component>
+        struct QueryTermTraits<Shared<Component>> {
+            using Type = Component const;
+            using ChunkArgs = std::tuple<Type&>;
+            using EntityArgs = std::tuple<Type&>;
+            static constexpr QueryMatch match = QueryMatch::Required;
+            static constexpr bool bound = true;
+            static constexpr bool shared = true;
+            static constexpr bool split = false;
+        };
+
+        template <typename Component>
+        struct QueryTermTraits<Fields<Component>> {
+            using Type = Component;
+            using ChunkArgs = std::tuple<FieldColumns<Type>>;
+            using EntityArgs = std::tuple<FieldColumns<Type>>;
+            static constexpr QueryMatch match = QueryMatch::Required;
+            static constexpr bool bound = true;
+            static constexpr bool shared = false;
+            static constexpr bool split = true;
+        };
+
+        template <typename Callback, typename Arguments>
+        constexpr bool is_applicable_v = false;
+        template <typename Callback, typename... Arguments>
+        constexpr bool is_applicable_v<Callback, std::tuple<Arguments...>> = is_invocable_v<Callback, Arguments...>;
+    } // namespace _detail
+
     /// A Query is used to select a list of Archetypes that provide a particular set of Components,
     /// used to efficiency enumerate all matching Entities.
+    ///
+    /// Components requested as const (or via Read) are read-only; all other bound Components are
+    /// assumed to be written, and the write version of their rows is updated in every visited Chunk.
+    ///
+    /// Besides plain Components, a Query accepts the terms Read, Optional, With, Without, Shared, and Fields.
+    /// Terms are resolved once per Archetype, so callbacks never need to filter individual Entities.
+    /// Only bound terms (plain Components, Read, Optional, Shared, and Fields) are passed to callbacks, in order.
+    ///
     template <typename... Components>
     class Query {
+        // callback parameters, with unbound terms omitted
+        using _ChunkArgs = decltype(std::tuple_cat(
+            std::declval<std::tuple<size_t, EntityId const*>>(),
+            std::declval<typename _detail::QueryTermTraits<Components>::ChunkArgs>()...));
+        using _EntityArgs = decltype(std::tuple_cat(
+            std::declval<std::tuple<EntityId>>(),
+            std::declval<typename _detail::QueryTermTraits<Components>::EntityArgs>()...));
+
     public:
         static_assert(sizeof...(Components) != 0, "Empty Query objects are not allowed");
 
@@ -28,9 +216,7 @@ namespace up {
         /// This is the primary mechanism for finding or mutating Entities.
         ///
         template <typename Callback>
-        void selectChunks(
-            World& world,
-            Callback&& callback) requires is_invocable_v<Callback, size_t, EntityId const*, Components*...>;
+        void selectChunks(World& world, Callback&& callback) requires _detail::is_applicable_v<Callback, _ChunkArgs>;
 
         /// Given a World and a callback, finds all matching Archetypes, and invokes the
         /// callback once for each entity.
@@ -38,86 +224,520 @@ namespace up {
         /// This is the primary mechanism for finding or mutating Entities.
         ///
         template <typename Callback>
-        void select(World& world, Callback&& callback) requires is_invocable_v<Callback, EntityId, Components&...>;
+        void select(World& world, Callback&& callback) requires _detail::is_applicable_v<Callback, _EntityArgs>;
+
+        /// Variant of selectChunks that only visits Chunks in which any of the Query's
+        /// Components may have changed since the last call to selectChunksChanged or
+        /// selectChanged on this Query.
+        ///
+        /// Changes made by this Query itself are not reported back to it. Only the last World
+        /// is remembered, so every Chunk is visited the first time a different World is given.
+        ///
+        template <typename Callback>
+        void selectChunksChanged(World& world, Callback&& callback) requires
+            _detail::is_applicable_v<Callback, _ChunkArgs>;
+
+        /// Variant of select that only visits Entities in Chunks which may have changed.
+        ///
+        /// @see selectChunksChanged
+        ///
+        template <typename Callback>
+        void selectChanged(World& world, Callback&& callback) requires _detail::is_applicable_v<Callback, _EntityArgs>;
+
+        /// Parallel variant of selectChunks.
+        ///
+        /// Each matching Chunk is a separate unit of work distributed across the Scheduler's
+        /// workers, so the callback may be invoked concurrently and must be thread-safe. Returns
+        /// once every Chunk has been processed.
+        ///
+        template <typename Callback>
+        void selectChunksParallel(World& world, Scheduler& scheduler, Callback&& callback) requires
+            _detail::is_applicable_v<Callback, _ChunkArgs>;
+
+        /// Parallel variant of select.
+        ///
+        /// Entities in the same Chunk are always processed by the same thread, but the callback
+        /// may be invoked concurrently for Entities in different Chunks.
+        ///
+        template <typename Callback>
+        void selectParallel(World& world, Scheduler& scheduler, Callback&& callback) requires
+            _detail::is_applicable_v<Callback, _EntityArgs>;
+
+        /// Variant of selectChunksParallel which visits Archetypes in passes, ordered by a level
+        /// computed from their value of a shared Component.
+        ///
+        /// The Component must be bound with the Shared term. Chunks of the same level are processed
+        /// in parallel, and a level is only started once every lower level is complete, so callbacks
+        /// may read the results of lower levels; e.g. to propagate transforms down a hierarchy one
+        /// depth at a time, see HierarchyDepth.
+        ///
+        template <typename Component, typename Level, typename Callback>
+        void selectChunksParallelByLevel(
+            World& world,
+            Scheduler& scheduler,
+            Level&& level,
+            Callback&& callback) requires _detail::is_applicable_v<Callback, _ChunkArgs> &&
+            is_invocable_v<Level, Component const&>;
+
+        /// Lists the Components bound by this Query and whether they are written.
+        ///
+        /// Components which are only used for matching (With and Without) are not accessed
+        /// and are not listed.
+        ///
+        auto access() -> view<ComponentAccess>;
 
     private:
         struct Match {
             ArchetypeId archetype;
             int offsets[sizeof...(Components)];
+            int versionOffsets[sizeof...(Components)];
+            void const* sharedValues[sizeof...(Components)];
+            view<SplitField> fields[sizeof...(Components)];
         };
 
+        struct ChunkMatch {
+            Chunk* chunk = nullptr;
+            Match const* match = nullptr;
+        };
+
+        struct LevelMatch {
+            uint64 level = 0;
+            Match const* match = nullptr;
+        };
+
+        static constexpr bool _writable[sizeof...(Components)] = {
+            (_detail::QueryTermTraits<Components>::bound &&
+             !std::is_const_v<typename _detail::QueryTermTraits<Components>::Type>)...};
+        static constexpr bool _anyWritable =
+            (false || ... ||
+             (_detail::QueryTermTraits<Components>::bound &&
+              !std::is_const_v<typename _detail::QueryTermTraits<Components>::Type>));
+
+        template <typename Term>
+        static constexpr auto _termIndex() noexcept -> size_t {
+            constexpr bool matches[] = {std::is_same_v<Components, Term>...};
+            for (size_t index = 0; index != sizeof...(Components); ++index) {
+                if (matches[index]) {
+                    return index;
+                }
+            }
+            return sizeof...(Components);
+        }
+
+        void _bind();
         void _match();
+        void _collectChunks(World& world);
+        void _collectChunksOf(World& world, Match const& match);
+        static auto _chunkAt(World& world, ArchetypeId archetype, size_t index) -> Chunk&;
+        auto _lastChangedVersionFor(World& world) noexcept -> uint32;
+        static bool _changedSince(Match const& match, Chunk& chunk, uint32 version) noexcept;
+        static void _markWritten(Match const& match, Chunk& chunk, uint32 version) noexcept;
+        template <typename Term>
+        static auto _chunkArgs(Chunk& chunk, int offset, void const* sharedValue, view<SplitField> fields) noexcept;
+        template <typename Term>
+        static auto _entityArgs(
+            Chunk& chunk,
+            int offset,
+            void const* sharedValue,
+            view<SplitField> fields,
+            unsigned index) noexcept;
         template <typename Callback, size_t... Indices>
-        void _executeChunks(World& world, Callback&& callback, std::index_sequence<Indices...>) const;
+        static void _invokeChunk(
+            Match const& match,
+            Chunk& chunk,
+            Callback& callback,
+            std::index_sequence<Indices...>);
         template <typename Callback, size_t... Indices>
-        void _execute(World& world, Callback&& callback, std::index_sequence<Indices...>) const;
+        static void _invokeEntities(
+            Match const& match,
+            Chunk& chunk,
+            Callback& callback,
+            std::index_sequence<Indices...>);
 
+        QueryBinding _bindings[sizeof...(Components)] = {};
+        /// Components an archetype must and must not have to match, as bits indexed by indexOfComponent.
+        bit_set _required;
+        bit_set _excluded;
+        vector<ComponentAccess> _access;
         vector<Match> _matches;
+        vector<ChunkMatch> _chunkMatches;
+        vector<LevelMatch> _levelMatches;
         size_t _matchIndex = 0;
+        uint32 _lastChangedVersion = 0;
+        uint64 _lastChangedWorld = 0;
+        bool _bound = false;
         rc<EcsSharedContext> _context;
     };
 
     template <typename... Components>
     template <typename Callback>
-    void Query<Components...>::selectChunks(
-        World& world,
-        Callback&& callback) requires is_invocable_v<Callback, size_t, EntityId const*, Components*...> {
+    void Query<Components...>::selectChunks(World& world, Callback&& callback) requires
+        _detail::is_applicable_v<Callback, _ChunkArgs> {
+        _match();
+        uint32 const version = world.advanceVersion();
+        for (auto const& match : _matches) {
+            auto const chunkCount = world.chunksOf(match.archetype).size();
+            for (size_t index = 0; index != chunkCount; ++index) {
+                Chunk& chunk = _chunkAt(world, match.archetype, index);
+                _markWritten(match, chunk, version);
+                _invokeChunk(match, chunk, callback, std::make_index_sequence<sizeof...(Components)>{});
+            }
+        }
+    }
+
+    template <typename... Components>
+    template <typename Callback>
+    void Query<Components...>::select(World& world, Callback&& callback) requires
+        _detail::is_applicable_v<Callback, _EntityArgs> {
+        _match();
+        uint32 const version = world.advanceVersion();
+        for (auto const& match : _matches) {
+            auto const chunkCount = world.chunksOf(match.archetype).size();
+            for (size_t index = 0; index != chunkCount; ++index) {
+                Chunk& chunk = _chunkAt(world, match.archetype, index);
+                _markWritten(match, chunk, version);
+                _invokeEntities(match, chunk, callback, std::make_index_sequence<sizeof...(Components)>{});
+            }
+        }
+    }
+
+    template <typename... Components>
+    template <typename Callback>
+    void Query<Components...>::selectChunksChanged(World& world, Callback&& callback) requires
+        _detail::is_applicable_v<Callback, _ChunkArgs> {
+        _match();
+        uint32 const since = _lastChangedVersionFor(world);
+        uint32 const version = _lastChangedVersion = world.advanceVersion();
+        for (auto const& match : _matches) {
+            auto const chunks = world.chunksOf(match.archetype);
+            for (size_t index = 0; index != chunks.size(); ++index) {
+                // only chunks which are actually visited need to be made writable
+                if (_changedSince(match, *chunks[index], since)) {
+                    Chunk& chunk = _chunkAt(world, match.archetype, index);
+                    _markWritten(match, chunk, version);
+                    _invokeChunk(match, chunk, callback, std::make_index_sequence<sizeof...(Components)>{});
+                }
+            }
+        }
+    }
+
+    template <typename... Components>
+    template <typename Callback>
+    void Query<Components...>::selectChanged(World& world, Callback&& callback) requires
+        _detail::is_applicable_v<Callback, _EntityArgs> {
+        _match();
+        uint32 const since = _lastChangedVersionFor(world);
+        uint32 const version = _lastChangedVersion = world.advanceVersion();
+        for (auto const& match : _matches) {
+            auto const chunks = world.chunksOf(match.archetype);
+            for (size_t index = 0; index != chunks.size(); ++index) {
+                // only chunks which are actually visited need to be made writable
+                if (_changedSince(match, *chunks[index], since)) {
+                    Chunk& chunk = _chunkAt(world, match.archetype, index);
+                    _markWritten(match, chunk, version);
+                    _invokeEntities(match, chunk, callback, std::make_index_sequence<sizeof...(Components)>{});
+                }
+            }
+        }
+    }
+
+    template <typename... Components>
+    template <typename Callback>
+    void Query<Components...>::selectChunksParallel(World& world, Scheduler& scheduler, Callback&& callback) requires
+        _detail::is_applicable_v<Callback, _ChunkArgs> {
         _match();
-        _executeChunks(world, callback, std::make_index_sequence<sizeof...(Components)>{});
+        _collectChunks(world);
+        uint32 const version = world.advanceVersion();
+        scheduler.parallelFor(_chunkMatches.size(), [this, &callback, version](size_t index) {
+            auto const& item = _chunkMatches[index];
+            _markWritten(*item.match, *item.chunk, version);
+            _invokeChunk(*item.match, *item.chunk, callback, std::make_index_sequence<sizeof...(Components)>{});
+        });
     }
 
     template <typename... Components>
     template <typename Callback>
-    void Query<Components...>::select(
+    void Query<Components...>::selectParallel(World& world, Scheduler& scheduler, Callback&& callback) requires
+        _detail::is_applicable_v<Callback, _EntityArgs> {
+        _match();
+        _collectChunks(world);
+        uint32 const version = world.advanceVersion();
+        scheduler.parallelFor(_chunkMatches.size(), [this, &callback, version](size_t index) {
+            auto const& item = _chunkMatches[index];
+            _markWritten(*item.match, *item.chunk, version);
+            _invokeEntities(*item.match, *item.chunk, callback, std::make_index_sequence<sizeof...(Components)>{});
+        });
+    }
+
+    template <typename... Components>
+    template <typename Component, typename Level, typename Callback>
+    void Query<Components...>::selectChunksParallelByLevel(
         World& world,
-        Callback&& callback) requires is_invocable_v<Callback, EntityId, Components&...> {
+        Scheduler& scheduler,
+        Level&& level,
+        Callback&& callback) requires _detail::is_applicable_v<Callback, _ChunkArgs> &&
+        is_invocable_v<Level, Component const&> {
+        constexpr size_t term = _termIndex<Shared<Component>>();
+        static_assert(term != sizeof...(Components), "Levels must be computed from a Component bound with Shared");
+
         _match();
-        _execute(world, callback, std::make_index_sequence<sizeof...(Components)>{});
+
+        // the level of an archetype is fixed by its shared value, but is cheap enough to compute on every call
+        _levelMatches.clear();
+        for (auto const& match : _matches) {
+            auto const& value = *static_cast<Component const*>(match.sharedValues[term]);
+            _levelMatches.push_back({static_cast<uint64>(level(value)), &match});
+        }
+        std::sort(_levelMatches.begin(), _levelMatches.end(), [](LevelMatch const& lhs, LevelMatch const& rhs) {
+            return lhs.level < rhs.level;
+        });
+
+        uint32 const version = world.advanceVersion();
+        for (size_t first = 0, last = 0; first != _levelMatches.size(); first = last) {
+            _chunkMatches.clear();
+            for (last = first; last != _levelMatches.size() && _levelMatches[last].level == _levelMatches[first].level;
+                 ++last) {
+                _collectChunksOf(world, *_levelMatches[last].match);
+            }
+            scheduler.parallelFor(_chunkMatches.size(), [this, &callback, version](size_t index) {
+                auto const& item = _chunkMatches[index];
+                _markWritten(*item.match, *item.chunk, version);
+                _invokeChunk(*item.match, *item.chunk, callback, std::make_index_sequence<sizeof...(Components)>{});
+            });
+        }
+    }
+
+    template <typename... Components>
+    auto Query<Components...>::access() -> view<ComponentAccess> {
+        _bind();
+        return _access;
+    }
+
+    template <typename... Components>
+    void Query<Components...>::_bind() {
+        if (_bound) {
+            return;
+        }
+
+        QueryBinding const bindings[sizeof...(Components)] = {
+            {static_cast<ComponentId>(
+                 _context->template findComponentByType<typename _detail::QueryTermTraits<Components>::Type>()->hash),
+             _detail::QueryTermTraits<Components>::match}...};
+
+        for (size_t index = 0; index != sizeof...(Components); ++index) {
+            _bindings[index] = bindings[index];
+
+            auto const componentIndex = static_cast<size_t>(_context->indexOfComponent(bindings[index].component));
+            if (bindings[index].match == QueryMatch::Required) {
+                _required.set(componentIndex);
+            }
+            else if (bindings[index].match == QueryMatch::Excluded) {
+                _excluded.set(componentIndex);
+            }
+        }
+
+        bool const bound[sizeof...(Components)] = {_detail::QueryTermTraits<Components>::bound...};
+        bool const shared[sizeof...(Components)] = {_detail::QueryTermTraits<Components>::shared...};
+        bool const split[sizeof...(Components)] = {_detail::QueryTermTraits<Components>::split...};
+        for (size_t index = 0; index != sizeof...(Components); ++index) {
+            if (bound[index]) {
+                UP_ASSERT(
+                    shared[index] == _context->isSharedComponent(_bindings[index].component),
+                    "Shared components must be bound with the Shared query term, and only they may be");
+                UP_ASSERT(
+                    split[index] == !_context->splitFieldsOf(_bindings[index].component).empty(),
+                    "Split components must be bound with the Fields query term, and only they may be");
+                _access.push_back({_bindings[index].component, _writable[index]});
+            }
+        }
+
+        _bound = true;
     }
 
     template <typename... Components>
     void Query<Components...>::_match() {
-        if (_matchIndex >= _context->archetypes.size()) {
+        auto const archetypeCount = _context->archetypeCount();
+        if (_matchIndex >= archetypeCount) {
             return;
         }
 
-        ComponentId const components[sizeof...(Components)] = {
-            static_cast<ComponentId>(_context->findComponentByType<Components>()->hash)...};
+        _bind();
+
+        // matches are cached, so only archetypes created since the last call are considered
+        for (; _matchIndex < archetypeCount; ++_matchIndex) {
+            // most archetypes are rejected by comparing component sets, without searching their layouts
+            bit_set const& components = _context->componentsOf(ArchetypeId(_matchIndex));
+            if (!components.has_all(_required) || components.has_any(_excluded)) {
+                continue;
+            }
 
-        for (; _matchIndex < _context->archetypes.size(); ++_matchIndex) {
             auto& match = _matches.push_back({ArchetypeId(_matchIndex)});
-            if (!_context->_bindArchetypeOffets(match.archetype, components, match.offsets)) {
+            if (!_context->_bindArchetypeOffets(
+                    match.archetype,
+                    _bindings,
+                    match.offsets,
+                    match.versionOffsets,
+                    match.sharedValues)) {
                 _matches.pop_back();
+                continue;
+            }
+            for (size_t index = 0; index != sizeof...(Components); ++index) {
+                match.fields[index] = _context->splitFieldsOf(_bindings[index].component);
             }
         }
     }
 
     template <typename... Components>
-    template <typename Callback, size_t... Indices>
-    void Query<Components...>::_executeChunks(World& world, Callback&& callback, std::index_sequence<Indices...>)
-        const {
+    void Query<Components...>::_collectChunks(World& world) {
+        _chunkMatches.clear();
         for (auto const& match : _matches) {
-            for (auto const& chunk : world.chunksOf(match.archetype)) {
-                callback(
-                    chunk->header.entities,
-                    static_cast<EntityId const*>(static_cast<void*>(chunk->payload)),
-                    static_cast<Components*>(static_cast<void*>(chunk->payload + match.offsets[Indices]))...);
+            _collectChunksOf(world, match);
+        }
+    }
+
+    template <typename... Components>
+    void Query<Components...>::_collectChunksOf(World& world, Match const& match) {
+        auto const chunkCount = world.chunksOf(match.archetype).size();
+        for (size_t index = 0; index != chunkCount; ++index) {
+            _chunkMatches.push_back({&_chunkAt(world, match.archetype, index), &match});
+        }
+    }
+
+    template <typename... Components>
+    auto Query<Components...>::_chunkAt(World& world, ArchetypeId archetype, size_t index) -> Chunk& {
+        // a chunk shared with a cloned world must be copied before it can be written
+        if constexpr (_anyWritable) {
+            return *world._writableChunk(archetype, static_cast<uint32>(index));
+        }
+        else {
+            return *world.chunksOf(archetype)[index];
+        }
+    }
+
+    template <typename... Components>
+    auto Query<Components...>::_lastChangedVersionFor(World& world) noexcept -> uint32 {
+        if (world.serial() == _lastChangedWorld) {
+            return _lastChangedVersion;
+        }
+
+        // versions are compared with wrap-around, so the oldest comparable version makes every chunk new
+        _lastChangedWorld = world.serial();
+        return world.version() - static_cast<uint32>(std::numeric_limits<int32>::max());
+    }
+
+    template <typename... Components>
+    bool Query<Components...>::_changedSince(Match const& match, Chunk& chunk, uint32 version) noexcept {
+        for (int const versionOffset : match.versionOffsets) {
+            if (versionOffset >= 0 && isNewerVersion(chunk.rowVersion(static_cast<uint32>(versionOffset)), version)) {
+                return true;
             }
         }
+        return false;
     }
 
     template <typename... Components>
-    template <typename Callback, size_t... Indices>
-    void Query<Components...>::_execute(World& world, Callback&& callback, std::index_sequence<Indices...>) const {
-        for (auto const& match : _matches) {
-            for (auto const& chunk : world.chunksOf(match.archetype)) {
-                for (unsigned index = 0; index < chunk->header.entities; ++index) {
-                    callback(
-                        *(static_cast<EntityId*>(static_cast<void*>(chunk->payload)) + index),
-                        *(static_cast<Components*>(static_cast<void*>(chunk->payload + match.offsets[Indices])) +
-                          index)...);
-                }
+    void Query<Components...>::_markWritten(Match const& match, Chunk& chunk, uint32 version) noexcept {
+        for (size_t index = 0; index != sizeof...(Components); ++index) {
+            if (_writable[index] && match.versionOffsets[index] >= 0) {
+                chunk.rowVersion(static_cast<uint32>(match.versionOffsets[index])) = version;
             }
         }
     }
+
+    template <typename... Components>
+    template <typename Term>
+    auto Query<Components...>::_chunkArgs(
+        Chunk& chunk,
+        int offset,
+        void const* sharedValue,
+        view<SplitField> fields) noexcept {
+        using Traits = _detail::QueryTermTraits<Term>;
+        using Type = typename Traits::Type;
+
+        if constexpr (!Traits::bound) {
+            return std::tuple<>{};
+        }
+        else if constexpr (Traits::shared) {
+            return std::tuple<Type&>{*static_cast<Type*>(sharedValue)};
+        }
+        else if constexpr (Traits::split) {
+            return std::tuple<FieldColumns<Type>>{
+                FieldColumns<Type>(chunk.payload + offset, chunk.header.capacity, 0, chunk.header.entities, fields)};
+        }
+        else {
+            return std::tuple<Type*>{
+                offset >= 0 ? static_cast<Type*>(static_cast<void*>(chunk.payload + offset)) : nullptr};
+        }
+    }
+
+    template <typename... Components>
+    template <typename Term>
+    auto Query<Components...>::_entityArgs(
+        Chunk& chunk,
+        int offset,
+        void const* sharedValue,
+        view<SplitField> fields,
+        unsigned index) noexcept {
+        using Traits = _detail::QueryTermTraits<Term>;
+        using Type = typename Traits::Type;
+
+        if constexpr (!Traits::bound) {
+            return std::tuple<>{};
+        }
+        else if constexpr (Traits::shared) {
+            return std::tuple<Type&>{*static_cast<Type*>(sharedValue)};
+        }
+        else if constexpr (Traits::split) {
+            return std::tuple<FieldColumns<Type>>{
+                FieldColumns<Type>(chunk.payload + offset, chunk.header.capacity, index, 1, fields)};
+        }
+        else if constexpr (Traits::match == QueryMatch::Optional) {
+            return std::tuple<Type*>{
+                offset >= 0 ? static_cast<Type*>(static_cast<void*>(chunk.payload + offset)) + index : nullptr};
+        }
+        else {
+            return std::tuple<Type&>{*(static_cast<Type*>(static_cast<void*>(chunk.payload + offset)) + index)};
+        }
+    }
+
+    template <typename... Components>
+    template <typename Callback, size_t... Indices>
+    void Query<Components...>::_invokeChunk(
+        Match const& match,
+        Chunk& chunk,
+        Callback& callback,
+        std::index_sequence<Indices...>) {
+        std::apply(
+            callback,
+            std::tuple_cat(
+                std::tuple<size_t, EntityId const*>{
+                    chunk.header.entities,
+                    static_cast<EntityId const*>(static_cast<void*>(chunk.payload))},
+                _chunkArgs<Components>(
+                    chunk,
+                    match.offsets[Indices],
+                    match.sharedValues[Indices],
+                    match.fields[Indices])...));
+    }
+
+    template <typename... Components>
+    template <typename Callback, size_t... Indices>
+    void Query<Components...>::_invokeEntities(
+        Match const& match,
+        Chunk& chunk,
+        Callback& callback,
+        std::index_sequence<Indices...>) {
+        for (unsigned index = 0; index < chunk.header.entities; ++index) {
+            std::apply(
+                callback,
+                std::tuple_cat(
+                    std::tuple<EntityId>{*(static_cast<EntityId*>(static_cast<void*>(chunk.payload)) + index)},
+                    _entityArgs<Components>(
+                        chunk,
+                        match.offsets[Indices],
+                        match.sharedValues[Indices],
+                        match.fields[Indices],
+                        index)...));
+        }
+    }
 } // namespace up
@@ -4,65 +4,340 @@
 
 #include "_export.h"
 #include "chunk.h"
+#include "chunk_allocator.h"
 #include "layout.h"
 
+#include "potato/runtime/spinlock.h"
+#include "potato/spud/bit_set.h"
 #include "potato/spud/box.h"
+#include "potato/spud/hash.h"
+#include "potato/spud/hash_map.h"
 #include "potato/spud/int_types.h"
 #include "potato/spud/rc.h"
 #include "potato/spud/span.h"
+#include "potato/spud/string_view.h"
 #include "potato/spud/vector.h"
 
+#include <atomic>
+#include <mutex>
+
 namespace up {
+    namespace _detail {
+        /// @brief Allocates contiguous runs of elements which never move once allocated.
+        ///
+        /// Runs are carved out of fixed-size blocks, so pointers into earlier runs remain valid
+        /// while new runs are allocated; this lets other threads read published runs without locking.
+        ///
+        template <typename T>
+        class StableBlocks {
+        public:
+            static constexpr size_t blockSize = 1024;
+
+            auto allocate(size_t count) -> span<T> {
+                if (_blocks.empty() || _blocks.back().capacity() - _blocks.back().size() < count) {
+                    _blocks.emplace_back().reserve(count > blockSize ? count : blockSize);
+                }
+                auto& block = _blocks.back();
+                auto const offset = block.size();
+                block.resize(offset + count);
+                return span<T>(block.data() + offset, count);
+            }
+
+        private:
+            vector<vector<T>> _blocks;
+        };
+    } // namespace _detail
+
+    /// @brief State shared by every World, Query, and command buffer created from a Universe.
+    ///
+    /// Archetype layouts may be read from any thread without locking; creating archetypes and
+    /// allocating chunks are internally synchronized, so Worlds sharing a context may be ticked
+    /// on different threads. Components must all be registered before that point.
+    ///
     struct EcsSharedContext : shared<EcsSharedContext> {
         struct ArchetypeLayout {
-            uint32 layoutOffset = 0;
+            LayoutRow* rows = nullptr;
             uint16 layoutLength = 0;
             uint16 maxEntitiesPerChunk = 0;
+            /// Size of every chunk allocated to the archetype; see minEntitiesPerNewChunk.
+            ChunkSizeClass sizeClass = ChunkSizeClass::Medium;
+            /// Size of chunk the width of the archetype's entities calls for, once it has enough of them.
+            ChunkSizeClass preferredSizeClass = ChunkSizeClass::Medium;
+            /// A bit per component in the archetype, indexed by indexOfComponent.
+            bit_set components;
+            /// Set if any row holds a shared value, which the archetype's live chunks keep constructed.
+            bool hasSharedValues = false;
         };
 
+        /// Archetypes are stored in fixed pages, so that layouts never move once created.
+        static constexpr uint32 archetypesPerPage = 256;
+        static constexpr uint32 maxArchetypePages = 4096;
+
+        /// Threads are spread across this many caches of recycled chunks, each bounded by maxCachedChunks.
+        static constexpr uint32 chunkCacheCount = 8;
+        static constexpr uint32 maxCachedChunks = 16;
+
+        /// An archetype prefers the smallest chunks that still hold at least this many of its entities.
+        ///
+        /// Kept low enough that typical rendered objects fit Small or Medium chunks; only very wide
+        /// archetypes need Large chunks to reach a worthwhile batch.
+        static constexpr uint32 minEntitiesPerChunk = 128;
+
+        /// New archetypes start in the smallest chunks holding at least this many of their entities.
+        ///
+        /// An archetype whose preferred chunks are larger is promoted once it has promoteAfterChunks
+        /// live chunks: a variant with the same components and larger chunks is created, and new
+        /// entities are placed in the variant from then on. Entities already placed stay where they are.
+        ///
+        static constexpr uint32 minEntitiesPerNewChunk = 16;
+        static constexpr uint32 promoteAfterChunks = 4;
+
         struct FindResult {
             bool success = false;
             ArchetypeId archetype = ArchetypeId::Empty;
         };
 
+        /// @brief Identifies an edge in the archetype graph; an archetype plus the component being added or removed.
+        struct ArchetypeEdgeKey {
+            ArchetypeId archetype = ArchetypeId::Empty;
+            ComponentId component = ComponentId::Unknown;
+
+            constexpr bool operator==(ArchetypeEdgeKey const&) const noexcept = default;
+
+            template <typename HashAlgorithm>
+            friend void hash_append(HashAlgorithm& hasher, ArchetypeEdgeKey const& key) noexcept {
+                hash_append(hasher, key.archetype);
+                hash_append(hasher, key.component);
+            }
+        };
+
+        /// @brief Cached result of walking an edge in the archetype graph.
+        struct ArchetypeEdge {
+            ArchetypeId target = ArchetypeId::Empty;
+            /// The edge's row map; see rowMapOf.
+            int16 const* rowMap = nullptr;
+            uint16 rowMapLength = 0;
+        };
+
+        /// @brief Registers a new component type.
+        ///
+        /// Registered components are assigned a small dense index, in registration order.
+        /// Shared components must have a schema, which is used to compare their values.
+        ///
+        void registerComponent(reflex::TypeInfo const& typeInfo, bool shared = false);
+
+        /// @brief Retrieves the dense index of a registered component.
+        ///
+        /// Dense indices are small and contiguous, suitable for use in bitsets or lookup tables.
+        ///
+        /// @return the index of the component, or -1 if the component is not registered.
+        UP_ECS_API auto indexOfComponent(ComponentId id) const noexcept -> int;
+
+        /// @brief Checks if a component was registered as shared; see Universe::registerSharedComponent.
+        auto isSharedComponent(ComponentId id) const noexcept -> bool;
+
+        /// @brief Retrieves the sub-columns of a component annotated with SplitFields; empty for other components.
+        UP_ECS_API auto splitFieldsOf(ComponentId id) const noexcept -> view<SplitField>;
+
         auto findComponentById(ComponentId id) const noexcept -> reflex::TypeInfo const*;
         auto findComponentByName(string_view name) const noexcept -> reflex::TypeInfo const*;
 
         template <typename Component>
         auto findComponentByType() const noexcept -> reflex::TypeInfo const*;
 
-        auto acquireChunk() -> Chunk*;
+        EcsSharedContext();
+        ~EcsSharedContext();
+
+        /// @brief Allocates a chunk for an archetype, preferring one recently recycled by the calling thread.
+        ///
+        /// The archetype's shared values are kept constructed until each of its chunks is recycled.
+        /// Allocating chunks may promote the archetype; see promoteAfterChunks.
+        ///
+        auto acquireChunk(ArchetypeId archetype) -> Chunk*;
         void recycleChunk(Chunk* chunk) noexcept;
 
+        /// @brief Reports chunk memory usage; chunks held in the chunk caches are counted as free.
+        auto chunkMemoryStats() const noexcept -> ChunkMemoryStats;
+
+        /// @brief Sets how much free chunk memory is kept for reuse, including chunks held in the chunk caches.
+        ///
+        /// The chunk caches divide the budget evenly between chunk size classes.
+        ///
+        void setChunkRetainedBytes(size_t bytes) noexcept;
+
+        /// @brief Number of archetypes created so far; archetypes below this count may be safely read.
+        auto archetypeCount() const noexcept -> size_t { return _archetypeCount.load(std::memory_order_acquire); }
+
+        inline auto archetypeLayout(ArchetypeId archetype) const noexcept -> ArchetypeLayout const&;
         inline auto layoutOf(ArchetypeId archetype) const noexcept -> view<LayoutRow>;
 
+        /// @brief Retrieves the set of components in an archetype, as bits indexed by indexOfComponent.
+        ///
+        /// Comparing sets is much cheaper than searching a layout, e.g. to reject archetypes a Query does not match.
+        ///
+        inline auto componentsOf(ArchetypeId archetype) const noexcept -> bit_set const&;
+
+        /// @brief Finds or creates the archetype for an original archetype's components with some added or removed.
+        ///
+        /// Adding or removing a single component is resolved through cached edges in the archetype
+        /// graph; other requests are resolved by looking up the resulting component set.
+        ///
+        /// An archetype other than the original resolves to its promoted variant, if any; see promoteAfterChunks.
+        ///
         auto acquireArchetype(
             ArchetypeId original,
             view<reflex::TypeInfo const*> include,
             view<reflex::TypeInfo const*> exclude) -> ArchetypeId;
 
+        /// @brief Finds or creates the edge from an archetype to the archetype with one more component.
+        auto acquireAddEdge(ArchetypeId original, reflex::TypeInfo const& typeInfo) -> ArchetypeEdge;
+
+        /// @brief Finds or creates the edge from an archetype to the archetype with one less component.
+        auto acquireRemoveEdge(ArchetypeId original, reflex::TypeInfo const& typeInfo) -> ArchetypeEdge;
+
+        /// @brief Finds or creates the edge from an archetype to the archetype holding a value of a shared component.
+        ///
+        /// The component is added if the original archetype lacks it, and its value replaced otherwise.
+        /// Archetypes are only created for shared components through this edge, or with a default
+        /// constructed value when added through acquireArchetype or acquireAddEdge.
+        ///
+        auto acquireSharedEdge(ArchetypeId original, reflex::TypeInfo const& typeInfo, void const* value)
+            -> ArchetypeEdge;
+
+        /// @brief Retrieves how the rows of an edge's original archetype map onto its target archetype.
+        ///
+        /// There is one entry per row of the original layout, holding the index of the same
+        /// component's row in the target layout, or -1 if the target lacks that component.
+        ///
+        auto rowMapOf(ArchetypeEdge const& edge) const noexcept -> view<int16> {
+            return view<int16>(edge.rowMap, edge.rowMapLength);
+        }
+
         UP_ECS_API auto _findComponentByTypeHash(uint64 typeHash) const noexcept -> reflex::TypeInfo const*;
-        UP_ECS_API auto _bindArchetypeOffets(ArchetypeId archetype, view<ComponentId> componentIds, span<int> offsets)
-            const noexcept -> bool;
+        UP_ECS_API auto _bindArchetypeOffets(
+            ArchetypeId archetype,
+            view<QueryBinding> bindings,
+            span<int> offsets,
+            span<int> versionOffsets,
+            span<void const*> sharedValues) const noexcept -> bool;
 
         vector<reflex::TypeInfo const*> components;
-        vector<ArchetypeLayout> archetypes = {ArchetypeLayout{0, 0, sizeof(Chunk::Payload) / sizeof(EntityId)}};
-        vector<LayoutRow> chunkRows;
-        vector<box<Chunk>> allocatedChunks;
-        Chunk* freeChunkHead = nullptr;
+
+    private:
+        struct alignas(64) ChunkCache {
+            Spinlock lock;
+            Chunk* head = nullptr;
+            uint32 count = 0;
+        };
+
+        static constexpr uint32 noSharedValue = 0xFFFFFFFF;
+
+        /// A distinct value of a shared component.
+        ///
+        /// The value's memory and encoding are kept for as long as the context, as archetypes refer
+        /// to the value by address. The value itself is destroyed once no archetype using it has a
+        /// live chunk, releasing anything it holds, and is decoded again when it is next used.
+        ///
+        struct SharedValue {
+            reflex::TypeInfo const* typeInfo = nullptr;
+            void* data = nullptr;
+            vector<byte> encoding;
+            /// The next value whose hash collides with this one's, or noSharedValue.
+            uint32 nextWithHash = noSharedValue;
+            /// Number of archetypes holding the value which have live chunks.
+            uint32 liveArchetypes = 0;
+            bool constructed = true;
+        };
+
+        /// Identifies the edge to the archetype holding a specific shared value.
+        struct SharedEdgeKey {
+            ArchetypeId archetype = ArchetypeId::Empty;
+            void const* value = nullptr;
+
+            constexpr bool operator==(SharedEdgeKey const&) const noexcept = default;
+
+            template <typename HashAlgorithm>
+            friend void hash_append(HashAlgorithm& hasher, SharedEdgeKey const& key) noexcept {
+                hash_append(hasher, key.archetype);
+                hash_append(hasher, reinterpret_cast<uintptr>(key.value));
+            }
+        };
+
+        auto _acquireChunk(ChunkSizeClass sizeClass) -> Chunk*;
+        void _retainArchetype(ArchetypeId archetype);
+        void _releaseArchetype(ArchetypeId archetype) noexcept;
+        void _promoteArchetype(ArchetypeId archetype);
+        auto _promotedEdge(ArchetypeId original, ArchetypeEdge edge) const noexcept -> ArchetypeEdge;
+        void _trimChunkCaches(ChunkSizeClass sizeClass, uint32 limit) noexcept;
+        auto _acquireEdge(ArchetypeId original, reflex::TypeInfo const& typeInfo, bool add) -> ArchetypeEdge;
+        auto _buildRowMap(ArchetypeId original, ArchetypeId target) -> ArchetypeEdge;
+        auto _acquireArchetypeSlow(
+            ArchetypeId original,
+            view<reflex::TypeInfo const*> include,
+            view<reflex::TypeInfo const*> exclude,
+            SharedValue const* shared = nullptr) -> ArchetypeId;
+        auto _findArchetype(uint64 signature, view<LayoutRow> rows) noexcept -> FindResult;
+        auto _createArchetype(uint64 signature, view<LayoutRow> rows, bool promoted = false) -> ArchetypeId;
+        void _indexArchetype(uint64 signature, ArchetypeId archetype);
+        auto _internSharedValue(reflex::TypeInfo const& typeInfo, void const* value) -> SharedValue const&;
+        auto _defaultSharedValue(reflex::TypeInfo const& typeInfo) -> SharedValue const&;
+        auto _publishArchetype(ArchetypeLayout layout) -> ArchetypeId;
+
+        // guards archetype creation and the edge cache; layouts are published through _archetypeCount
+        std::mutex _archetypeLock;
+        ArchetypeLayout* _archetypePages[maxArchetypePages] = {};
+        std::atomic<size_t> _archetypeCount = 0;
+        vector<vector<ArchetypeLayout>> _archetypeStorage;
+        _detail::StableBlocks<LayoutRow> _layoutRows;
+        _detail::StableBlocks<int16> _edgeRowMaps;
+
+        mutable std::mutex _chunkLock;
+        ChunkAllocator _chunkAllocator;
+        mutable ChunkCache _chunkCaches[chunkSizeClassCount][chunkCacheCount];
+        std::atomic<uint32> _chunkCacheLimits[chunkSizeClassCount] = {};
+
+        hash_map<uint64, uint32> _componentsByHash;
+        hash_map<string_view, uint32> _componentsByName;
+        hash_map<ArchetypeEdgeKey, ArchetypeEdge> _addEdges;
+        hash_map<ArchetypeEdgeKey, ArchetypeEdge> _removeEdges;
+        hash_map<SharedEdgeKey, ArchetypeEdge> _sharedEdges;
+        hash_map<uint64, ArchetypeId> _archetypesBySignature;
+        // the next archetype with the same signature, indexed by archetype; Empty ends the chain
+        vector<ArchetypeId> _nextWithSignature;
+        vector<LayoutRow> _scratchRows;
+
+        vector<bool> _sharedComponents;
+        vector<vector<SplitField>> _splitFields;
+        vector<box<SharedValue>> _sharedValues;
+        // the first value indexed with each hash, which heads the chain of values colliding with it
+        hash_map<uint64, uint32> _sharedValuesByHash;
+        hash_map<uintptr, uint32> _sharedValuesByData;
+        // live chunks of each archetype with shared values or still to be promoted, across all worlds,
+        // indexed by archetype; guarded by _archetypeLock
+        vector<uint32> _liveChunks;
+        // the variant each archetype was promoted to, indexed by archetype; Empty if not promoted
+        vector<ArchetypeId> _promotedTo;
     };
 
     template <typename Component>
     auto EcsSharedContext::findComponentByType() const noexcept -> reflex::TypeInfo const* {
-        static const uint64 hash = reflex::TypeHolder<Component>::get().hash;
+        static const uint64 hash = reflex::getTypeInfo<Component>().hash;
         return _findComponentByTypeHash(hash);
     }
 
-    auto EcsSharedContext::layoutOf(ArchetypeId archetype) const noexcept -> view<LayoutRow> {
+    auto EcsSharedContext::archetypeLayout(ArchetypeId archetype) const noexcept -> ArchetypeLayout const& {
         auto const index = to_underlying(archetype);
-        UP_ASSERT(index >= 0 && index < archetypes.size());
-        auto const& arch = archetypes[index];
-        return chunkRows.subspan(arch.layoutOffset, arch.layoutLength);
+        UP_ASSERT(index < _archetypeCount.load(std::memory_order_relaxed));
+        return _archetypePages[index / archetypesPerPage][index % archetypesPerPage];
+    }
+
+    auto EcsSharedContext::layoutOf(ArchetypeId archetype) const noexcept -> view<LayoutRow> {
+        auto const& arch = archetypeLayout(archetype);
+        return view<LayoutRow>(arch.rows, arch.layoutLength);
+    }
+
+    auto EcsSharedContext::componentsOf(ArchetypeId archetype) const noexcept -> bit_set const& {
+        return archetypeLayout(archetype).components;
     }
 
 } // namespace up
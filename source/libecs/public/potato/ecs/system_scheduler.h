@@ -0,0 +1,152 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#pragma once
+
+#include "_export.h"
+#include "command_buffer.h"
+#include "query.h"
+#include "shared_context.h"
+
+#include "potato/spud/box.h"
+#include "potato/spud/concepts.h"
+#include "potato/spud/int_types.h"
+#include "potato/spud/rc.h"
+#include "potato/spud/string.h"
+#include "potato/spud/vector.h"
+
+#include <atomic>
+
+namespace up {
+    class Scheduler;
+    class World;
+
+    /// State handed to a System while it runs.
+    ///
+    /// Systems may run concurrently with any other System that does not conflict with
+    /// them, so structural changes must be recorded into the provided command buffer,
+    /// which is played back once every System has finished.
+    ///
+    struct SystemContext {
+        World& world;
+        Scheduler& scheduler;
+        EntityCommandBuffer& commands;
+    };
+
+    /// Timing of a single System during the last frame run by a SystemScheduler.
+    struct SystemTiming {
+        string_view name;
+        /// Start of the System relative to the start of the frame.
+        uint64 startNanoseconds = 0;
+        uint64 durationNanoseconds = 0;
+        /// Set if the System is on the longest chain of dependent Systems.
+        bool critical = false;
+    };
+
+    /// Runs a set of Systems once per frame, in parallel where their Component access allows.
+    ///
+    /// Each System declares which Components it reads and writes through the signature of
+    /// its Query. Two Systems conflict if they access a common Component and at least one
+    /// of them writes it; conflicting Systems run in the order they were added, while all
+    /// other Systems are free to run concurrently on the Scheduler's workers.
+    ///
+    class SystemScheduler {
+    public:
+        UP_ECS_API SystemScheduler(rc<EcsSharedContext> context, Scheduler& scheduler);
+        UP_ECS_API ~SystemScheduler();
+
+        SystemScheduler(SystemScheduler const&) = delete;
+        SystemScheduler& operator=(SystemScheduler const&) = delete;
+
+        /// Adds a System which is invoked once per frame with its Query.
+        ///
+        /// The callback is given a SystemContext and a Query<Components...> and is free to
+        /// select from the Query however it likes, including in parallel.
+        ///
+        template <typename... Components, typename Callback>
+        void addSystem(string name, Callback&& callback) requires
+            callable<Callback&, SystemContext&, Query<Components...>&>;
+
+        /// Adds a System which is invoked for every Chunk matching Query<Components...>.
+        ///
+        /// Chunks are distributed across the Scheduler's workers, so the callback may be
+        /// invoked concurrently and must be thread-safe.
+        ///
+        template <typename... Components, typename Callback>
+        void addChunkSystem(string name, Callback&& callback);
+
+        /// Runs every System once against the given World and then plays back any
+        /// commands they recorded, in the order the Systems were added.
+        UP_ECS_API void run(World& world);
+
+        /// Timings of every System during the last call to run, in the order the Systems were added.
+        auto timings() const noexcept -> view<SystemTiming> { return _timings; }
+
+        /// Total time taken by the last call to run, excluding command playback.
+        auto frameNanoseconds() const noexcept -> uint64 { return _frameNanoseconds; }
+
+        /// Length of the longest chain of dependent Systems during the last call to run.
+        ///
+        /// This is the lower bound on frameNanoseconds given unlimited workers.
+        ///
+        auto criticalPathNanoseconds() const noexcept -> uint64 { return _criticalPathNanoseconds; }
+
+    private:
+        class System {
+        public:
+            virtual ~System() = default;
+            virtual auto access() -> view<ComponentAccess> = 0;
+            virtual void run(SystemContext& context) = 0;
+        };
+
+        template <typename Callback, typename... Components>
+        class QuerySystem final : public System {
+        public:
+            QuerySystem(Query<Components...> query, Callback callback)
+                : _query(std::move(query))
+                , _callback(std::move(callback)) {}
+
+            auto access() -> view<ComponentAccess> override { return _query.access(); }
+            void run(SystemContext& context) override { _callback(context, _query); }
+
+        private:
+            Query<Components...> _query;
+            Callback _callback;
+        };
+
+        struct Node;
+
+        UP_ECS_API void _addSystem(string name, box<System> system);
+        void _build();
+        void _execute(int index);
+        void _computeCriticalPath();
+
+        rc<EcsSharedContext> _context;
+        Scheduler& _scheduler;
+        vector<box<Node>> _nodes;
+        vector<SystemTiming> _timings;
+        World* _world = nullptr;
+        std::atomic<int> _pending = 0;
+        uint64 _frameStart = 0;
+        uint64 _frameNanoseconds = 0;
+        uint64 _criticalPathNanoseconds = 0;
+        bool _built = false;
+    };
+
+    template <typename... Components, typename Callback>
+    void SystemScheduler::addSystem(string name, Callback&& callback) requires
+        callable<Callback&, SystemContext&, Query<Components...>&> {
+        using SystemType = QuerySystem<std::decay_t<Callback>, Components...>;
+        _addSystem(
+            std::move(name),
+            new_box<SystemType>(Query<Components...>(_context), std::forward<Callback>(callback)));
+    }
+
+    template <typename... Components, typename Callback>
+    void SystemScheduler::addChunkSystem(string name, Callback&& callback) {
+        addSystem<Components...>(
+            std::move(name),
+            [callback = std::forward<Callback>(callback)](SystemContext& context, Query<Components...>& query) mutable {
+                query.selectChunksParallel(context.world, context.scheduler, callback);
+            });
+    }
+} // namespace up
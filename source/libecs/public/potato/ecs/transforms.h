@@ -0,0 +1,24 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#pragma once
+
+#include "_export.h"
+
+#include "potato/spud/span.h"
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+namespace up {
+    /// @brief Composes the matrices of many transforms from their positions and rotations.
+    ///
+    /// Each matrix is equal to glm::translate(position) * glm::mat4_cast(rotation). On x86, four
+    /// transforms are composed at a time, reading positions and rotations as contiguous runs such
+    /// as the sub-columns of a split component.
+    ///
+    UP_ECS_API void composeTransforms(
+        span<glm::vec3 const> positions,
+        span<glm::quat const> rotations,
+        span<glm::mat4x4> out) noexcept;
+} // namespace up
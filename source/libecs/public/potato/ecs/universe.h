@@ -3,7 +3,9 @@
 #pragma once
 
 #include "_export.h"
+#include "command_buffer.h"
 #include "shared_context.h"
+#include "system_scheduler.h"
 #include "world.h"
 
 #include "potato/reflex/schema.h"
@@ -27,6 +29,12 @@ namespace up {
 
         auto createWorld() noexcept -> World { return World(_context); }
 
+        auto createCommandBuffer() -> EntityCommandBuffer { return EntityCommandBuffer(_context); }
+
+        auto createSystemScheduler(Scheduler& scheduler) -> box<SystemScheduler> {
+            return new_box<SystemScheduler>(_context, scheduler);
+        }
+
         template <typename... Components>
         auto createQuery() -> Query<Components...> {
             return Query<Components...>(_context);
@@ -35,12 +43,31 @@ namespace up {
         template <typename Component>
         void registerComponent(zstring_view name);
 
+        /// @brief Registers a component whose value is shared by groups of entities instead of stored per entity.
+        ///
+        /// Each distinct value is stored once, and is part of the identity of an Archetype, so every
+        /// entity in a Chunk holds the same value. Values are compared by their reflex binary encoding.
+        /// Shared components are bound in Queries with the Shared term.
+        ///
+        template <typename Component>
+        void registerSharedComponent(zstring_view name);
+
         UP_ECS_API reflex::TypeInfo const* findComponentByName(string_view name) const noexcept;
 
+        auto isSharedComponent(ComponentId component) const noexcept -> bool {
+            return _context->isSharedComponent(component);
+        }
+
         auto components() const noexcept -> view<reflex::TypeInfo const*> { return _context->components; }
 
+        /// @brief Reports memory used by the Chunks of all Worlds in this Universe.
+        auto chunkMemoryStats() const noexcept -> ChunkMemoryStats { return _context->chunkMemoryStats(); }
+
+        /// @brief Sets how much entirely free Chunk memory is kept for reuse rather than returned to the OS.
+        void setChunkRetainedBytes(size_t bytes) noexcept { _context->setChunkRetainedBytes(bytes); }
+
     private:
-        UP_ECS_API void _registerComponent(reflex::TypeInfo const& typeInfo);
+        UP_ECS_API void _registerComponent(reflex::TypeInfo const& typeInfo, bool shared);
 
         rc<EcsSharedContext> _context;
     };
@@ -48,6 +75,12 @@ namespace up {
     template <typename Component>
     void Universe::registerComponent(zstring_view name) {
         static const reflex::TypeInfo typeInfo = reflex::makeTypeInfo<Component>(name, &reflex::getSchema<Component>());
-        _registerComponent(typeInfo);
+        _registerComponent(typeInfo, false);
+    }
+
+    template <typename Component>
+    void Universe::registerSharedComponent(zstring_view name) {
+        static const reflex::TypeInfo typeInfo = reflex::makeTypeInfo<Component>(name, &reflex::getSchema<Component>());
+        _registerComponent(typeInfo, true);
     }
 } // namespace up
@@ -6,15 +6,52 @@
 #include "chunk.h"
 #include "shared_context.h"
 
+#include "potato/runtime/assertion.h"
 #include "potato/spud/bit_set.h"
 #include "potato/spud/box.h"
 #include "potato/spud/concepts.h"
+#include "potato/spud/delegate.h"
 #include "potato/spud/delegate_ref.h"
 #include "potato/spud/rc.h"
 #include "potato/spud/vector.h"
 
+#include <atomic>
+#include <mutex>
+
 namespace up {
     struct EcsSharedContext;
+    class EntityCommandBuffer;
+
+    /// How densely a World's Chunks are filled.
+    struct ChunkOccupancy {
+        size_t chunks = 0;
+        size_t entities = 0;
+        /// Total number of entities the Chunks could hold.
+        size_t capacity = 0;
+    };
+
+    /// Outcome of a call to World::compact.
+    struct CompactionResult {
+        ChunkOccupancy before;
+        ChunkOccupancy after;
+        size_t movedEntities = 0;
+        /// Set once every archetype has been compacted; otherwise the budget ran out
+        /// and a later call will resume where this one left off.
+        bool complete = false;
+    };
+
+    /// Structural changes reported to the observers of a World.
+    enum class ObserverEvent : uint8 {
+        /// The Component was added to an Entity, including by creating the Entity.
+        Added,
+        /// The Component was removed from an Entity which still exists.
+        Removed,
+        /// An Entity holding the Component was deleted.
+        Deleted,
+    };
+
+    /// Identifies an observer registered with World::observe.
+    enum class ObserverId : uint32 { None = 0 };
 
     /// A world contains a collection of Entities, Archetypes, and their associated Components.
     ///
@@ -28,36 +65,126 @@ namespace up {
         World(World&&) = delete;
         World& operator=(World&&) = delete;
 
+        /// @brief Creates a copy of the world which shares chunk memory with the original.
+        ///
+        /// Cloning only copies the entity table and takes a reference to every chunk. A chunk is
+        /// duplicated the first time either world modifies it, through a mutable Query or a
+        /// structural change, so untouched chunks are never copied and discarding the clone
+        /// only releases the chunks it made private.
+        ///
+        /// Worlds sharing chunks may be updated from different threads, and Queries running
+        /// concurrently on one World may both copy the same chunk; only one copy is kept.
+        ///
+        auto clone() const -> World { return World(*this); }
+
         /// Retrieve the chunks belonging to a specific archetype.
         ///
+        /// The chunks may be shared with a cloned world and must not be modified through
+        /// this view; use a Query to modify components.
+        ///
         /// @returns nullptr if the ArchetypeId is invalid
         ///
         UP_ECS_API auto chunksOf(ArchetypeId archetype) const noexcept -> view<Chunk*>;
 
-        /// @brief View of all chunks allocated in the world.
-        /// @return all chunks in the world.
-        auto chunks() const noexcept -> view<Chunk*> { return _chunks; }
+        /// @brief Number of chunks allocated in the world, across all archetypes.
+        auto chunkCount() const noexcept -> size_t { return _chunkCount; }
+
+        /// @brief Measures how densely the world's chunks are filled.
+        UP_ECS_API auto occupancy() const noexcept -> ChunkOccupancy;
+
+        /// @brief Merges sparsely filled chunks of the same archetype and releases the emptied chunks.
+        ///
+        /// Deleting entities leaves holes spread across many partially filled chunks. Compaction
+        /// drains the emptiest chunks of each archetype into the fullest ones that have room,
+        /// which improves iteration locality and lets the emptied chunks be recycled.
+        ///
+        /// Moves entities between chunks, so it must not be called while a Query is iterating.
+        ///
+        /// @param budget Maximum number of entities to move, so the work can be spread across frames.
+        UP_ECS_API auto compact(size_t budget = ~size_t{0}) -> CompactionResult;
+
+        /// @brief Appends a binary snapshot of every entity and component in the world to a buffer.
+        ///
+        /// Trivially copyable components are written as raw arrays straight out of chunk memory;
+        /// other components are encoded through their reflex schema. Snapshots are meant for fast
+        /// saving and loading against the same set of registered components, not as an interchange
+        /// format.
+        ///
+        /// @returns false if a component could not be encoded.
+        UP_ECS_API auto saveSnapshot(vector<byte>& out) const -> bool;
+
+        /// @brief Restores a snapshot written by saveSnapshot into an empty world.
+        ///
+        /// Chunks are rebuilt per archetype straight from the snapshot, without resolving each
+        /// entity's archetype, and the data is only read; it may come directly from a memory-mapped
+        /// file. Entity ids are preserved.
+        ///
+        /// @returns false if the snapshot is malformed or refers to unknown components, leaving the world empty.
+        UP_ECS_API auto loadSnapshot(view<byte> data) -> bool;
+
+        /// @brief Uniquely identifies the world among all worlds created by the process; a clone gets its own.
+        auto serial() const noexcept -> uint64 { return _serial; }
+
+        /// @brief The most recent write version handed out by the world.
+        auto version() const noexcept -> uint32 { return _version.load(std::memory_order_relaxed); }
+
+        /// @brief Advances the world's write version.
+        ///
+        /// Component rows which may be modified by a subsequent operation are stamped with
+        /// the returned version; see Chunk::rowVersion. Queries running concurrently on the
+        /// world each receive a distinct version.
+        ///
+        /// @return the new version.
+        auto advanceVersion() noexcept -> uint32 { return _version.fetch_add(1, std::memory_order_relaxed) + 1; }
 
         /// Creates a new Entity with the provided list of Component data
         ///
         template <typename... Components>
         EntityId createEntity(Components const&... components) noexcept;
 
+        /// @brief Creates many entities sharing the same set of Components.
+        ///
+        /// Every new entity receives a copy of the provided prototype values. Chunks
+        /// are filled contiguously and trivially copyable components are memcpy'd.
+        ///
+        /// @param count Number of entities to create.
+        /// @param prototypes Component values copied into every new entity.
+        /// @returns the ids of the new entities, in creation order.
+        template <typename... Components>
+        auto createEntities(size_t count, Components const&... prototypes) -> vector<EntityId>;
+
+        /// @brief Creates many entities, one per element of the provided Component views.
+        ///
+        /// All views must have the same length; entity N receives element N of each view.
+        ///
+        /// @returns the ids of the new entities, in creation order.
+        template <typename... Components>
+        auto createEntities(view<Components>... values) -> vector<EntityId>;
+
         /// Deletes an existing Entity
         ///
         UP_ECS_API void deleteEntity(EntityId entity) noexcept;
 
         /// Adds a new Component to an existing Entity.
         ///
-        /// Changes the Entity's Archetype and home Chunk
+        /// Changes the Entity's Archetype and home Chunk. Adding a shared Component which the
+        /// Entity already has replaces its value, which also moves the Entity to another Archetype.
         ///
         template <typename Component>
         void addComponent(EntityId entityId, Component const& component) noexcept;
 
+        /// Adds a copy of a Component to an existing Entity, or replaces the Component's value.
+        ///
+        /// This is a type-unsafe variant of addComponent.
+        ///
+        void addComponentUnsafe(EntityId entityId, reflex::TypeInfo const& typeInfo, void const* data) noexcept {
+            _addComponentRaw(entityId, typeInfo, data);
+        }
+
         /// @brief Add a default-constructed component to an existing entity.
         /// @param entity The entity to add the componet to.
         /// @param typeInfo Metadata for the to-be-added component.
-        /// @returns unsafe raw pointer to the created component.
+        /// @returns unsafe raw pointer to the created component, or nullptr for a split component.
         UP_ECS_API void* addComponentDefault(EntityId entity, reflex::TypeInfo const& typeInfo);
 
         /// Removes a Component from an existing Entity.
@@ -75,12 +202,54 @@ namespace up {
             return removeComponent(entityId, static_cast<ComponentId>(typeInfo->hash));
         }
 
+        /// @brief Registers a callback to be told when Entities gain or lose a Component.
+        ///
+        /// Structural changes only record the affected Entities. The callback receives them in
+        /// a single span when notifyObservers is called, which EntityCommandBuffer::playback does
+        /// once all of its changes are applied. An Entity may have changed again by the time it
+        /// is delivered, and Entities reported as Deleted no longer exist.
+        ///
+        /// Observers belong to this World and are not copied by clone.
+        ///
+        /// @returns an id for removing the observer with unobserve.
+        template <typename Component>
+        auto observe(ObserverEvent event, delegate<void(view<EntityId>)> callback) -> ObserverId {
+            reflex::TypeInfo const* const typeInfo = _context->findComponentByType<Component>();
+            UP_ASSERT(typeInfo != nullptr);
+            return observeUnsafe(event, static_cast<ComponentId>(typeInfo->hash), std::move(callback));
+        }
+
+        /// @brief Registers a callback to be told when Entities gain or lose a Component.
+        ///
+        /// This is a type-unsafe variant of observe.
+        ///
+        UP_ECS_API auto observeUnsafe(
+            ObserverEvent event,
+            ComponentId component,
+            delegate<void(view<EntityId>)> callback) -> ObserverId;
+
+        /// @brief Removes an observer; any changes it has not yet been told about are discarded.
+        UP_ECS_API void unobserve(ObserverId observer) noexcept;
+
+        /// @brief Delivers every structural change recorded since the last notification to the observers.
+        ///
+        /// Changes made by the callbacks themselves are delivered by the next notification.
+        ///
+        UP_ECS_API void notifyObservers();
+
         /// Retrieves a pointer to a Component on the specified Entity.
         ///
         /// This is typically a slow operation. It will incur several table lookups
         /// and searches. This should only be used by tools and debug aids, typically,
         /// and a Query should be used for runtime code.
         ///
+        /// A shared Component's value is held by many Entities, so there is no writable pointer
+        /// and the result is always nullptr; use readComponentSlow to read the value, and
+        /// addComponent to give the Entity a new one.
+        ///
+        /// A split Component's fields are not contiguous, so there is no pointer to return and
+        /// the result is always nullptr; use a Query with Fields or interrogateEntityUnsafe.
+        ///
         template <typename Component>
         Component* getComponentSlow(EntityId entity) noexcept;
 
@@ -90,19 +259,70 @@ namespace up {
         ///
         UP_ECS_API void* getComponentSlowUnsafe(EntityId entity, ComponentId component) noexcept;
 
+        /// @brief Checks if an Entity has a Component, including tags and split Components.
+        UP_ECS_API bool hasComponent(EntityId entity, ComponentId component) const noexcept;
+
+        /// @brief Finds the Archetype an Entity belongs to, or ArchetypeId::Empty if the Entity does not exist.
+        ///
+        /// Entities of the same Archetype hold the same values of shared Components, so grouping
+        /// Entities by Archetype lets a shared value be read once per group.
+        ///
+        UP_ECS_API auto archetypeOf(EntityId entity) const noexcept -> ArchetypeId;
+
+        /// Retrieves a read-only pointer to a Component on the specified Entity.
+        ///
+        /// Unlike getComponentSlow, the Entity's Chunk is neither copied nor marked as changed,
+        /// so this may be called while other threads write to other Chunks, e.g. from a parallel
+        /// Query looking up Entities it does not visit. Split Components still have no pointer
+        /// to return; use readFieldSlow.
+        ///
+        template <typename Component>
+        Component const* readComponentSlow(EntityId entity) const noexcept;
+
+        /// Retrieves a read-only pointer to a field of a Component on the specified Entity.
+        ///
+        /// Works for split Components as well; otherwise behaves like readComponentSlow.
+        ///
+        template <typename Component, typename Field>
+        Field const* readFieldSlow(EntityId entity, Field Component::*member) const noexcept;
+
+        /// Retrieves a read-only pointer to a Component on the specified Entity.
+        ///
+        /// This is a type-unsafe variant of readComponentSlow.
+        ///
+        UP_ECS_API void const* readComponentSlowUnsafe(EntityId entity, ComponentId component) const noexcept;
+
+        /// Retrieves a read-only pointer to the field at an offset within a Component on the specified Entity.
+        ///
+        /// This is a type-unsafe variant of readFieldSlow.
+        ///
+        UP_ECS_API void const* readFieldSlowUnsafe(EntityId entity, ComponentId component, size_t offset)
+            const noexcept;
+
         /// Interrogate an entity and enumerate all of its components.
         ///
+        /// The callback may modify the components, so the entity's chunk is marked as changed.
+        /// Shared components are the exception and must not be modified; see getComponentSlow.
+        /// Split components are handed over as a gathered copy, which is scattered back afterwards.
+        ///
         template <callable<EntityId, ArchetypeId, reflex::TypeInfo const*, void*> Callback>
-        auto interrogateEntityUnsafe(EntityId entity, Callback&& callback) const -> bool {
+        auto interrogateEntityUnsafe(EntityId entity, Callback&& callback) -> bool {
             if (auto [success, archetype, chunkIndex, index] = _parseEntityId(entity); success) {
                 auto const layout = _context->layoutOf(archetype);
-                Chunk* const chunk = _getChunk(archetype, chunkIndex);
+                Chunk* const chunk = _writableChunk(archetype, chunkIndex);
+                _markChanged(archetype, *chunk);
                 for (LayoutRow const& row : layout) {
-                    callback(
-                        entity,
-                        archetype,
-                        row.typeInfo,
-                        static_cast<void*>(chunk->payload + row.offset + row.width * index));
+                    if (row.split()) {
+                        alignas(std::max_align_t) char value[maxSplitComponentSize];
+                        gatherSplitElement(row, chunk->payload, chunk->header.capacity, index, value);
+                        callback(entity, archetype, row.typeInfo, static_cast<void*>(value));
+                        scatterSplitElement(row, chunk->payload, chunk->header.capacity, index, value);
+                        continue;
+                    }
+                    void* const data = row.sharedValue != nullptr
+                        ? const_cast<void*>(row.sharedValue)
+                        : static_cast<void*>(chunk->payload + row.offset + row.width * index);
+                    callback(entity, archetype, row.typeInfo, data);
                 }
                 return true;
             }
@@ -110,48 +330,142 @@ namespace up {
         }
 
     private:
+        friend class EntityCommandBuffer;
+        template <typename...>
+        friend class Query;
+
+        UP_ECS_API World(World const& source);
+
+        /// How component data is provided to _createEntitiesRaw.
+        enum class CreateData {
+            /// One value per component, copied into every new entity.
+            Prototype,
+            /// One contiguous array per component, with an element per new entity.
+            PerEntity,
+            /// One pointer per component per entity, ordered entity-major.
+            Gathered,
+        };
+
+        struct ComponentData {
+            reflex::TypeInfo const* typeInfo = nullptr;
+            void const* data = nullptr;
+        };
+
         struct AllocatedLocation {
             Chunk& chunk;
-            uint16 chunkIndex;
+            uint32 chunkIndex;
             uint16 index;
         };
 
-        struct ArchetypeChunkRange {
-            uint32 offset = 0;
-            uint32 length = 0;
+        struct AllocatedRange {
+            Chunk& chunk;
+            uint32 chunkIndex;
+            uint16 first;
+            uint16 count;
+        };
+
+        /// The chunks belonging to a single archetype.
+        struct ArchetypeChunks {
+            vector<Chunk*> chunks;
+            // indices of the chunks with room for more entities, in no particular order
+            vector<uint32> available;
+            // position of each chunk in available, or notAvailable if the chunk is full
+            vector<uint32> availableSlots;
         };
 
         struct EntityLocation {
             bool success = false;
             ArchetypeId archetype = ArchetypeId::Empty;
-            uint16 chunk = 0;
+            uint32 chunk = 0;
+            uint16 index = 0;
+        };
+
+        /// Where a live entity is stored; entries for free ids instead link to the next free entry.
+        struct EntityMapping {
+            uint32 archetype = 0;
+            /// Index of the chunk within its archetype, or the next free entry's index.
+            uint32 chunk = 0;
             uint16 index = 0;
+            uint16 generation = 0;
+        };
+
+        /// Entity mappings are allocated in fixed pages, so growth never copies existing entries.
+        static constexpr uint32 mappingPageShift = 12;
+        static constexpr uint32 mappingPageSize = 1u << mappingPageShift;
+        struct MappingPage {
+            EntityMapping entries[mappingPageSize];
+        };
+
+        struct Observer {
+            ObserverId id = ObserverId::None;
+            ObserverEvent event = ObserverEvent::Added;
+            ComponentId component = ComponentId::Unknown;
+            delegate<void(view<EntityId>)> callback;
+            /// Entities recorded since the last notification.
+            vector<EntityId> pending;
         };
 
-        static constexpr uint64 freeEntityIndex = ~0ULL;
+        static constexpr uint32 freeEntityIndex = 0xFFFFFFFF;
+        static constexpr uint32 notAvailable = 0xFFFFFFFF;
 
+        /// Resolves the archetype for a set of components; the values of shared components are taken from data.
+        auto _acquireArchetype(view<reflex::TypeInfo const*> components, view<void const*> data) -> ArchetypeId;
         UP_ECS_API EntityId _createEntityRaw(view<reflex::TypeInfo const*> components, view<void const*> data);
+        UP_ECS_API void _createEntitiesRaw(
+            view<reflex::TypeInfo const*> components,
+            view<void const*> data,
+            CreateData mode,
+            span<EntityId> outEntities);
+        /// Creates entities in an archetype already resolved from the components, including any shared values.
+        void _createEntitiesRaw(
+            ArchetypeId newArchetype,
+            view<reflex::TypeInfo const*> components,
+            view<void const*> data,
+            CreateData mode,
+            span<EntityId> outEntities);
+        void _moveEntitiesRaw(
+            ArchetypeId sourceArchetype,
+            ArchetypeId targetArchetype,
+            view<EntityId> entities,
+            view<view<ComponentData>> added);
         UP_ECS_API void _addComponentRaw(
             EntityId entityId,
             reflex::TypeInfo const& typeInfo,
             void const* componentData) noexcept;
-        void _deleteEntityData(ArchetypeId archetypeId, uint16 chunkIndex, uint16 index) noexcept;
+        void _deleteEntityData(ArchetypeId archetypeId, uint32 chunkIndex, uint16 index) noexcept;
+        /// Removes an entity's slot from its chunk once its components have been relocated or destroyed.
+        void _vacateEntityData(ArchetypeId archetypeId, uint32 chunkIndex, uint16 index) noexcept;
+        UP_ECS_API void _markChanged(ArchetypeId archetype, Chunk& chunk) noexcept;
+        /// Records entities moved between archetypes, or deleted from source, for the observers.
+        void _recordChange(ArchetypeId source, ArchetypeId target, view<EntityId> entities, bool deleted = false);
+        auto _compactArchetype(ArchetypeId archetype, size_t budget) -> size_t;
+        void _clear() noexcept;
 
+        auto _findAvailableChunk(ArchetypeId archetype) -> uint32;
+        void _updateAvailability(ArchetypeId archetype, uint32 chunkIndex) noexcept;
+        static void _setAvailable(ArchetypeChunks& data, uint32 chunkIndex, bool available) noexcept;
         auto _allocateEntitySpace(ArchetypeId archetype) -> AllocatedLocation;
-        auto _allocateEntityId(ArchetypeId archetype, uint16 chunk, uint16 index) -> EntityId;
+        auto _allocateEntityRange(ArchetypeId archetype, size_t count) -> AllocatedRange;
+        auto _allocateEntityId(ArchetypeId archetype, uint32 chunk, uint16 index) -> EntityId;
         void _recycleEntityId(EntityId entity) noexcept;
 
         UP_ECS_API auto _parseEntityId(EntityId entity) const noexcept -> EntityLocation;
-        void _remapEntityId(EntityId entity, ArchetypeId newArchetype, uint16 newChunk, uint16 newIndex) noexcept;
+        void _remapEntityId(EntityId entity, ArchetypeId newArchetype, uint32 newChunk, uint16 newIndex) noexcept;
+        auto _mappingAt(uint64 mappingIndex) noexcept -> EntityMapping& {
+            return _mappingPages[mappingIndex >> mappingPageShift]->entries[mappingIndex & (mappingPageSize - 1)];
+        }
+        auto _mappingAt(uint64 mappingIndex) const noexcept -> EntityMapping const& {
+            return _mappingPages[mappingIndex >> mappingPageShift]->entries[mappingIndex & (mappingPageSize - 1)];
+        }
 
-        void _moveTo(
+        void _relocateTo(
+            view<int16> rowMap,
             ArchetypeId destArch,
             Chunk& destChunk,
             int destIndex,
             ArchetypeId srcArch,
             Chunk& srcChunk,
-            int srcIndex);
-        void _moveTo(ArchetypeId destArch, Chunk& destChunk, int destIndex, Chunk& srcChunk, int srcIndex);
+            int srcIndex) noexcept;
         void _copyTo(
             ArchetypeId destArch,
             Chunk& destChunk,
@@ -159,16 +473,40 @@ namespace up {
             ComponentId srcComponent,
             void const* srcData);
         void* _constructAt(ArchetypeId arch, Chunk& chunk, int index, ComponentId component);
-        void _destroyAt(ArchetypeId arch, Chunk& chunk, int index);
+        void _destroyAt(ArchetypeId arch, Chunk& chunk, int index) noexcept;
 
-        auto _addChunk(ArchetypeId archetype, Chunk* chunk) -> uint16;
-        void _removeChunk(ArchetypeId archetype, int chunkIndex) noexcept;
-        UP_ECS_API auto _getChunk(ArchetypeId archetype, int chunkIndex) const noexcept -> Chunk*;
+        auto _addChunk(ArchetypeId archetype, Chunk* chunk) -> uint32;
+        void _removeChunk(ArchetypeId archetype, uint32 chunkIndex) noexcept;
+        UP_ECS_API auto _getChunk(ArchetypeId archetype, uint32 chunkIndex) const noexcept -> Chunk*;
 
-        vector<ArchetypeChunkRange> _archetypeChunkRanges;
-        vector<Chunk*> _chunks;
-        vector<uint64> _entityMapping;
-        uint64 _freeEntityHead = freeEntityIndex;
+        /// Retrieves a chunk that is about to be modified, first copying it if it is shared with another world.
+        auto _writableChunk(ArchetypeId archetype, uint32 chunkIndex) -> Chunk* {
+            Chunk*& slot = _archetypeChunks[to_underlying(archetype)].chunks[chunkIndex];
+            Chunk* const chunk = std::atomic_ref<Chunk*>(slot).load(std::memory_order_acquire);
+            // the chunk is only ours if no other thread replaced it with a copy while its references were read,
+            // as replacing it releases this world's reference to it
+            if (std::atomic_ref<uint32>(chunk->header.references).load(std::memory_order_acquire) == 1 &&
+                std::atomic_ref<Chunk*>(slot).load(std::memory_order_acquire) == chunk) {
+                return chunk;
+            }
+            return _unshareChunk(archetype, chunkIndex);
+        }
+        UP_ECS_API auto _unshareChunk(ArchetypeId archetype, uint32 chunkIndex) -> Chunk*;
+        void _releaseChunk(Chunk* chunk) noexcept;
+
+        vector<ArchetypeChunks> _archetypeChunks;
+        size_t _chunkCount = 0;
+        size_t _compactCursor = 0;
+        vector<box<MappingPage>> _mappingPages;
+        uint64 _mappingCount = 0;
+        uint32 _freeEntityHead = freeEntityIndex;
+        std::atomic<uint32> _version = 0;
+        uint64 _serial = 0;
+        // serializes copying shared chunks, which may be requested by concurrent Queries
+        std::mutex _unshareLock;
+        vector<box<Observer>> _observers;
+        uint32 _nextObserverId = 0;
+        bool _notifying = false;
         rc<EcsSharedContext> _context;
     };
 
@@ -185,6 +523,38 @@ namespace up {
         }
     }
 
+    template <typename... Components>
+    auto World::createEntities(size_t count, Components const&... prototypes) -> vector<EntityId> {
+        vector<EntityId> entities(count);
+        if constexpr (sizeof...(Components) != 0) {
+            reflex::TypeInfo const* const typeInfos[] = {_context->findComponentByType<Components>()...};
+            void const* const componentData[] = {&prototypes...};
+
+            _createEntitiesRaw(typeInfos, componentData, CreateData::Prototype, entities);
+        }
+        else {
+            _createEntitiesRaw({}, {}, CreateData::Prototype, entities);
+        }
+        return entities;
+    }
+
+    template <typename... Components>
+    auto World::createEntities(view<Components>... values) -> vector<EntityId> {
+        static_assert(sizeof...(Components) != 0, "createEntities requires at least one view of components");
+
+        size_t const sizes[] = {values.size()...};
+        for (size_t const size : sizes) {
+            UP_ASSERT(size == sizes[0], "all component views must have the same length");
+        }
+
+        reflex::TypeInfo const* const typeInfos[] = {_context->findComponentByType<Components>()...};
+        void const* const componentData[] = {values.data()...};
+
+        vector<EntityId> entities(sizes[0]);
+        _createEntitiesRaw(typeInfos, componentData, CreateData::PerEntity, entities);
+        return entities;
+    }
+
     template <typename Component>
     Component* World::getComponentSlow(EntityId entity) noexcept {
         reflex::TypeInfo const* const typeInfo = _context->findComponentByType<Component>();
@@ -194,6 +564,26 @@ namespace up {
         return static_cast<Component*>(getComponentSlowUnsafe(entity, static_cast<ComponentId>(typeInfo->hash)));
     }
 
+    template <typename Component>
+    Component const* World::readComponentSlow(EntityId entity) const noexcept {
+        reflex::TypeInfo const* const typeInfo = _context->findComponentByType<Component>();
+        if (typeInfo == nullptr) {
+            return nullptr;
+        }
+        return static_cast<Component const*>(
+            readComponentSlowUnsafe(entity, static_cast<ComponentId>(typeInfo->hash)));
+    }
+
+    template <typename Component, typename Field>
+    Field const* World::readFieldSlow(EntityId entity, Field Component::*member) const noexcept {
+        reflex::TypeInfo const* const typeInfo = _context->findComponentByType<Component>();
+        if (typeInfo == nullptr) {
+            return nullptr;
+        }
+        return static_cast<Field const*>(
+            readFieldSlowUnsafe(entity, static_cast<ComponentId>(typeInfo->hash), memberOffset(member)));
+    }
+
     template <typename Component>
     void World::addComponent(EntityId entityId, Component const& component) noexcept {
         reflex::TypeInfo const* const typeInfo = _context->findComponentByType<Component>();
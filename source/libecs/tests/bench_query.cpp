@@ -0,0 +1,61 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "test_components_schema.h"
+
+#include "potato/ecs/query.h"
+#include "potato/ecs/universe.h"
+#include "potato/ecs/world.h"
+#include "potato/runtime/scheduler.h"
+#include "potato/spud/string_format.h"
+
+#include <catch2/catch.hpp>
+#include <cmath>
+
+// Benchmarks are hidden from the default test run; execute with `test_ecs [benchmark]`
+TEST_CASE("potato.ecs.Query.parallel", "[.][benchmark][potato][ecs]") {
+    using namespace up;
+    using namespace up::components;
+
+    Universe universe;
+
+    universe.registerComponent<Position>("Position");
+    universe.registerComponent<Wave>("Wave");
+
+    constexpr int entityCount = 200000;
+
+    auto world = universe.createWorld();
+    for (int i = 0; i != entityCount; ++i) {
+        world.createEntity(Position{static_cast<float>(i), 0.f, 1.f}, Wave{static_cast<float>(i) * 0.01f});
+    }
+
+    auto query = universe.createQuery<Position, Wave>();
+
+    // mirrors the wave/orbit update performed by the shell's Scene::tick
+    auto const update = [](size_t count, EntityId const*, Position* positions, Wave* waves) {
+        constexpr float frameTime = 1.f / 60.f;
+        float const cosAngle = std::cos(frameTime);
+        float const sinAngle = std::sin(frameTime);
+        for (size_t index = 0; index != count; ++index) {
+            waves[index].offset += frameTime * .2f;
+            Position& pos = positions[index];
+            pos.y = 1 + 5 * std::sin(waves[index].offset * 10);
+            float const x = pos.x * cosAngle + pos.z * sinAngle;
+            float const z = pos.z * cosAngle - pos.x * sinAngle;
+            pos.x = x;
+            pos.z = z;
+        }
+    };
+
+    BENCHMARK("transform update (serial)") { query.selectChunks(world, update); };
+
+    for (int const threads : {1, 2, 4, 8}) {
+        Scheduler scheduler(threads - 1);
+
+        char name[64] = {
+            0,
+        };
+        format_to(name, "transform update ({} threads)", threads);
+
+        BENCHMARK(name) { query.selectChunksParallel(world, scheduler, update); };
+    }
+}
@@ -0,0 +1,43 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "test_components_schema.h"
+
+#include "potato/ecs/universe.h"
+#include "potato/ecs/world.h"
+
+#include <catch2/catch.hpp>
+
+// Benchmarks are hidden from the default test run; execute with `test_ecs [benchmark]`
+TEST_CASE("potato.ecs.World.createEntities", "[.][benchmark][potato][ecs]") {
+    using namespace up;
+    using namespace up::components;
+
+    Universe universe;
+
+    universe.registerComponent<Position>("Position");
+    universe.registerComponent<Wave>("Wave");
+
+    constexpr int entityCount = 100000;
+
+    BENCHMARK_ADVANCED("createEntity (one at a time)")(Catch::Benchmark::Chronometer meter) {
+        auto world = universe.createWorld();
+        meter.measure([&world] {
+            for (int i = 0; i != entityCount; ++i) {
+                world.createEntity(Position{0.f, 1.f, 2.f}, Wave{0.5f});
+            }
+        });
+    };
+
+    BENCHMARK_ADVANCED("createEntities (prototype)")(Catch::Benchmark::Chronometer meter) {
+        auto world = universe.createWorld();
+        meter.measure([&world] { return world.createEntities(entityCount, Position{0.f, 1.f, 2.f}, Wave{0.5f}); });
+    };
+
+    vector<Position> positions(entityCount, Position{0.f, 1.f, 2.f});
+    vector<Wave> waves(entityCount, Wave{0.5f});
+
+    BENCHMARK_ADVANCED("createEntities (per-entity values)")(Catch::Benchmark::Chronometer meter) {
+        auto world = universe.createWorld();
+        meter.measure([&] { return world.createEntities(view<Position>(positions), view<Wave>(waves)); });
+    };
+}
@@ -0,0 +1,233 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "test_components_schema.h"
+
+#include "potato/ecs/command_buffer.h"
+#include "potato/ecs/query.h"
+#include "potato/ecs/universe.h"
+#include "potato/ecs/world.h"
+
+#include <catch2/catch.hpp>
+
+TEST_CASE("potato.ecs.EntityCommandBuffer", "[potato][ecs]") {
+    using namespace up;
+    using namespace up::components;
+
+    Universe universe;
+
+    universe.registerComponent<Test1>("Test1");
+    universe.registerComponent<Second>("Second");
+    universe.registerComponent<Another>("Another");
+    universe.registerComponent<Counter>("Counter");
+
+    auto world = universe.createWorld();
+    auto commands = universe.createCommandBuffer();
+
+    SECTION("deferred creation") {
+        auto query = universe.createQuery<Counter>();
+
+        commands.createEntity(Counter{1}, Test1{'a'});
+        commands.createEntity(Test1{'b'}, Counter{2});
+        commands.createEntity(Counter{3});
+        CHECK_FALSE(commands.empty());
+
+        int sum = 0;
+        query.select(world, [&](EntityId, Counter& counter) { sum += counter.value; });
+        CHECK(sum == 0);
+
+        commands.playback(world);
+        CHECK(commands.empty());
+
+        query.select(world, [&](EntityId, Counter& counter) { sum += counter.value; });
+        CHECK(sum == 6);
+
+        // both orderings of {Counter,Test1} must land in the same archetype
+        auto both = universe.createQuery<Counter, Test1>();
+        size_t chunks = 0;
+        both.selectChunks(world, [&](size_t count, EntityId const*, Counter*, Test1*) {
+            ++chunks;
+            CHECK(count == 2);
+        });
+        CHECK(chunks == 1);
+    }
+
+    SECTION("observers") {
+        auto const existing = world.createEntities(3, Counter{1});
+
+        int batches = 0;
+        size_t added = 0;
+        world.observe<Test1>(ObserverEvent::Added, [&](view<EntityId> entities) {
+            added += entities.size();
+            ++batches;
+        });
+
+        for (EntityId const entity : existing) {
+            commands.addComponent(entity, Test1{'a'});
+        }
+        commands.createEntity(Test1{'b'});
+        commands.createEntity(Test1{'c'}, Counter{2});
+
+        // the whole playback is delivered in one notification
+        commands.playback(world);
+        CHECK(batches == 1);
+        CHECK(added == 5);
+    }
+
+    SECTION("structural changes during iteration") {
+        for (int i = 0; i != 20000; ++i) {
+            world.createEntity(Counter{i});
+        }
+
+        auto query = universe.createQuery<Counter>();
+        query.select(world, [&](EntityId entity, Counter& counter) {
+            if (counter.value % 2 == 0) {
+                commands.deleteEntity(entity);
+            }
+            else {
+                commands.addComponent(entity, Test1{'x'});
+            }
+        });
+        commands.playback(world);
+
+        int count = 0;
+        query.select(world, [&](EntityId entity, Counter& counter) {
+            ++count;
+            CHECK(counter.value % 2 == 1);
+            Test1* const test = world.getComponentSlow<Test1>(entity);
+            REQUIRE(test != nullptr);
+            CHECK(test->a == 'x');
+        });
+        CHECK(count == 10000);
+    }
+
+    SECTION("collapse commands per entity") {
+        EntityId const entity = world.createEntity(Counter{1});
+
+        commands.addComponent(entity, Test1{'a'});
+        commands.addComponent(entity, Second{1.f, 'b'});
+        commands.removeComponent<Test1>(entity);
+        commands.addComponent(entity, Second{2.f, 'c'});
+        commands.removeComponent<Counter>(entity);
+        commands.playback(world);
+
+        CHECK(world.getComponentSlow<Counter>(entity) == nullptr);
+        CHECK(world.getComponentSlow<Test1>(entity) == nullptr);
+        REQUIRE(world.getComponentSlow<Second>(entity) != nullptr);
+        CHECK(world.getComponentSlow<Second>(entity)->a == 'c');
+
+        // adding an existing component replaces its value in place
+        commands.addComponent(entity, Second{3.f, 'd'});
+        commands.playback(world);
+        CHECK(world.getComponentSlow<Second>(entity)->a == 'd');
+    }
+
+    SECTION("deferred entity ids") {
+        EntityId const first = commands.createEntity(Counter{1});
+        EntityId const second = commands.createEntity(Counter{2}, Test1{'a'});
+        EntityId const discarded = commands.createEntity(Counter{3});
+        CHECK(first != second);
+
+        commands.addComponent(first, Second{1.f, 'b'});
+        commands.removeComponent<Test1>(second);
+        commands.deleteEntity(discarded);
+
+        // placeholders are not entities of the world before playback
+        CHECK(world.getComponentSlow<Counter>(first) == nullptr);
+
+        commands.playback(world);
+
+        int sum = 0;
+        size_t withSecond = 0;
+        auto query = universe.createQuery<Counter const>();
+        query.select(world, [&](EntityId entity, Counter const& counter) {
+            sum += counter.value;
+            CHECK(world.getComponentSlow<Test1>(entity) == nullptr);
+            if (Second const* const added = world.getComponentSlow<Second>(entity); added != nullptr) {
+                CHECK(counter.value == 1);
+                CHECK(added->a == 'b');
+                ++withSecond;
+            }
+        });
+        CHECK(sum == 3);
+        CHECK(withSecond == 1);
+
+        // placeholders are numbered afresh once a buffer has been played back
+        CHECK(commands.createEntity(Counter{4}) == first);
+    }
+
+    SECTION("shared components") {
+        universe.registerSharedComponent<Appearance>("Appearance");
+
+        auto const archetypeOf = [&world](EntityId entity) {
+            ArchetypeId result = ArchetypeId::Empty;
+            world.interrogateEntityUnsafe(entity, [&](EntityId, ArchetypeId archetype, auto, auto) {
+                result = archetype;
+            });
+            return result;
+        };
+
+        commands.createEntity(Counter{1}, Appearance{1, 2});
+        EntityId const other = commands.createEntity(Appearance{1, 2}, Counter{2});
+        commands.createEntity(Counter{3}, Appearance{3, 2});
+        EntityId const existing = world.createEntity(Counter{4});
+        commands.addComponent(existing, Appearance{3, 2});
+        commands.addComponent(other, Test1{'a'});
+        commands.playback(world);
+
+        auto query = universe.createQuery<Counter const, Shared<Appearance>>();
+        vector<EntityId> byValue[4];
+        query.select(world, [&](EntityId entity, Counter const& counter, Appearance const& look) {
+            CHECK(look.mesh == (counter.value == 1 || counter.value == 2 ? 1 : 3));
+            byValue[counter.value - 1].push_back(entity);
+        });
+        for (vector<EntityId> const& entities : byValue) {
+            REQUIRE(entities.size() == 1);
+        }
+
+        // creations resolve to the archetype of their shared values, and additions move the entity
+        CHECK(archetypeOf(byValue[2].front()) != archetypeOf(byValue[0].front()));
+        CHECK(archetypeOf(byValue[3].front()) == archetypeOf(byValue[2].front()));
+        CHECK(world.getComponentSlow<Test1>(byValue[1].front()) != nullptr);
+
+        // replacing a shared value with an equal one leaves the entity where it is
+        ArchetypeId const before = archetypeOf(existing);
+        commands.addComponent(existing, Appearance{3, 2});
+        commands.playback(world);
+        CHECK(archetypeOf(existing) == before);
+        CHECK(world.readComponentSlow<Appearance>(existing)->mesh == 3);
+    }
+
+    SECTION("move assignment") {
+        universe.registerComponent<Label>("Label");
+
+        // labels are long enough to allocate, so a leak of either buffer's recordings is visible
+        auto moved = universe.createCommandBuffer();
+        moved.createEntity(Label{"a label long enough to need an allocation"_s}, Counter{1});
+        commands.createEntity(Label{"another label long enough to need an allocation"_s}, Counter{2});
+
+        commands = std::move(moved);
+        commands.playback(world);
+
+        int sum = 0;
+        auto query = universe.createQuery<Counter const, Label const>();
+        query.select(world, [&](EntityId, Counter const& counter, Label const& label) {
+            sum += counter.value;
+            CHECK(label.name == "a label long enough to need an allocation"_s);
+        });
+        CHECK(sum == 1);
+    }
+
+    SECTION("stale entities") {
+        EntityId const entity = world.createEntity(Counter{1});
+
+        commands.addComponent(entity, Test1{'a'});
+        commands.deleteEntity(entity);
+        commands.addComponent(entity, Second{});
+        commands.playback(world);
+        CHECK(world.getComponentSlow<Counter>(entity) == nullptr);
+
+        commands.addComponent(entity, Test1{'a'});
+        commands.playback(world);
+        CHECK(world.getComponentSlow<Test1>(entity) == nullptr);
+    }
+}
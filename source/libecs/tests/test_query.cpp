@@ -2,10 +2,13 @@
 
 #include "test_components_schema.h"
 
+#include "potato/ecs/hierarchy.h"
 #include "potato/ecs/query.h"
 #include "potato/ecs/universe.h"
 #include "potato/ecs/world.h"
+#include "potato/runtime/scheduler.h"
 
+#include <atomic>
 #include <catch2/catch.hpp>
 
 TEST_CASE("potato.ecs.Query", "[potato][ecs]") {
@@ -69,4 +72,245 @@ TEST_CASE("potato.ecs.Query", "[potato][ecs]") {
         CHECK(count == 4);
         CHECK(sum == 10.0f);
     }
+
+    SECTION("selecting chunks in parallel") {
+        auto world = universe.createWorld();
+        Scheduler scheduler(3);
+
+        constexpr int count = 50000;
+        for (int i = 0; i != count; ++i) {
+            world.createEntity(Second{1.f, 'g'});
+        }
+
+        std::atomic<size_t> invokeCount = 0;
+        std::atomic<size_t> entityCount = 0;
+
+        auto query = universe.createQuery<Second>();
+        query.selectChunksParallel(world, scheduler, [&](size_t count, EntityId const*, Second* second) {
+            ++invokeCount;
+            entityCount += count;
+
+            for (size_t index = 0; index != count; ++index) {
+                second[index].b += 1.f;
+            }
+        });
+
+        size_t serialInvokeCount = 0;
+        float sum = 0;
+        query.selectChunks(world, [&](size_t count, EntityId const*, Second* second) {
+            ++serialInvokeCount;
+            for (size_t index = 0; index != count; ++index) {
+                sum += second[index].b;
+            }
+        });
+
+        CHECK(invokeCount > 1);
+        CHECK(invokeCount == serialInvokeCount);
+        CHECK(entityCount == count);
+        CHECK(sum == 2.f * count);
+    }
+
+    SECTION("selecting entities in parallel") {
+        auto world = universe.createWorld();
+        Scheduler scheduler(3);
+
+        constexpr int count = 50000;
+        for (int i = 0; i != count; ++i) {
+            world.createEntity(Test1{'a'}, Another{static_cast<double>(i), 0.f});
+        }
+
+        auto query = universe.createQuery<Another>();
+        query.selectParallel(world, scheduler, [](EntityId, Another& another) {
+            another.b = static_cast<float>(another.a * 2);
+        });
+
+        bool allUpdated = true;
+        query.select(world, [&](EntityId, Another const& another) {
+            allUpdated = allUpdated && another.b == static_cast<float>(another.a * 2);
+        });
+        CHECK(allUpdated);
+    }
+
+    SECTION("selecting changed chunks") {
+        auto world = universe.createWorld();
+
+        // enough entities to span several chunks
+        constexpr int count = 20000;
+        for (int i = 0; i != count; ++i) {
+            world.createEntity(Second{static_cast<float>(i), 'a'});
+        }
+        EntityId const moving = world.createEntity(Second{-1.f, 'm'});
+
+        auto flush = universe.createQuery<Second>();
+        auto reader = universe.createQuery<Second const>();
+        auto writer = universe.createQuery<Second>();
+
+        auto const visitedChunks = [&] {
+            size_t chunks = 0;
+            flush.selectChunksChanged(world, [&](size_t, EntityId const*, Second*) { ++chunks; });
+            return chunks;
+        };
+
+        // everything is new on the first run
+        size_t const totalChunks = world.chunkCount();
+        REQUIRE(totalChunks > 2);
+        CHECK(visitedChunks() == totalChunks);
+
+        // neither a query's own writes nor read-only access are reported as changes
+        CHECK(visitedChunks() == 0);
+        reader.select(world, [](EntityId, Second const&) {});
+        CHECK(visitedChunks() == 0);
+
+        // mutable access marks only the chunk that was touched
+        world.getComponentSlow<Second>(moving)->b = 2.f;
+        CHECK(visitedChunks() == 1);
+
+        int visitedEntities = 0;
+        writer.select(world, [](EntityId, Second&) {});
+        flush.selectChanged(world, [&](EntityId, Second&) { ++visitedEntities; });
+        CHECK(visitedEntities == count + 1);
+
+        // structural changes mark their chunks
+        world.deleteEntity(moving);
+        CHECK(visitedChunks() == 1);
+
+        // switching to a clone and back, e.g. playing and stopping in the editor, visits everything once
+        {
+            auto play = world.clone();
+            size_t playChunks = 0;
+            for (int frame = 0; frame != 100; ++frame) {
+                writer.select(play, [](EntityId, Second&) {});
+                flush.selectChunksChanged(play, [&](size_t, EntityId const*, Second*) { ++playChunks; });
+            }
+            CHECK(playChunks == 100 * totalChunks);
+        }
+        CHECK(visitedChunks() == totalChunks);
+        CHECK(visitedChunks() == 0);
+
+        // the clone's versions must not hide later edits to the original
+        world.getComponentSlow<Second>(world.createEntity(Second{1.f, 'e'}))->b = 3.f;
+        CHECK(visitedChunks() == 1);
+    }
+
+    SECTION("selecting split fields") {
+        universe.registerComponent<Particle>("Particle");
+
+        auto world = universe.createWorld();
+        for (int index = 0; index != 10; ++index) {
+            world.createEntity(Particle{static_cast<float>(index), 0.f, 0.f, index});
+        }
+        world.createEntity(Test1{'a'}, Particle{10.f, 0.f, 0.f, 10});
+
+        // each field is a contiguous array, one element per entity in the chunk
+        auto query = universe.createQuery<Fields<Particle>>();
+        int total = 0;
+        query.selectChunks(world, [&](size_t count, EntityId const*, FieldColumns<Particle> particles) {
+            span<float> const xs = particles(&Particle::x);
+            span<int> const ages = particles(&Particle::age);
+            REQUIRE(xs.size() == count);
+            for (size_t index = 0; index != count; ++index) {
+                CHECK(xs[index] == static_cast<float>(ages[index]));
+                xs[index] *= 2.f;
+                total += ages[index];
+            }
+        });
+        CHECK(total == 55);
+
+        auto readOnly = universe.createQuery<Test1 const, Fields<Particle const>>();
+        int found = 0;
+        readOnly.select(world, [&](EntityId, Test1 const& test, FieldColumns<Particle const> particle) {
+            CHECK(test.a == 'a');
+            REQUIRE(particle.size() == 1);
+            CHECK(particle(&Particle::x)[0] == 20.f);
+            ++found;
+        });
+        CHECK(found == 1);
+    }
+
+    SECTION("selecting chunks by level") {
+        registerHierarchyComponents(universe);
+
+        Scheduler scheduler(3);
+        auto world = universe.createWorld();
+        EntityId const root = world.createEntity(Another{1.0, 0.f});
+        for (int index = 0; index != 100; ++index) {
+            EntityId const child = world.createEntity(Another{0.0, 0.f});
+            setParent(world, child, root);
+            for (int leaf = 0; leaf != 10; ++leaf) {
+                setParent(world, world.createEntity(Another{0.0, 0.f}), child);
+            }
+        }
+
+        // every level reads the values written by the level above it
+        auto query = universe.createQuery<Shared<HierarchyDepth>, Parent const, Another>();
+        std::atomic<int> visited = 0;
+        query.selectChunksParallelByLevel<HierarchyDepth>(
+            world,
+            scheduler,
+            [](HierarchyDepth const& level) { return level.depth; },
+            [&](size_t count, EntityId const*, HierarchyDepth const& level, Parent const* parents, Another* another) {
+                for (size_t index = 0; index != count; ++index) {
+                    another[index].a = world.readComponentSlow<Another>(parents[index].entity)->a * 2.0;
+                    another[index].b = static_cast<float>(level.depth);
+                }
+                visited += static_cast<int>(count);
+            });
+        CHECK(visited == 1100);
+
+        bool propagated = true;
+        universe.createQuery<Another const>().select(world, [&](EntityId, Another const& another) {
+            propagated = propagated && another.a == static_cast<double>(1 << static_cast<int>(another.b));
+        });
+        CHECK(propagated);
+    }
+
+    SECTION("query filters") {
+        auto world = universe.createWorld();
+
+        world.createEntity(Test1{'a'}, Second{1.f, 'a'});
+        world.createEntity(Test1{'b'}, Second{2.f, 'b'}, Another{2.0, 0.f});
+        world.createEntity(Test1{'c'}, Another{3.0, 0.f});
+        world.createEntity(Second{4.f, 'd'});
+
+        auto without = universe.createQuery<Test1, Without<Another>>();
+        int count = 0;
+        without.select(world, [&](EntityId, Test1& test) {
+            ++count;
+            CHECK(test.a == 'a');
+        });
+        CHECK(count == 1);
+
+        auto optional = universe.createQuery<Read<Test1>, Optional<Another>>();
+        float sum = 0;
+        optional.selectChunks(world, [&](size_t count, EntityId const*, Test1 const* tests, Another* another) {
+            for (size_t index = 0; index != count; ++index) {
+                sum += another != nullptr ? static_cast<float>(another[index].a) : 0.f;
+            }
+        });
+        CHECK(sum == 5.f);
+
+        int withCount = 0;
+        auto with = universe.createQuery<With<Test1>, Second const>();
+        with.select(world, [&](EntityId, Second const& second) {
+            ++withCount;
+            CHECK(second.b < 3.f);
+        });
+        CHECK(withCount == 2);
+
+        auto const access = optional.access();
+        REQUIRE(access.size() == 2);
+        CHECK_FALSE(access[0].writable);
+        CHECK(access[1].writable);
+        CHECK(with.access().size() == 1);
+
+        // archetypes created after a Query was first used are matched when it is next used
+        world.createEntity(Test1{'e'});
+        world.createEntity(Another{5.0, 0.f}, Test1{'f'});
+        count = 0;
+        without.select(world, [&](EntityId, Test1& test) {
+            ++count;
+            CHECK((test.a == 'a' || test.a == 'e'));
+        });
+        CHECK(count == 2);
+    }
 }
@@ -0,0 +1,121 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "test_components_schema.h"
+
+#include "potato/ecs/query.h"
+#include "potato/ecs/system_scheduler.h"
+#include "potato/ecs/universe.h"
+#include "potato/ecs/world.h"
+#include "potato/runtime/scheduler.h"
+
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <atomic>
+
+TEST_CASE("potato.ecs.SystemScheduler", "[potato][ecs]") {
+    using namespace up;
+    using namespace up::components;
+
+    Universe universe;
+
+    universe.registerComponent<Test1>("Test1");
+    universe.registerComponent<Second>("Second");
+    universe.registerComponent<Counter>("Counter");
+
+    Scheduler scheduler(2);
+    auto world = universe.createWorld();
+    auto systems = universe.createSystemScheduler(scheduler);
+
+    SECTION("conflicting systems run in order") {
+        constexpr int count = 20000;
+
+        world.createEntities(count, Counter{1}, Test1{'a'});
+
+        std::atomic<int> sum = 0;
+
+        systems->addChunkSystem<Counter>("increment", [](size_t count, EntityId const*, Counter* counters) {
+            for (size_t index = 0; index != count; ++index) {
+                ++counters[index].value;
+            }
+        });
+        systems->addChunkSystem<Test1>("rename", [](size_t count, EntityId const*, Test1* tests) {
+            for (size_t index = 0; index != count; ++index) {
+                tests[index].a = 'b';
+            }
+        });
+        systems->addChunkSystem<Counter const>("sum", [&](size_t count, EntityId const*, Counter const* counters) {
+            int local = 0;
+            for (size_t index = 0; index != count; ++index) {
+                local += counters[index].value;
+            }
+            sum += local;
+        });
+
+        systems->run(world);
+        CHECK(sum == 2 * count);
+
+        sum = 0;
+        systems->run(world);
+        CHECK(sum == 3 * count);
+
+        auto const timings = systems->timings();
+        REQUIRE(timings.size() == 3);
+        CHECK(timings[0].name == "increment");
+        CHECK(timings[1].name == "rename");
+        CHECK(timings[2].name == "sum");
+
+        // the reader depends on the writer, so it starts after it and either both or neither are on the critical path
+        CHECK(timings[0].critical == timings[2].critical);
+        CHECK(timings[2].startNanoseconds >= timings[0].startNanoseconds + timings[0].durationNanoseconds);
+        CHECK(
+            systems->criticalPathNanoseconds() >= timings[0].durationNanoseconds + timings[2].durationNanoseconds);
+        CHECK(systems->criticalPathNanoseconds() >= timings[1].durationNanoseconds);
+        CHECK(systems->criticalPathNanoseconds() <= systems->frameNanoseconds());
+    }
+
+    SECTION("readers do not conflict") {
+        world.createEntity(Counter{5});
+
+        int first = 0;
+        int second = 0;
+
+        systems->addSystem<Counter const>("first", [&](SystemContext& context, Query<Counter const>& query) {
+            query.select(context.world, [&](EntityId, Counter const& counter) { first += counter.value; });
+        });
+        systems->addSystem<Read<Counter>>("second", [&](SystemContext& context, Query<Read<Counter>>& query) {
+            query.select(context.world, [&](EntityId, Counter const& counter) { second += counter.value; });
+        });
+
+        systems->run(world);
+        CHECK(first == 5);
+        CHECK(second == 5);
+
+        // neither System waits on the other, so the critical path is just the longer of the two
+        auto const timings = systems->timings();
+        REQUIRE(timings.size() == 2);
+        CHECK(
+            systems->criticalPathNanoseconds() ==
+            std::max(timings[0].durationNanoseconds, timings[1].durationNanoseconds));
+    }
+
+    SECTION("structural changes are deferred") {
+        EntityId const entity = world.createEntity(Counter{1});
+
+        systems->addSystem<Counter>("spawn", [](SystemContext& context, Query<Counter>& query) {
+            query.select(context.world, [&](EntityId id, Counter& counter) {
+                context.commands.addComponent(id, Second{1.f, 'c'});
+                context.commands.createEntity(Counter{counter.value + 1});
+            });
+        });
+
+        systems->run(world);
+
+        REQUIRE(world.getComponentSlow<Second>(entity) != nullptr);
+        CHECK(world.getComponentSlow<Second>(entity)->a == 'c');
+
+        int total = 0;
+        auto query = universe.createQuery<Counter>();
+        query.select(world, [&](EntityId, Counter& counter) { total += counter.value; });
+        CHECK(total == 3);
+    }
+}
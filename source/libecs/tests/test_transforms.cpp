@@ -0,0 +1,38 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "potato/ecs/transforms.h"
+#include "potato/spud/vector.h"
+
+#include <catch2/catch.hpp>
+#include <glm/gtx/transform.hpp>
+#include <random>
+
+TEST_CASE("potato.ecs.composeTransforms", "[potato][ecs]") {
+    using namespace up;
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> coordinate(-100.f, 100.f);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+
+    // counts which are not a multiple of four exercise both the batched and the remaining transforms
+    for (size_t const count : {0, 1, 3, 4, 5, 8, 13}) {
+        vector<glm::vec3> positions;
+        vector<glm::quat> rotations;
+        for (size_t index = 0; index != count; ++index) {
+            positions.push_back({coordinate(random), coordinate(random), coordinate(random)});
+            rotations.push_back(glm::normalize(glm::quat(unit(random), unit(random), unit(random), unit(random))));
+        }
+
+        vector<glm::mat4x4> matrices(count);
+        composeTransforms(positions, rotations, matrices);
+
+        for (size_t index = 0; index != count; ++index) {
+            glm::mat4x4 const expected = glm::translate(positions[index]) * glm::mat4_cast(rotations[index]);
+            for (int column = 0; column != 4; ++column) {
+                for (int row = 0; row != 4; ++row) {
+                    CHECK(matrices[index][column][row] == Approx(expected[column][row]).margin(1e-4));
+                }
+            }
+        }
+    }
+}
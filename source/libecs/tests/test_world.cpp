@@ -2,11 +2,16 @@
 
 #include "test_components_schema.h"
 
+#include "potato/ecs/hierarchy.h"
 #include "potato/ecs/query.h"
 #include "potato/ecs/universe.h"
 #include "potato/ecs/world.h"
 
 #include <catch2/catch.hpp>
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <thread>
 
 CATCH_REGISTER_ENUM(up::EntityId);
 
@@ -21,6 +26,15 @@ TEST_CASE("potato.ecs.World", "[potato][ecs]") {
     universe.registerComponent<Another>("Another");
     universe.registerComponent<Counter>("Counter");
 
+    SECTION("component registry") {
+        reflex::TypeInfo const* const second = universe.findComponentByName("Second");
+        REQUIRE(second != nullptr);
+        CHECK(second->hash == reflex::TypeHolder<Second>::get().hash);
+
+        CHECK(universe.findComponentByName("Missing") == nullptr);
+        CHECK(universe.components().size() == 4);
+    }
+
     SECTION("directly access componens") {
         auto world = universe.createWorld();
 
@@ -76,6 +90,446 @@ TEST_CASE("potato.ecs.World", "[potato][ecs]") {
         CHECK(sum == expectedSum);
     }
 
+    SECTION("create entities in bulk") {
+        constexpr int count = 10000;
+        auto world = universe.createWorld();
+
+        // an existing entity leaves a partially-filled chunk and a recycled id behind
+        world.createEntity(Counter{-1}, Test1{'z'});
+        world.deleteEntity(world.createEntity(Counter{-2}, Test1{'y'}));
+
+        auto const entities = world.createEntities(count, Counter{7}, Test1{'p'});
+        REQUIRE(entities.size() == count);
+
+        for (EntityId const entity : entities) {
+            REQUIRE(world.getComponentSlow<Counter>(entity) != nullptr);
+            CHECK(world.getComponentSlow<Counter>(entity)->value == 7);
+            CHECK(world.getComponentSlow<Test1>(entity)->a == 'p');
+        }
+
+        vector<Counter> counters;
+        for (int i = 0; i != count; ++i) {
+            counters.push_back(Counter{i});
+        }
+        vector<Second> seconds(count, Second{2.f, 's'});
+
+        auto const unique = world.createEntities(view<Counter>(counters), view<Second>(seconds));
+        REQUIRE(unique.size() == count);
+        for (int i = 0; i != count; ++i) {
+            CHECK(world.getComponentSlow<Counter>(unique[i])->value == i);
+            CHECK(world.getComponentSlow<Second>(unique[i])->a == 's');
+        }
+
+        size_t total = 0;
+        auto query = universe.createQuery<Counter>();
+        query.selectChunks(world, [&](size_t count, EntityId const*, Counter*) { total += count; });
+        CHECK(total == 2 * count + 1);
+    }
+
+    SECTION("snapshot") {
+        universe.registerComponent<Label>("Label");
+
+        auto world = universe.createWorld();
+
+        auto const counters = world.createEntities(1000, Counter{7}, Test1{'s'});
+        EntityId const labelled = world.createEntity(Label{"first"_s}, Counter{1});
+        EntityId const bare = world.createEntity();
+        world.deleteEntity(counters[10]);
+        world.getComponentSlow<Counter>(counters[20])->value = 20;
+
+        vector<byte> snapshot;
+        REQUIRE(world.saveSnapshot(snapshot));
+
+        auto loaded = universe.createWorld();
+        REQUIRE(loaded.loadSnapshot(snapshot));
+        CHECK(loaded.chunkCount() == world.chunkCount());
+
+        // entity ids survive, including deleted ones staying deleted
+        CHECK(loaded.getComponentSlow<Counter>(counters[10]) == nullptr);
+        CHECK(loaded.archetypeOf(counters[10]) == ArchetypeId::Empty);
+        REQUIRE(loaded.getComponentSlow<Counter>(counters[20]) != nullptr);
+        CHECK(loaded.getComponentSlow<Counter>(counters[20])->value == 20);
+        REQUIRE(loaded.getComponentSlow<Test1>(counters[999]) != nullptr);
+        CHECK(loaded.getComponentSlow<Test1>(counters[999])->a == 's');
+        REQUIRE(loaded.getComponentSlow<Label>(labelled) != nullptr);
+        CHECK(loaded.getComponentSlow<Label>(labelled)->name == "first"_s);
+        CHECK(loaded.getComponentSlow<Counter>(labelled)->value == 1);
+        CHECK(loaded.interrogateEntityUnsafe(bare, [](auto&&...) {}));
+
+        int total = 0;
+        auto query = universe.createQuery<Counter>();
+        query.select(loaded, [&](EntityId, Counter& counter) { total += counter.value; });
+        CHECK(total == 998 * 7 + 20 + 1);
+
+        // a recycled id must not collide with any restored entity
+        EntityId const created = loaded.createEntity(Counter{3});
+        CHECK(created != counters[10]);
+        CHECK(loaded.getComponentSlow<Counter>(counters[11])->value == 7);
+
+        SECTION("truncated") {
+            auto truncated = universe.createWorld();
+            CHECK_FALSE(truncated.loadSnapshot(view<byte>(snapshot).first(snapshot.size() - 1)));
+            CHECK(truncated.chunkCount() == 0);
+        }
+
+        SECTION("malformed") {
+            // the entity table starts with its entry count and free-list head; counters[10] heads the free list
+            uint64 const mappingCount = 1002;
+            uint32 const freeHead = 10;
+            byte header[sizeof(mappingCount) + sizeof(freeHead)];
+            std::memcpy(header, &mappingCount, sizeof(mappingCount));
+            std::memcpy(header + sizeof(mappingCount), &freeHead, sizeof(freeHead));
+            auto const found = std::search(snapshot.begin(), snapshot.end(), std::begin(header), std::end(header));
+            REQUIRE(found != snapshot.end());
+            size_t const freeHeadOffset = (found - snapshot.begin()) + sizeof(mappingCount);
+            size_t const freeNextOffset = freeHeadOffset + sizeof(freeHead) + freeHead * 12 + sizeof(uint32);
+
+            auto const loadPatched = [&](size_t offset, uint32 value) {
+                vector<byte> patched(snapshot.begin(), snapshot.end());
+                std::memcpy(patched.data() + offset, &value, sizeof(value));
+                auto malformed = universe.createWorld();
+                bool const result = malformed.loadSnapshot(patched);
+                CHECK((result || malformed.chunkCount() == 0));
+                return result;
+            };
+
+            CHECK(loadPatched(freeHeadOffset, freeHead));
+            CHECK_FALSE(loadPatched(freeHeadOffset, 5000));
+            CHECK_FALSE(loadPatched(freeHeadOffset, 0xFFFF'FFFF));
+            CHECK_FALSE(loadPatched(freeNextOffset, freeHead));
+        }
+    }
+
+    SECTION("clone") {
+        universe.registerComponent<Label>("Label");
+
+        auto world = universe.createWorld();
+        auto const counters = world.createEntities(2000, Counter{1}, Test1{'o'});
+        EntityId const labelled = world.createEntity(Label{"original"_s});
+
+        auto const chunksBefore = universe.chunkMemoryStats().chunksInUse;
+        {
+            auto play = world.clone();
+
+            // nothing is copied until a chunk is written
+            CHECK(universe.chunkMemoryStats().chunksInUse == chunksBefore);
+            int total = 0;
+            auto reader = universe.createQuery<Counter const>();
+            reader.select(play, [&](EntityId, Counter const& counter) { total += counter.value; });
+            CHECK(total == 2000);
+            CHECK(universe.chunkMemoryStats().chunksInUse == chunksBefore);
+
+            auto writer = universe.createQuery<Counter>();
+            writer.select(play, [](EntityId, Counter& counter) { counter.value = 2; });
+            CHECK(universe.chunkMemoryStats().chunksInUse > chunksBefore);
+
+            play.getComponentSlow<Label>(labelled)->name = "played"_s;
+            play.deleteEntity(counters[0]);
+            play.createEntity(Counter{5});
+            world.deleteEntity(counters[1]);
+
+            CHECK(world.getComponentSlow<Counter>(counters[0])->value == 1);
+            CHECK(world.getComponentSlow<Label>(labelled)->name == "original"_s);
+            CHECK(play.getComponentSlow<Counter>(counters[0]) == nullptr);
+            CHECK(play.getComponentSlow<Counter>(counters[1])->value == 2);
+            CHECK(play.getComponentSlow<Label>(labelled)->name == "played"_s);
+            CHECK(world.getComponentSlow<Counter>(counters[1]) == nullptr);
+        }
+
+        // discarding the clone releases only the chunks it copied
+        CHECK(universe.chunkMemoryStats().chunksInUse == chunksBefore);
+
+        int total = 0;
+        auto query = universe.createQuery<Counter>();
+        query.select(world, [&](EntityId, Counter& counter) { total += counter.value; });
+        CHECK(total == 1999);
+    }
+
+    SECTION("clone written from concurrent queries") {
+        auto world = universe.createWorld();
+        world.createEntities(20000, Counter{1}, Test1{'a'});
+        auto const chunksBefore = universe.chunkMemoryStats().chunksInUse;
+
+        for (int round = 0; round != 8; ++round) {
+            auto play = world.clone();
+
+            // the queries write different components, so both copy the same shared chunks at once
+            std::thread counters([&universe, &play] {
+                auto query = universe.createQuery<Counter>();
+                query.select(play, [](EntityId, Counter& counter) { counter.value = 2; });
+            });
+            std::thread labels([&universe, &play] {
+                auto query = universe.createQuery<Test1>();
+                query.select(play, [](EntityId, Test1& test) { test.a = 'b'; });
+            });
+            counters.join();
+            labels.join();
+
+            CHECK(universe.chunkMemoryStats().chunksInUse == 2 * chunksBefore);
+
+            int played = 0;
+            auto reader = universe.createQuery<Counter const, Test1 const>();
+            reader.select(play, [&](EntityId, Counter const& counter, Test1 const& test) {
+                played += counter.value == 2 && test.a == 'b' ? 1 : 0;
+            });
+            CHECK(played == 20000);
+        }
+
+        CHECK(universe.chunkMemoryStats().chunksInUse == chunksBefore);
+        int original = 0;
+        auto reader = universe.createQuery<Counter const, Test1 const>();
+        reader.select(world, [&](EntityId, Counter const& counter, Test1 const& test) {
+            original += counter.value == 1 && test.a == 'a' ? 1 : 0;
+        });
+        CHECK(original == 20000);
+    }
+
+    SECTION("many chunks in one archetype") {
+        auto world = universe.createWorld();
+        auto const entities = world.createEntities(400000, Counter{1});
+        REQUIRE(world.chunkCount() > 256);
+
+        // emptying the first chunk moves the last chunk into its place, remapping every entity in it
+        for (size_t index = 0; index != 2000; ++index) {
+            world.deleteEntity(entities[index]);
+        }
+        for (size_t index = entities.size() - 2000; index != entities.size(); ++index) {
+            REQUIRE(world.getComponentSlow<Counter>(entities[index]) != nullptr);
+        }
+
+        // writing a clone copies chunks at every index
+        auto play = world.clone();
+        auto query = universe.createQuery<Counter>();
+        query.select(play, [](EntityId, Counter& counter) { counter.value = 2; });
+        play.getComponentSlow<Counter>(entities.back())->value = 3;
+
+        CHECK(play.getComponentSlow<Counter>(entities[200000])->value == 2);
+        CHECK(play.getComponentSlow<Counter>(entities.back())->value == 3);
+        CHECK(world.getComponentSlow<Counter>(entities[200000])->value == 1);
+        CHECK(world.getComponentSlow<Counter>(entities.back())->value == 1);
+    }
+
+    SECTION("release chunk memory") {
+        universe.setChunkRetainedBytes(0);
+
+        {
+            auto world = universe.createWorld();
+            auto const entities =
+                world.createEntities(100000, Counter{1}, Test1{'a'}, Second{2.f, 'b'}, Another{3.0, 4.f});
+
+            auto const loaded = universe.chunkMemoryStats();
+            CHECK(loaded.chunksInUse == world.chunkCount());
+            CHECK(loaded.bytesMapped >= loaded.bytesInUse);
+            CHECK(loaded.peakBytesMapped == loaded.bytesMapped);
+
+            for (EntityId const entity : entities) {
+                world.deleteEntity(entity);
+            }
+
+            auto const drained = universe.chunkMemoryStats();
+            CHECK(drained.chunksInUse == 0);
+            CHECK(drained.bytesMapped == 0);
+            CHECK(drained.slabsReleased == loaded.slabsMapped);
+            CHECK(drained.peakBytesMapped == loaded.peakBytesMapped);
+
+            // destroying a World returns its Chunks as well
+            world.createEntities(100000, Counter{1});
+            CHECK(universe.chunkMemoryStats().chunksInUse != 0);
+
+            universe.setChunkRetainedBytes(ChunkAllocator::slabBytes);
+        }
+
+        auto const destroyed = universe.chunkMemoryStats();
+        CHECK(destroyed.chunksInUse == 0);
+        CHECK(destroyed.slabsMapped == 1);
+        CHECK(destroyed.chunksFree == ChunkAllocator::chunksPerSlab(ChunkSizeClass::Small));
+    }
+
+    SECTION("chunk size classes") {
+        auto world = universe.createWorld();
+        world.createEntities(10, Test1{'a'});
+        world.createEntities(10, Counter{1}, Test1{'a'});
+
+        // narrow entities use the smallest chunks, which still hold plenty of them
+        auto const narrow = universe.chunkMemoryStats();
+        CHECK(narrow.chunksInUse == 2);
+        CHECK(narrow.bytesInUse == 2 * chunkSizeBytes(ChunkSizeClass::Small));
+
+        // a typical rendered object, with a position and a mesh, still fits the smallest chunks
+        universe.registerComponent<Position>("Position");
+        universe.registerComponent<Appearance>("Appearance");
+        world.createEntities(10, Position{}, Appearance{});
+
+        auto const rendered = universe.chunkMemoryStats();
+        CHECK(rendered.chunksInUse == 3);
+        CHECK(rendered.bytesInUse == narrow.bytesInUse + chunkSizeBytes(ChunkSizeClass::Small));
+
+        // a few wide entities also start in the smallest chunks, which hold a handful of them
+        universe.registerComponent<Bone>("Bone");
+        EntityId const wide = world.createEntity(Bone{}, Test1{'w'});
+
+        auto const stats = universe.chunkMemoryStats();
+        CHECK(stats.chunksInUse == 4);
+        CHECK(stats.bytesInUse == rendered.bytesInUse + chunkSizeBytes(ChunkSizeClass::Small));
+
+        world.removeComponent<Bone>(wide);
+        CHECK(world.getComponentSlow<Test1>(wide)->a == 'w');
+        CHECK(universe.chunkMemoryStats().bytesInUse == rendered.bytesInUse);
+
+        // once wide entities fill a few chunks, new ones are placed in larger chunks holding a useful batch of them
+        vector<EntityId> bones;
+        for (int index = 0; index != 1000; ++index) {
+            bones.push_back(world.createEntity(Bone{}, Test1{'b'}));
+        }
+
+        auto const promoted = universe.chunkMemoryStats();
+        CHECK(promoted.chunksInUse == rendered.chunksInUse + EcsSharedContext::promoteAfterChunks + 2);
+        CHECK(
+            promoted.bytesInUse == rendered.bytesInUse +
+                EcsSharedContext::promoteAfterChunks * chunkSizeBytes(ChunkSizeClass::Small) +
+                2 * chunkSizeBytes(ChunkSizeClass::Medium));
+        CHECK(world.archetypeOf(bones.front()) != world.archetypeOf(bones.back()));
+
+        // the promoted archetype holds the same components, so queries and edges treat both alike
+        int count = 0;
+        auto query = universe.createQuery<Bone const, Test1 const>();
+        query.select(world, [&count](EntityId, Bone const&, Test1 const& test) { count += test.a == 'b' ? 1 : 0; });
+        CHECK(count == 1000);
+
+        world.addComponent(bones.front(), Counter{1});
+        world.removeComponent<Counter>(bones.front());
+        CHECK(world.archetypeOf(bones.front()) == world.archetypeOf(bones.back()));
+    }
+
+    SECTION("worlds on separate threads") {
+        constexpr int threadCount = 4;
+        constexpr int count = 5000;
+
+        auto const populate = [&universe](int seed) {
+            auto world = universe.createWorld();
+
+            vector<EntityId> entities;
+            for (int index = 0; index != count; ++index) {
+                entities.push_back(world.createEntity(Counter{index}));
+            }
+
+            // threads add components in different orders, so they race to create the same archetypes
+            for (int index = 0; index != count; ++index) {
+                if ((index + seed) % 2 == 0) {
+                    world.addComponent(entities[index], Test1{'a'});
+                }
+                if ((index + seed) % 3 == 0) {
+                    world.addComponent(entities[index], Second{1.f, 'b'});
+                }
+                if (index % 5 == 0) {
+                    world.deleteEntity(entities[index]);
+                }
+            }
+
+            int sum = 0;
+            for (int index = 0; index != count; ++index) {
+                if (Counter const* const counter = world.getComponentSlow<Counter>(entities[index])) {
+                    sum += counter->value;
+                }
+            }
+            return sum;
+        };
+
+        int expected = 0;
+        for (int index = 0; index != count; ++index) {
+            expected += index % 5 != 0 ? index : 0;
+        }
+
+        int sums[threadCount] = {};
+        std::thread threads[threadCount];
+        for (int index = 0; index != threadCount; ++index) {
+            threads[index] = std::thread([&populate, &sums, index] { sums[index] = populate(index); });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        for (int const sum : sums) {
+            CHECK(sum == expected);
+        }
+        CHECK(universe.chunkMemoryStats().chunksInUse == 0);
+    }
+
+    SECTION("churn entities") {
+        constexpr int count = 20000;
+        auto world = universe.createWorld();
+
+        vector<EntityId> live;
+        vector<int> values;
+        std::mt19937 random(1234);
+
+        for (int i = 0; i != count; ++i) {
+            live.push_back(world.createEntity(Counter{i}, Test1{'c'}));
+            values.push_back(i);
+
+            // randomly delete some entity for every other creation, so chunks empty and refill out of order
+            if (i % 2 == 1) {
+                auto const victim = std::uniform_int_distribution<size_t>(0, live.size() - 1)(random);
+                world.deleteEntity(live[victim]);
+                live[victim] = live.back();
+                values[victim] = values.back();
+                live.pop_back();
+                values.pop_back();
+            }
+        }
+
+        for (size_t index = 0; index != live.size(); ++index) {
+            REQUIRE(world.getComponentSlow<Counter>(live[index]) != nullptr);
+            CHECK(world.getComponentSlow<Counter>(live[index])->value == values[index]);
+        }
+
+        size_t total = 0;
+        auto query = universe.createQuery<Counter>();
+        query.selectChunks(world, [&](size_t count, EntityId const*, Counter*) { total += count; });
+        CHECK(total == live.size());
+
+        // thin out every chunk, which leaves them all sparsely filled
+        for (size_t index = live.size(); index-- != 0;) {
+            if (index % 4 != 0) {
+                world.deleteEntity(live[index]);
+                live[index] = live.back();
+                values[index] = values.back();
+                live.pop_back();
+                values.pop_back();
+            }
+        }
+
+        // compaction is time-sliced, but must eventually pack every chunk but one
+        auto const fragmented = world.occupancy();
+        CHECK(fragmented.entities == live.size());
+
+        CompactionResult compaction;
+        size_t calls = 0;
+        do {
+            compaction = world.compact(100);
+            CHECK(compaction.movedEntities <= 100);
+            ++calls;
+        } while (!compaction.complete);
+
+        auto const compacted = world.occupancy();
+        CHECK(compaction.after.chunks == compacted.chunks);
+        CHECK(compacted.entities == live.size());
+        CHECK(compacted.chunks < fragmented.chunks);
+        CHECK(calls > 1);
+        CHECK(compacted.capacity - compacted.entities < compacted.capacity / compacted.chunks);
+
+        for (size_t index = 0; index != live.size(); ++index) {
+            REQUIRE(world.getComponentSlow<Counter>(live[index]) != nullptr);
+            CHECK(world.getComponentSlow<Counter>(live[index])->value == values[index]);
+        }
+
+        std::shuffle(live.begin(), live.end(), random);
+        for (EntityId const entity : live) {
+            world.deleteEntity(entity);
+        }
+        CHECK(world.chunkCount() == 0);
+    }
+
     SECTION("create and delete entities") {
         auto world = universe.createWorld();
 
@@ -164,6 +618,337 @@ TEST_CASE("potato.ecs.World", "[potato][ecs]") {
         CHECK(found);
     }
 
+    SECTION("archetype graph") {
+        auto world = universe.createWorld();
+
+        auto const archetypeOf = [&world](EntityId entity) {
+            ArchetypeId result = ArchetypeId::Empty;
+            world.interrogateEntityUnsafe(entity, [&](EntityId, ArchetypeId archetype, auto, auto) {
+                result = archetype;
+            });
+            return result;
+        };
+
+        EntityId const first = world.createEntity(Test1{'a'});
+        EntityId const second = world.createEntity(Second{1.f, 'b'}, Test1{'c'});
+        ArchetypeId const test1Archetype = archetypeOf(first);
+
+        // the same component set must resolve to the same archetype regardless of order or path
+        world.addComponent(first, Second{2.f, 'd'});
+        CHECK(archetypeOf(first) == archetypeOf(second));
+
+        world.removeComponent<Second>(first);
+        CHECK(archetypeOf(first) == test1Archetype);
+
+        // walking a cached edge must produce the same result
+        world.addComponent(first, Second{3.f, 'e'});
+        CHECK(archetypeOf(first) == archetypeOf(second));
+        CHECK(world.getComponentSlow<Second>(first)->b == 3.f);
+        CHECK(world.getComponentSlow<Test1>(first)->a == 'a');
+    }
+
+    SECTION("relocate components") {
+        universe.registerComponent<Label>("Label");
+
+        CHECK(reflex::getTypeInfo<Test1>().triviallyRelocatable);
+        CHECK_FALSE(reflex::getTypeInfo<Label>().triviallyRelocatable);
+        CHECK_FALSE(reflex::getTypeInfo<Label>().triviallyDestructible);
+
+        auto world = universe.createWorld();
+        string_view const name = "a label long enough to need its own allocation";
+
+        vector<EntityId> entities;
+        for (int index = 0; index != 100; ++index) {
+            entities.push_back(world.createEntity(Counter{index}, Label{string{name}}));
+        }
+
+        // moves between archetypes and the filling of holes must relocate both kinds of component
+        for (int index = 0; index < 100; index += 3) {
+            world.addComponent(entities[index], Test1{'x'});
+        }
+        for (int index = 0; index < 100; index += 2) {
+            world.removeComponent<Counter>(entities[index]);
+        }
+        for (int index = 1; index < 100; index += 4) {
+            world.deleteEntity(entities[index]);
+        }
+
+        for (int index = 0; index != 100; ++index) {
+            if (index % 4 == 1) {
+                CHECK(world.getComponentSlow<Label>(entities[index]) == nullptr);
+                continue;
+            }
+
+            Label const* const label = world.getComponentSlow<Label>(entities[index]);
+            REQUIRE(label != nullptr);
+            CHECK(label->name == name);
+
+            Counter const* const counter = world.getComponentSlow<Counter>(entities[index]);
+            CHECK((counter != nullptr) == (index % 2 != 0));
+            if (counter != nullptr) {
+                CHECK(counter->value == index);
+            }
+            CHECK((world.getComponentSlow<Test1>(entities[index]) != nullptr) == (index % 3 == 0));
+        }
+    }
+
+    SECTION("tags") {
+        universe.registerComponent<Selected>("Selected");
+
+        auto world = universe.createWorld();
+        auto querySelected = universe.createQuery<Counter const, Selected>();
+
+        auto const chunkOf = [&world](EntityId entity) {
+            Chunk const* result = nullptr;
+            world.interrogateEntityUnsafe(entity, [&](EntityId, ArchetypeId archetype, auto, auto) {
+                result = world.chunksOf(archetype).front();
+            });
+            return result;
+        };
+
+        EntityId const plain = world.createEntity(Counter{1});
+        EntityId const selected = world.createEntity(Counter{2});
+        world.addComponent(selected, Selected{});
+
+        // tags take no room in the chunk
+        CHECK(chunkOf(selected) != chunkOf(plain));
+        CHECK(chunkOf(selected)->header.capacity == chunkOf(plain)->header.capacity);
+
+        int found = 0;
+        querySelected.select(world, [&](EntityId entity, Counter const& counter, Selected&) {
+            CHECK(entity == selected);
+            CHECK(counter.value == 2);
+            ++found;
+        });
+        CHECK(found == 1);
+
+        world.removeComponent<Selected>(selected);
+        CHECK(chunkOf(selected) == chunkOf(plain));
+        CHECK(world.getComponentSlow<Counter>(selected)->value == 2);
+    }
+
+    SECTION("shared components") {
+        universe.registerSharedComponent<Appearance>("Appearance");
+
+        auto world = universe.createWorld();
+        auto query = universe.createQuery<Shared<Appearance>, Counter const>();
+
+        auto const chunkOf = [&world](EntityId entity) {
+            Chunk const* result = nullptr;
+            world.interrogateEntityUnsafe(entity, [&](EntityId, ArchetypeId archetype, auto, auto) {
+                result = world.chunksOf(archetype).front();
+            });
+            return result;
+        };
+
+        auto const cubes = world.createEntities(10, Counter{1}, Appearance{1, 2});
+        EntityId const sphere = world.createEntity(Counter{2}, Appearance{3, 2});
+        EntityId const plain = world.createEntity(Counter{3});
+        world.addComponent(plain, Appearance{1, 2});
+
+        // entities holding equal values share chunks, which take no room for the value
+        CHECK(chunkOf(plain) == chunkOf(cubes[0]));
+        CHECK(chunkOf(sphere) != chunkOf(cubes[0]));
+        CHECK(chunkOf(sphere)->header.capacity == chunkOf(plain)->header.capacity);
+        CHECK(world.readComponentSlow<Appearance>(plain) == world.readComponentSlow<Appearance>(cubes[0]));
+        CHECK(world.readComponentSlow<Appearance>(sphere)->mesh == 3);
+        CHECK(world.archetypeOf(plain) == world.archetypeOf(cubes[0]));
+        CHECK(world.archetypeOf(sphere) != world.archetypeOf(cubes[0]));
+
+        // a shared value can't be written in place, as that would change it for every entity holding it
+        CHECK(world.hasComponent(plain, ComponentId(universe.findComponentByName("Appearance")->hash)));
+        CHECK(world.getComponentSlow<Appearance>(plain) == nullptr);
+
+        int chunks = 0;
+        int entities = 0;
+        query.selectChunks(world, [&](size_t count, EntityId const*, Appearance const& look, Counter const* counters) {
+            for (size_t index = 0; index != count; ++index) {
+                CHECK((look.mesh == 3) == (counters[index].value == 2));
+            }
+            ++chunks;
+            entities += static_cast<int>(count);
+        });
+        CHECK(chunks == 2);
+        CHECK(entities == 12);
+
+        // replacing the value moves the entity to the other archetype
+        world.addComponent(cubes[5], Appearance{3, 2});
+        CHECK(chunkOf(cubes[5]) == chunkOf(sphere));
+        CHECK(world.getComponentSlow<Counter>(cubes[5])->value == 1);
+
+        world.removeComponent<Appearance>(sphere);
+        CHECK(world.readComponentSlow<Appearance>(sphere) == nullptr);
+        CHECK(world.getComponentSlow<Counter>(sphere)->value == 2);
+
+        vector<byte> snapshot;
+        REQUIRE(world.saveSnapshot(snapshot));
+        auto loaded = universe.createWorld();
+        REQUIRE(loaded.loadSnapshot(snapshot));
+        CHECK(loaded.readComponentSlow<Appearance>(cubes[5])->mesh == 3);
+        CHECK(loaded.readComponentSlow<Appearance>(plain) == world.readComponentSlow<Appearance>(cubes[0]));
+        CHECK(loaded.readComponentSlow<Appearance>(sphere) == nullptr);
+
+        // a value no live chunk uses is destroyed, and is decoded again when an entity next uses it
+        universe.registerSharedComponent<Label>("Label");
+        string_view const name = "a shared label long enough to need an allocation";
+        EntityId labelled = world.createEntity(Counter{5}, Label{string(name)});
+        world.deleteEntity(labelled);
+        labelled = world.createEntity(Counter{6}, Label{string(name)});
+        REQUIRE(world.readComponentSlow<Label>(labelled) != nullptr);
+        CHECK(world.readComponentSlow<Label>(labelled)->name == name);
+    }
+
+    SECTION("split components") {
+        universe.registerComponent<Particle>("Particle");
+
+        auto world = universe.createWorld();
+
+        auto const particleOf = [](World& world, EntityId entity) {
+            Particle result{};
+            world.interrogateEntityUnsafe(entity, [&](EntityId, ArchetypeId, reflex::TypeInfo const* type, void* data) {
+                if (type->name == "Particle") {
+                    result = *static_cast<Particle*>(data);
+                }
+            });
+            return result;
+        };
+
+        auto const particles = world.createEntities(100, Particle{1.f, 2.f, 3.f, 4});
+        EntityId const counted = world.createEntity(Counter{7}, Particle{5.f, 6.f, 7.f, 8});
+
+        // the fields are not contiguous, so there is no pointer to the whole component
+        CHECK(world.getComponentSlow<Particle>(particles[0]) == nullptr);
+        CHECK(world.hasComponent(particles[0], ComponentId(universe.findComponentByName("Particle")->hash)));
+        CHECK(particleOf(world, particles[99]).z == 3.f);
+        CHECK(particleOf(world, counted).age == 8);
+
+        // changes made through interrogation are written back to the sub-columns
+        world.interrogateEntityUnsafe(particles[10], [](EntityId, ArchetypeId, auto, void* data) {
+            static_cast<Particle*>(data)->y = 20.f;
+        });
+        CHECK(particleOf(world, particles[10]).y == 20.f);
+        CHECK(particleOf(world, particles[11]).y == 2.f);
+
+        // values survive being relocated within a chunk and moved between archetypes
+        world.deleteEntity(particles[0]);
+        CHECK(particleOf(world, particles[99]).x == 1.f);
+        world.addComponent(particles[10], Counter{1});
+        CHECK(particleOf(world, particles[10]).y == 20.f);
+        world.removeComponent<Counter>(counted);
+        CHECK(particleOf(world, counted).x == 5.f);
+        world.addComponent(counted, Particle{9.f, 9.f, 9.f, 9});
+        CHECK(particleOf(world, counted).age == 9);
+        CHECK(*world.readFieldSlow(counted, &Particle::z) == 9.f);
+
+        auto clone = world.clone();
+        clone.addComponent(particles[20], Particle{0.f, 0.f, 0.f, 0});
+        CHECK(particleOf(clone, particles[20]).age == 0);
+        CHECK(particleOf(clone, particles[21]).age == 4);
+        CHECK(particleOf(world, particles[20]).age == 4);
+
+        vector<byte> snapshot;
+        REQUIRE(world.saveSnapshot(snapshot));
+        auto loaded = universe.createWorld();
+        REQUIRE(loaded.loadSnapshot(snapshot));
+        CHECK(particleOf(loaded, particles[10]).y == 20.f);
+        CHECK(particleOf(loaded, counted).age == 9);
+        CHECK(particleOf(loaded, particles[50]).z == 3.f);
+    }
+
+    SECTION("hierarchy") {
+        registerHierarchyComponents(universe);
+
+        auto world = universe.createWorld();
+        EntityId const root = world.createEntity(Counter{0});
+        EntityId const child = world.createEntity(Counter{1});
+        EntityId const grandchild = world.createEntity(Counter{2});
+        EntityId const other = world.createEntity(Counter{3});
+
+        setParent(world, grandchild, child);
+        setParent(world, child, root);
+        CHECK(parentOf(world, child) == root);
+        CHECK(parentOf(world, root) == EntityId::None);
+        CHECK(depthOf(world, root) == 0);
+        CHECK(depthOf(world, child) == 1);
+        CHECK(firstChildOf(world, root) == child);
+        CHECK(nextSiblingOf(world, child) == EntityId::None);
+
+        // attaching a subtree moves all of its descendants down
+        CHECK(depthOf(world, grandchild) == 2);
+
+        // reparenting unlinks the entity from its old parent
+        setParent(world, other, root);
+        setParent(world, grandchild, other);
+        CHECK(firstChildOf(world, child) == EntityId::None);
+        CHECK(world.readComponentSlow<Children>(child) == nullptr);
+        CHECK(nextSiblingOf(world, child) == other);
+        CHECK(depthOf(world, grandchild) == 2);
+
+        // detaching a subtree lifts its descendants back up
+        setParent(world, other, EntityId::None);
+        CHECK(parentOf(world, other) == EntityId::None);
+        CHECK(world.readComponentSlow<HierarchyDepth>(other) == nullptr);
+        CHECK(depthOf(world, grandchild) == 1);
+        CHECK(nextSiblingOf(world, child) == EntityId::None);
+        CHECK(world.readComponentSlow<Children>(root)->last == child);
+        CHECK(world.readComponentSlow<Counter>(grandchild)->value == 2);
+    }
+
+    SECTION("observers") {
+        auto world = universe.createWorld();
+
+        vector<EntityId> added;
+        vector<EntityId> removed;
+        vector<EntityId> deleted;
+        int batches = 0;
+        world.observe<Counter>(ObserverEvent::Added, [&](view<EntityId> entities) {
+            added.insert(added.end(), entities.begin(), entities.end());
+            ++batches;
+        });
+        ObserverId const removedObserver = world.observe<Counter>(ObserverEvent::Removed, [&](view<EntityId> entities) {
+            removed.insert(removed.end(), entities.begin(), entities.end());
+        });
+        world.observe<Counter>(ObserverEvent::Deleted, [&](view<EntityId> entities) {
+            deleted.insert(deleted.end(), entities.begin(), entities.end());
+        });
+
+        auto const spawned = world.createEntities(100, Counter{1});
+        EntityId const single = world.createEntity(Test1{'a'});
+        world.addComponent(single, Counter{2});
+        world.addComponent(single, Counter{3});
+        world.addComponent(single, Second{1.f, 'b'});
+
+        // nothing is delivered until notification, and then only once per observer
+        CHECK(added.empty());
+        world.notifyObservers();
+        CHECK(batches == 1);
+        REQUIRE(added.size() == 101);
+        CHECK(added.front() == spawned.front());
+        CHECK(added.back() == single);
+
+        world.removeComponent<Counter>(single);
+        world.removeComponent<Test1>(spawned[0]);
+        world.deleteEntity(spawned[1]);
+        world.deleteEntity(single);
+        world.notifyObservers();
+        CHECK(batches == 1);
+        REQUIRE(removed.size() == 1);
+        CHECK(removed[0] == single);
+        REQUIRE(deleted.size() == 1);
+        CHECK(deleted[0] == spawned[1]);
+
+        world.unobserve(removedObserver);
+        world.removeComponent<Counter>(spawned[2]);
+        world.notifyObservers();
+        CHECK(removed.size() == 1);
+
+        // clones start without observers
+        auto clone = world.clone();
+        clone.deleteEntity(spawned[3]);
+        clone.notifyObservers();
+        CHECK(deleted.size() == 1);
+    }
+
     SECTION("iterrogate entities") {
         auto world = universe.createWorld();
 
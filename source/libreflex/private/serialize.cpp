@@ -12,6 +12,7 @@
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
 #include <nlohmann/json.hpp>
+#include <cstring>
 
 namespace up::reflex::_detail {
     static bool encodeObject(nlohmann::json& json, Schema const& schema, void const* obj);
@@ -26,6 +27,9 @@ namespace up::reflex::_detail {
     static bool decodeUuid(nlohmann::json const& json, Schema const& schema, void* obj);
     static bool decodeValue(nlohmann::json const& json, Schema const& schema, void* obj);
 
+    static bool encodeBinaryValue(vector<byte>& out, Schema const& schema, void const* obj);
+    static bool decodeBinaryValue(view<byte>& in, Schema const& schema, void* obj);
+
     static int64 readInt(Schema const& schema, void const* obj);
     static void writeInt(Schema const& schema, void* obj, int64 value);
 } // namespace up::reflex::_detail
@@ -40,6 +44,16 @@ bool up::reflex::decodeFromJsonRaw(nlohmann::json const& json, Schema const& sch
     return _detail::decodeValue(json, schema, memory);
 }
 
+bool up::reflex::encodeToBinaryRaw(vector<byte>& out, Schema const& schema, void const* memory) {
+    UP_ASSERT(memory != nullptr);
+    return _detail::encodeBinaryValue(out, schema, memory);
+}
+
+bool up::reflex::decodeFromBinaryRaw(view<byte>& in, Schema const& schema, void* memory) {
+    UP_ASSERT(memory != nullptr);
+    return _detail::decodeBinaryValue(in, schema, memory);
+}
+
 bool up::reflex::_detail::encodeObject(nlohmann::json& json, Schema const& schema, void const* obj) {
     UP_ASSERT(schema.primitive == SchemaPrimitive::Object);
 
@@ -413,3 +427,224 @@ void up::reflex::_detail::writeInt(Schema const& schema, void* obj, int64 value)
             break;
     }
 }
+
+namespace up::reflex::_detail {
+    static void writeBytes(vector<byte>& out, void const* data, size_t size) {
+        auto const offset = out.size();
+        out.resize(offset + size);
+        std::memcpy(out.data() + offset, data, size);
+    }
+
+    static bool readBytes(view<byte>& in, void* data, size_t size) {
+        if (in.size() < size) {
+            return false;
+        }
+        std::memcpy(data, in.data(), size);
+        in = in.subspan(size);
+        return true;
+    }
+
+    template <typename T>
+    static void writeRaw(vector<byte>& out, T const& value) {
+        writeBytes(out, &value, sizeof(value));
+    }
+
+    template <typename T>
+    static bool readRaw(view<byte>& in, T& value) {
+        return readBytes(in, &value, sizeof(value));
+    }
+
+    static void writeString(vector<byte>& out, string_view text) {
+        writeRaw(out, static_cast<uint32>(text.size()));
+        writeBytes(out, text.data(), text.size());
+    }
+
+    static bool readString(view<byte>& in, string& text) {
+        uint32 length = 0;
+        if (!readRaw(in, length) || in.size() < length) {
+            return false;
+        }
+        text = string(string_view(reinterpret_cast<char const*>(in.data()), length));
+        in = in.subspan(length);
+        return true;
+    }
+} // namespace up::reflex::_detail
+
+bool up::reflex::_detail::encodeBinaryValue(vector<byte>& out, Schema const& schema, void const* obj) {
+    switch (schema.primitive) {
+        case SchemaPrimitive::Bool:
+            writeRaw(out, *static_cast<bool const*>(obj));
+            return true;
+        case SchemaPrimitive::Int8:
+        case SchemaPrimitive::UInt8:
+            writeBytes(out, obj, 1);
+            return true;
+        case SchemaPrimitive::Int16:
+        case SchemaPrimitive::UInt16:
+            writeBytes(out, obj, 2);
+            return true;
+        case SchemaPrimitive::Int32:
+        case SchemaPrimitive::UInt32:
+        case SchemaPrimitive::Float:
+            writeBytes(out, obj, 4);
+            return true;
+        case SchemaPrimitive::Int64:
+        case SchemaPrimitive::UInt64:
+        case SchemaPrimitive::Double:
+            writeBytes(out, obj, 8);
+            return true;
+        case SchemaPrimitive::Vec3:
+            writeRaw(out, *static_cast<glm::vec3 const*>(obj));
+            return true;
+        case SchemaPrimitive::Mat4x4:
+            writeRaw(out, *static_cast<glm::mat4x4 const*>(obj));
+            return true;
+        case SchemaPrimitive::Quat:
+            writeRaw(out, *static_cast<glm::quat const*>(obj));
+            return true;
+        case SchemaPrimitive::Enum:
+            writeRaw(out, readInt(*schema.elementType, obj));
+            return true;
+        case SchemaPrimitive::String:
+            writeString(out, *static_cast<string const*>(obj));
+            return true;
+        case SchemaPrimitive::Pointer:
+            if (schema.operations->pointerDeref != nullptr) {
+                void const* const pointee = schema.operations->pointerDeref(obj);
+                writeRaw(out, pointee != nullptr);
+                return pointee == nullptr || encodeBinaryValue(out, *schema.elementType, pointee);
+            }
+            return false;
+        case SchemaPrimitive::Array: {
+            if (schema.operations->arrayGetSize == nullptr || schema.operations->arrayElementAt == nullptr) {
+                return false;
+            }
+            size_t const size = schema.operations->arrayGetSize(obj);
+            writeRaw(out, static_cast<uint32>(size));
+            bool success = true;
+            for (size_t index = 0; index != size; ++index) {
+                void const* const elem = schema.operations->arrayElementAt(obj, index);
+                success = encodeBinaryValue(out, *schema.elementType, elem) && success;
+            }
+            return success;
+        }
+        case SchemaPrimitive::Object: {
+            bool success = true;
+            for (SchemaField const& field : schema.fields) {
+                success =
+                    encodeBinaryValue(out, *field.schema, static_cast<char const*>(obj) + field.offset) && success;
+            }
+            return success;
+        }
+        case SchemaPrimitive::AssetRef: {
+            AssetKey const& key = static_cast<UntypedAssetHandle const*>(obj)->assetKey();
+            writeBytes(out, key.uuid.bytes(), UUID::octects);
+            writeString(out, key.logical);
+            return true;
+        }
+        case SchemaPrimitive::Uuid:
+            writeBytes(out, static_cast<UUID const*>(obj)->bytes(), UUID::octects);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool up::reflex::_detail::decodeBinaryValue(view<byte>& in, Schema const& schema, void* obj) {
+    switch (schema.primitive) {
+        case SchemaPrimitive::Bool:
+            return readRaw(in, *static_cast<bool*>(obj));
+        case SchemaPrimitive::Int8:
+        case SchemaPrimitive::UInt8:
+            return readBytes(in, obj, 1);
+        case SchemaPrimitive::Int16:
+        case SchemaPrimitive::UInt16:
+            return readBytes(in, obj, 2);
+        case SchemaPrimitive::Int32:
+        case SchemaPrimitive::UInt32:
+        case SchemaPrimitive::Float:
+            return readBytes(in, obj, 4);
+        case SchemaPrimitive::Int64:
+        case SchemaPrimitive::UInt64:
+        case SchemaPrimitive::Double:
+            return readBytes(in, obj, 8);
+        case SchemaPrimitive::Vec3:
+            return readRaw(in, *static_cast<glm::vec3*>(obj));
+        case SchemaPrimitive::Mat4x4:
+            return readRaw(in, *static_cast<glm::mat4x4*>(obj));
+        case SchemaPrimitive::Quat:
+            return readRaw(in, *static_cast<glm::quat*>(obj));
+        case SchemaPrimitive::Enum: {
+            int64 value = 0;
+            if (!readRaw(in, value)) {
+                return false;
+            }
+            writeInt(*schema.elementType, obj, value);
+            return true;
+        }
+        case SchemaPrimitive::String:
+            return readString(in, *static_cast<string*>(obj));
+        case SchemaPrimitive::Pointer: {
+            bool present = false;
+            if (!readRaw(in, present)) {
+                return false;
+            }
+            if (!present && schema.operations->pointerAssign != nullptr) {
+                schema.operations->pointerAssign(obj, nullptr);
+                return true;
+            }
+            if (present && schema.operations->pointerMutableDeref != nullptr) {
+                if (void* const pointee = schema.operations->pointerMutableDeref(obj)) {
+                    return decodeBinaryValue(in, *schema.elementType, pointee);
+                }
+            }
+            return false;
+        }
+        case SchemaPrimitive::Array: {
+            if (schema.operations->arrayResize == nullptr || schema.operations->arrayMutableElementAt == nullptr) {
+                return false;
+            }
+            uint32 size = 0;
+            if (!readRaw(in, size)) {
+                return false;
+            }
+            schema.operations->arrayResize(obj, size);
+            for (uint32 index = 0; index != size; ++index) {
+                void* const elem = schema.operations->arrayMutableElementAt(obj, index);
+                if (!decodeBinaryValue(in, *schema.elementType, elem)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case SchemaPrimitive::Object:
+            // unlike JSON, fields are not self-describing, so any failure leaves the rest unreadable
+            for (SchemaField const& field : schema.fields) {
+                if (!decodeBinaryValue(in, *field.schema, static_cast<char*>(obj) + field.offset)) {
+                    return false;
+                }
+            }
+            return true;
+        case SchemaPrimitive::AssetRef: {
+            UUID::Bytes bytes = {};
+            AssetKey key;
+            if (!readBytes(in, bytes, sizeof(bytes)) || !readString(in, key.logical)) {
+                return false;
+            }
+            key.uuid = UUID(bytes);
+            auto* const assetHandle = static_cast<UntypedAssetHandle*>(obj);
+            *assetHandle = key.uuid.isValid() ? UntypedAssetHandle(std::move(key)) : UntypedAssetHandle();
+            return true;
+        }
+        case SchemaPrimitive::Uuid: {
+            UUID::Bytes bytes = {};
+            if (!readBytes(in, bytes, sizeof(bytes))) {
+                return false;
+            }
+            *static_cast<UUID*>(obj) = UUID(bytes);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
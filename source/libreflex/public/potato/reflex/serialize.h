@@ -18,6 +18,24 @@ namespace up::reflex {
         return decodeFromJsonRaw(json, getSchema<T>(), &reinterpret_cast<char&>(value));
     }
 
+    /// @brief Appends a compact binary encoding of a value to a buffer.
+    ///
+    /// Fields are written in schema order without names, so the encoding can only be
+    /// decoded with the same schema that produced it.
+    template <has_schema T>
+    bool encodeToBinary(vector<byte>& out, T const& value) {
+        return encodeToBinaryRaw(out, getSchema<T>(), &reinterpret_cast<char const&>(value));
+    }
+
+    /// @brief Decodes a value written by encodeToBinary, advancing the input past the consumed bytes.
+    template <has_schema T>
+    bool decodeFromBinary(view<byte>& in, T& value) {
+        return decodeFromBinaryRaw(in, getSchema<T>(), &reinterpret_cast<char&>(value));
+    }
+
     UP_REFLEX_API bool encodeToJsonRaw(nlohmann::json& json, Schema const& schema, void const* memory);
     UP_REFLEX_API bool decodeFromJsonRaw(nlohmann::json const& json, Schema const& schema, void* memory);
+
+    UP_REFLEX_API bool encodeToBinaryRaw(vector<byte>& out, Schema const& schema, void const* memory);
+    UP_REFLEX_API bool decodeFromBinaryRaw(view<byte>& in, Schema const& schema, void* memory);
 } // namespace up::reflex
@@ -33,6 +33,14 @@ namespace up::reflex {
         size_t size = 0;
         size_t alignment = 0;
         TypeOps ops;
+        /// Instances may be copied with memcpy instead of ops.copyConstructor.
+        bool triviallyCopyable = false;
+        /// Instances need not have ops.destructor called.
+        bool triviallyDestructible = false;
+        /// Instances may be moved to new memory with memcpy, leaving nothing to destroy at the source.
+        bool triviallyRelocatable = false;
+        /// The type has no data members, so its instances need no storage of their own.
+        bool empty = false;
     };
 
     template <typename T>
@@ -92,6 +100,10 @@ namespace up::reflex {
         info.size = sizeof(T);
         info.alignment = alignof(T);
         info.ops = makeTypeOps<T>();
+        info.triviallyCopyable = std::is_trivially_copyable_v<T>;
+        info.triviallyDestructible = std::is_trivially_destructible_v<T>;
+        info.triviallyRelocatable = std::is_trivially_move_constructible_v<T> && std::is_trivially_destructible_v<T>;
+        info.empty = std::is_empty_v<T>;
         return info;
     }
 } // namespace up::reflex
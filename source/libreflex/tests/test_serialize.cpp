@@ -49,4 +49,30 @@ TEST_CASE("potato.reflex.Serialize", "[potato][reflex]") {
         CHECK(comp.values[2] == 6'000'000'000.f);
         CHECK(comp.test.test == TestEnum::Second);
     }
+
+    SECTION("binary round trip") {
+        TestComplex comp;
+        comp.name = "Frederick"_s;
+        comp.values.push_back(42.f);
+        comp.values.push_back(-7.f);
+        comp.test.test = TestEnum::Second;
+
+        vector<byte> buffer;
+        CHECK(reflex::encodeToBinary(buffer, comp));
+
+        TestComplex decoded;
+        view<byte> in = buffer;
+        CHECK(reflex::decodeFromBinary(in, decoded));
+        CHECK(in.empty());
+
+        CHECK(decoded.name == "Frederick"_s);
+        REQUIRE(decoded.values.size() == 2);
+        CHECK(decoded.values[0] == 42.f);
+        CHECK(decoded.values[1] == -7.f);
+        CHECK(decoded.test.test == TestEnum::Second);
+
+        // truncated input must be rejected rather than read past the end
+        view<byte> truncated = view<byte>(buffer).first(buffer.size() - 1);
+        CHECK_FALSE(reflex::decodeFromBinary(truncated, decoded));
+    }
 }
@@ -0,0 +1,53 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "bounds.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+auto up::Frustum::fromViewProjection(glm::mat4x4 const& viewProjection) noexcept -> Frustum {
+    // Gribb & Hartmann; glm matrices are column-major, so row i is m[0][i], m[1][i], m[2][i], m[3][i]
+    auto const row = [&viewProjection](int index) {
+        return glm::vec4{
+            viewProjection[0][index],
+            viewProjection[1][index],
+            viewProjection[2][index],
+            viewProjection[3][index]};
+    };
+
+    glm::vec4 const x = row(0);
+    glm::vec4 const y = row(1);
+    glm::vec4 const z = row(2);
+    glm::vec4 const w = row(3);
+
+    // with a clip depth of 0..1 the near plane is z >= 0 rather than z >= -w
+    return Frustum{.planes = {w + x, w - x, w + y, w - y, z, w - z}};
+}
+
+bool up::Frustum::intersects(Aabb const& bounds) const noexcept {
+    glm::vec3 const center = bounds.center();
+    glm::vec3 const extent = bounds.extent();
+    for (glm::vec4 const& plane : planes) {
+        glm::vec3 const normal{plane.x, plane.y, plane.z};
+        if (glm::dot(normal, center) + plane.w < -glm::dot(glm::abs(normal), extent)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+auto up::transformBounds(Aabb const& bounds, glm::mat4x4 const& transform) noexcept -> Aabb {
+    // Arvo; each column's contribution to the extent is its absolute value scaled by the extent's axis
+    glm::vec3 const center = bounds.center();
+    glm::vec3 const extent = bounds.extent();
+
+    glm::vec3 worldCenter{transform[3]};
+    glm::vec3 worldExtent{0, 0, 0};
+    for (int axis = 0; axis != 3; ++axis) {
+        glm::vec3 const column{transform[axis]};
+        worldCenter += column * center[axis];
+        worldExtent += glm::abs(column) * extent[axis];
+    }
+
+    return Aabb{.min = worldCenter - worldExtent, .max = worldCenter + worldExtent};
+}
@@ -67,6 +67,7 @@ void up::RenderCamera::updateBuffers(
     constexpr float fovDeg = 75.f;
 
     auto projection = glm::perspectiveFovRH_ZO(glm::radians(fovDeg), viewport.width, viewport.height, nearZ, farZ);
+    _viewProjection = projection * cameraTransform;
 
     auto data = CameraData{
         .worldViewProjection = cameraTransform * projection,
@@ -111,6 +112,7 @@ void up::RenderCamera::beginFrame(RenderContext& ctx, glm::vec3 cameraPosition,
     constexpr float fovDeg = 75.f;
 
     auto projection = glm::perspectiveFovRH_ZO(glm::radians(fovDeg), viewport.width, viewport.height, nearZ, farZ);
+    _viewProjection = projection * cameraTransform;
 
     auto data = CameraData{
         .worldViewProjection = cameraTransform * projection,
@@ -10,6 +10,7 @@
 
 #include "potato/spud/sequence.h"
 
+#include <glm/common.hpp>
 #include <glm/vec3.hpp>
 
 namespace {
@@ -32,12 +33,14 @@ up::Mesh::Mesh(
     vector<up::uint16> indices,
     vector<up::byte> data,
     view<MeshBuffer> buffers,
-    view<MeshChannel> channels)
+    view<MeshChannel> channels,
+    Aabb const& bounds)
     : AssetBase(std::move(key))
     , _buffers(buffers.begin(), buffers.end())
     , _channels(channels.begin(), channels.end())
     , _indices(std::move(indices))
-    , _data(std::move(data)) {}
+    , _data(std::move(data))
+    , _bounds(bounds) {}
 
 up::Mesh::~Mesh() = default;
 
@@ -136,6 +139,8 @@ auto up::Mesh::createFromBuffer(AssetKey key, view<byte> buffer) -> rc<Mesh> {
         indices.push_back(flatIndices->Get(i));
     }
 
+    Aabb bounds;
+
     for (uint32 i = 0; i != numVertices; ++i) {
         VertData& vert = data.emplace_back();
 
@@ -144,6 +149,9 @@ auto up::Mesh::createFromBuffer(AssetKey key, view<byte> buffer) -> rc<Mesh> {
         vert.pos.y = pos.y();
         vert.pos.z = pos.z();
 
+        bounds.min = i == 0 ? vert.pos : glm::min(bounds.min, vert.pos);
+        bounds.max = i == 0 ? vert.pos : glm::max(bounds.max, vert.pos);
+
         if (flatColors != nullptr) {
             auto color = *flatColors->Get(i);
             vert.color.x = color.x();
@@ -177,7 +185,8 @@ auto up::Mesh::createFromBuffer(AssetKey key, view<byte> buffer) -> rc<Mesh> {
         std::move(indices),
         vector(data.as_bytes()),
         span{&bufferDesc, 1},
-        channels);
+        channels,
+        bounds);
 }
 
 void UP_VECTORCALL up::Mesh::render(RenderContext& ctx, Material* material, glm::mat4x4 transform) {
@@ -0,0 +1,432 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "spatial_index.h"
+
+#include "potato/spud/platform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if UP_ARCH_INTEL
+#    include <xmmintrin.h>
+#endif
+
+namespace up {
+    namespace {
+        constexpr uint32 blockWidth = 4;
+        constexpr uint32 blockFloats = blockWidth * 6;
+
+        enum class Containment { Outside, Intersects, Inside };
+
+        auto boundsAt(vector<float> const& bounds, uint32 slot, int component) noexcept -> float {
+            return bounds[slot / blockWidth * blockFloats + component * blockWidth + slot % blockWidth];
+        }
+
+        auto boundsAt(vector<float>& bounds, uint32 slot, int component) noexcept -> float& {
+            return bounds[slot / blockWidth * blockFloats + component * blockWidth + slot % blockWidth];
+        }
+
+        // bit per lane holding an entry, for a block starting at the given slot
+        auto laneMask(size_t count, size_t slot) noexcept -> int {
+            return count - slot >= blockWidth ? 0xF : (1 << (count - slot)) - 1;
+        }
+
+        auto classify(Frustum const& frustum, glm::vec3 center, float extent) noexcept -> Containment {
+            auto result = Containment::Inside;
+            for (glm::vec4 const& plane : frustum.planes) {
+                float const distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+                float const radius = (std::abs(plane.x) + std::abs(plane.y) + std::abs(plane.z)) * extent;
+                if (distance < -radius) {
+                    return Containment::Outside;
+                }
+                if (distance < radius) {
+                    result = Containment::Intersects;
+                }
+            }
+            return result;
+        }
+
+        // slab test; the distance is clamped to zero for a ray starting inside the box
+        bool intersectRay(
+            glm::vec3 origin,
+            glm::vec3 inverseDirection,
+            glm::vec3 center,
+            glm::vec3 extent,
+            float& distance) noexcept {
+            float enter = 0.f;
+            float leave = distance;
+            for (int axis = 0; axis != 3; ++axis) {
+                float const offset = center[axis] - origin[axis];
+                // a ray parallel to the slab must start within it; the distances would be 0 * inf = NaN on its planes
+                if (std::isinf(inverseDirection[axis])) {
+                    if (std::abs(offset) > extent[axis]) {
+                        return false;
+                    }
+                    continue;
+                }
+                float const t0 = (offset - extent[axis]) * inverseDirection[axis];
+                float const t1 = (offset + extent[axis]) * inverseDirection[axis];
+                enter = std::max(enter, std::min(t0, t1));
+                leave = std::min(leave, std::max(t0, t1));
+            }
+            if (enter > leave) {
+                return false;
+            }
+            distance = enter;
+            return true;
+        }
+
+#if UP_ARCH_INTEL
+        // entry and exit distances of four slabs along one axis, given their centers relative to the ray's origin
+        void slabDistances(__m128 offset, __m128 extent, float inverse, __m128& t0, __m128& t1) noexcept {
+            if (std::isinf(inverse)) {
+                // parallel to the axis; a slab containing the origin never limits the ray,
+                // and any other is entered at infinity
+                float const infinity = std::numeric_limits<float>::infinity();
+                __m128 const magnitude = _mm_andnot_ps(_mm_set1_ps(-0.f), offset);
+                __m128 const inside = _mm_cmple_ps(magnitude, extent);
+                t0 = _mm_or_ps(
+                    _mm_and_ps(inside, _mm_set1_ps(-infinity)),
+                    _mm_andnot_ps(inside, _mm_set1_ps(infinity)));
+                t1 = _mm_set1_ps(infinity);
+                return;
+            }
+            __m128 const scale = _mm_set1_ps(inverse);
+            t0 = _mm_mul_ps(_mm_sub_ps(offset, extent), scale);
+            t1 = _mm_mul_ps(_mm_add_ps(offset, extent), scale);
+        }
+#endif
+    } // namespace
+} // namespace up
+
+up::SpatialIndex::SpatialIndex(float halfSize, uint32 maxDepth) : _maxDepth(maxDepth) {
+    _nodes.push_back(Node{.halfSize = halfSize});
+}
+
+up::SpatialIndex::~SpatialIndex() = default;
+
+void up::SpatialIndex::update(uint64 key, Aabb const& bounds) {
+    glm::vec3 const center = bounds.center();
+    glm::vec3 const extent = bounds.extent();
+    uint32 const nodeIndex = _nodeFor(center, extent);
+
+    if (auto const entry = _entries.find(key)) {
+        Location const location = entry->value;
+        if (location.node == nodeIndex) {
+            Node& node = _nodes[nodeIndex];
+            for (int axis = 0; axis != 3; ++axis) {
+                boundsAt(node.bounds, location.slot, axis) = center[axis];
+                boundsAt(node.bounds, location.slot, 3 + axis) = extent[axis];
+            }
+            return;
+        }
+        _erase(location);
+    }
+
+    _insert(nodeIndex, key, center, extent);
+}
+
+bool up::SpatialIndex::remove(uint64 key) noexcept {
+    auto const entry = _entries.find(key);
+    if (!entry) {
+        return false;
+    }
+
+    _erase(entry->value);
+    _entries.erase(key);
+    return true;
+}
+
+void up::SpatialIndex::clear() noexcept {
+    for (Node& node : _nodes) {
+        node.population = 0;
+        node.bounds.clear();
+        node.keys.clear();
+    }
+    _entries.clear();
+}
+
+void up::SpatialIndex::queryFrustum(Frustum const& frustum, vector<uint64>& keys) const {
+    // entries outside of the root's cube are kept in the root, so it is never culled itself
+    _queryFrustum(0, frustum, false, keys);
+}
+
+auto up::SpatialIndex::raycast(Ray const& ray, float maxDistance) const noexcept -> RayHit {
+    RayHit hit{.distance = maxDistance};
+    _raycast(0, ray.origin, 1.f / ray.direction, hit);
+    return hit;
+}
+
+auto up::SpatialIndex::_nodeFor(glm::vec3 center, glm::vec3 extent) -> uint32 {
+    float const size = std::max({extent.x, extent.y, extent.z});
+
+    Node const& root = _nodes.front();
+    glm::vec3 const offset = center - root.center;
+    // written so that a NaN center is also kept in the root
+    if (!(std::abs(offset.x) <= root.halfSize && std::abs(offset.y) <= root.halfSize &&
+          std::abs(offset.z) <= root.halfSize)) {
+        return 0;
+    }
+
+    // an entry fits anywhere in a child's loose bounds if it is no larger than the child's cube
+    uint32 nodeIndex = 0;
+    for (uint32 depth = 0; depth != _maxDepth && size <= _nodes[nodeIndex].halfSize * .5f; ++depth) {
+        if (_nodes[nodeIndex].firstChild == 0) {
+            _subdivide(nodeIndex);
+        }
+
+        Node const& node = _nodes[nodeIndex];
+        uint32 const octant = (center.x >= node.center.x ? 1 : 0) | (center.y >= node.center.y ? 2 : 0) |
+            (center.z >= node.center.z ? 4 : 0);
+        nodeIndex = node.firstChild + octant;
+    }
+    return nodeIndex;
+}
+
+void up::SpatialIndex::_subdivide(uint32 nodeIndex) {
+    glm::vec3 const center = _nodes[nodeIndex].center;
+    float const halfSize = _nodes[nodeIndex].halfSize * .5f;
+
+    // the vector may grow, so no reference into it is held across the loop
+    auto const firstChild = static_cast<uint32>(_nodes.size());
+    for (uint32 octant = 0; octant != 8; ++octant) {
+        glm::vec3 const direction{
+            (octant & 1) != 0 ? 1.f : -1.f,
+            (octant & 2) != 0 ? 1.f : -1.f,
+            (octant & 4) != 0 ? 1.f : -1.f};
+        _nodes.push_back(Node{.center = center + direction * halfSize, .halfSize = halfSize, .parent = nodeIndex});
+    }
+    _nodes[nodeIndex].firstChild = firstChild;
+}
+
+void up::SpatialIndex::_insert(uint32 nodeIndex, uint64 key, glm::vec3 center, glm::vec3 extent) {
+    Node& node = _nodes[nodeIndex];
+
+    auto const slot = static_cast<uint32>(node.keys.size());
+    if (slot % blockWidth == 0) {
+        node.bounds.resize(node.bounds.size() + blockFloats);
+    }
+    node.keys.push_back(key);
+    for (int axis = 0; axis != 3; ++axis) {
+        boundsAt(node.bounds, slot, axis) = center[axis];
+        boundsAt(node.bounds, slot, 3 + axis) = extent[axis];
+    }
+
+    _entries.insert(key, Location{.node = nodeIndex, .slot = slot});
+
+    for (uint32 index = nodeIndex;; index = _nodes[index].parent) {
+        ++_nodes[index].population;
+        if (index == 0) {
+            break;
+        }
+    }
+}
+
+void up::SpatialIndex::_erase(Location location) noexcept {
+    Node& node = _nodes[location.node];
+
+    // the last entry of the node takes the place of the erased entry
+    auto const last = static_cast<uint32>(node.keys.size() - 1);
+    if (location.slot != last) {
+        node.keys[location.slot] = node.keys[last];
+        for (int component = 0; component != 6; ++component) {
+            boundsAt(node.bounds, location.slot, component) = boundsAt(node.bounds, last, component);
+        }
+        _entries.find(node.keys[location.slot])->value.slot = location.slot;
+    }
+    node.keys.pop_back();
+    if (last % blockWidth == 0) {
+        node.bounds.resize(node.bounds.size() - blockFloats);
+    }
+
+    for (uint32 index = location.node;; index = _nodes[index].parent) {
+        --_nodes[index].population;
+        if (index == 0) {
+            break;
+        }
+    }
+}
+
+void up::SpatialIndex::_queryFrustum(
+    uint32 nodeIndex,
+    Frustum const& frustum,
+    bool contained,
+    vector<uint64>& keys) const {
+    Node const& node = _nodes[nodeIndex];
+    if (node.population == 0) {
+        return;
+    }
+
+    if (!contained && nodeIndex != 0) {
+        auto const containment = classify(frustum, node.center, node.halfSize * 2.f);
+        if (containment == Containment::Outside) {
+            return;
+        }
+        // nothing below a node entirely inside the frustum needs to be tested
+        contained = containment == Containment::Inside;
+    }
+
+    if (contained) {
+        keys.insert(keys.end(), node.keys.begin(), node.keys.end());
+    }
+    else {
+        size_t slot = 0;
+#if UP_ARCH_INTEL
+        __m128 planeX[6];
+        __m128 planeY[6];
+        __m128 planeZ[6];
+        __m128 planeW[6];
+        __m128 absX[6];
+        __m128 absY[6];
+        __m128 absZ[6];
+        for (int index = 0; index != 6; ++index) {
+            glm::vec4 const& plane = frustum.planes[index];
+            planeX[index] = _mm_set1_ps(plane.x);
+            planeY[index] = _mm_set1_ps(plane.y);
+            planeZ[index] = _mm_set1_ps(plane.z);
+            planeW[index] = _mm_set1_ps(plane.w);
+            absX[index] = _mm_set1_ps(std::abs(plane.x));
+            absY[index] = _mm_set1_ps(std::abs(plane.y));
+            absZ[index] = _mm_set1_ps(std::abs(plane.z));
+        }
+
+        __m128 const zero = _mm_setzero_ps();
+        for (; slot < node.keys.size(); slot += blockWidth) {
+            float const* const block = node.bounds.data() + slot / blockWidth * blockFloats;
+            __m128 const centerX = _mm_loadu_ps(block);
+            __m128 const centerY = _mm_loadu_ps(block + 4);
+            __m128 const centerZ = _mm_loadu_ps(block + 8);
+            __m128 const extentX = _mm_loadu_ps(block + 12);
+            __m128 const extentY = _mm_loadu_ps(block + 16);
+            __m128 const extentZ = _mm_loadu_ps(block + 20);
+
+            // a box is outside of a plane if its center is further behind it than the box's projected radius
+            __m128 visible = _mm_cmpeq_ps(zero, zero);
+            for (int index = 0; index != 6; ++index) {
+                __m128 const distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(planeX[index], centerX), _mm_mul_ps(planeY[index], centerY)),
+                    _mm_add_ps(_mm_mul_ps(planeZ[index], centerZ), planeW[index]));
+                __m128 const radius = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(absX[index], extentX), _mm_mul_ps(absY[index], extentY)),
+                    _mm_mul_ps(absZ[index], extentZ));
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+            }
+
+            int const mask = _mm_movemask_ps(visible) & laneMask(node.keys.size(), slot);
+            for (uint32 lane = 0; lane != blockWidth; ++lane) {
+                if ((mask & (1 << lane)) != 0) {
+                    keys.push_back(node.keys[slot + lane]);
+                }
+            }
+        }
+#endif
+
+        for (; slot < node.keys.size(); ++slot) {
+            auto const index = static_cast<uint32>(slot);
+            glm::vec3 const center{
+                boundsAt(node.bounds, index, 0),
+                boundsAt(node.bounds, index, 1),
+                boundsAt(node.bounds, index, 2)};
+            glm::vec3 const extent{
+                boundsAt(node.bounds, index, 3),
+                boundsAt(node.bounds, index, 4),
+                boundsAt(node.bounds, index, 5)};
+            if (frustum.intersects(Aabb{.min = center - extent, .max = center + extent})) {
+                keys.push_back(node.keys[slot]);
+            }
+        }
+    }
+
+    if (node.firstChild != 0) {
+        for (uint32 octant = 0; octant != 8; ++octant) {
+            _queryFrustum(node.firstChild + octant, frustum, contained, keys);
+        }
+    }
+}
+
+void up::SpatialIndex::_raycast(
+    uint32 nodeIndex,
+    glm::vec3 origin,
+    glm::vec3 inverseDirection,
+    RayHit& hit) const noexcept {
+    Node const& node = _nodes[nodeIndex];
+    if (node.population == 0) {
+        return;
+    }
+
+    // nodes starting beyond the nearest hit so far cannot hold a nearer one
+    if (nodeIndex != 0) {
+        float distance = hit.distance;
+        float const looseSize = node.halfSize * 2.f;
+        if (!intersectRay(origin, inverseDirection, node.center, {looseSize, looseSize, looseSize}, distance)) {
+            return;
+        }
+    }
+
+    size_t slot = 0;
+#if UP_ARCH_INTEL
+    __m128 const originX = _mm_set1_ps(origin.x);
+    __m128 const originY = _mm_set1_ps(origin.y);
+    __m128 const originZ = _mm_set1_ps(origin.z);
+    __m128 const zero = _mm_setzero_ps();
+
+    for (; slot < node.keys.size(); slot += blockWidth) {
+        float const* const block = node.bounds.data() + slot / blockWidth * blockFloats;
+        __m128 const centerX = _mm_sub_ps(_mm_loadu_ps(block), originX);
+        __m128 const centerY = _mm_sub_ps(_mm_loadu_ps(block + 4), originY);
+        __m128 const centerZ = _mm_sub_ps(_mm_loadu_ps(block + 8), originZ);
+        __m128 const extentX = _mm_loadu_ps(block + 12);
+        __m128 const extentY = _mm_loadu_ps(block + 16);
+        __m128 const extentZ = _mm_loadu_ps(block + 20);
+
+        __m128 x0, x1, y0, y1, z0, z1;
+        slabDistances(centerX, extentX, inverseDirection.x, x0, x1);
+        slabDistances(centerY, extentY, inverseDirection.y, y0, y1);
+        slabDistances(centerZ, extentZ, inverseDirection.z, z0, z1);
+
+        __m128 const enter = _mm_max_ps(
+            _mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)),
+            _mm_max_ps(_mm_min_ps(z0, z1), zero));
+        __m128 const leave = _mm_min_ps(
+            _mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)),
+            _mm_min_ps(_mm_max_ps(z0, z1), _mm_set1_ps(hit.distance)));
+
+        int const mask = _mm_movemask_ps(_mm_cmple_ps(enter, leave)) & laneMask(node.keys.size(), slot);
+        if (mask == 0) {
+            continue;
+        }
+
+        alignas(16) float distances[blockWidth];
+        _mm_store_ps(distances, enter);
+        for (uint32 lane = 0; lane != blockWidth; ++lane) {
+            if ((mask & (1 << lane)) != 0 && (!hit.hit || distances[lane] < hit.distance)) {
+                hit = RayHit{.key = node.keys[slot + lane], .distance = distances[lane], .hit = true};
+            }
+        }
+    }
+#endif
+
+    for (; slot < node.keys.size(); ++slot) {
+        auto const index = static_cast<uint32>(slot);
+        glm::vec3 const center{
+            boundsAt(node.bounds, index, 0),
+            boundsAt(node.bounds, index, 1),
+            boundsAt(node.bounds, index, 2)};
+        glm::vec3 const extent{
+            boundsAt(node.bounds, index, 3),
+            boundsAt(node.bounds, index, 4),
+            boundsAt(node.bounds, index, 5)};
+        float distance = hit.distance;
+        if (intersectRay(origin, inverseDirection, center, extent, distance) &&
+            (!hit.hit || distance < hit.distance)) {
+            hit = RayHit{.key = node.keys[slot], .distance = distance, .hit = true};
+        }
+    }
+
+    if (node.firstChild != 0) {
+        for (uint32 octant = 0; octant != 8; ++octant) {
+            _raycast(node.firstChild + octant, origin, inverseDirection, hit);
+        }
+    }
+}
@@ -0,0 +1,45 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#pragma once
+
+#include "_export.h"
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+namespace up {
+    /// @brief An axis-aligned bounding box.
+    struct Aabb {
+        glm::vec3 min = {0, 0, 0};
+        glm::vec3 max = {0, 0, 0};
+
+        glm::vec3 center() const noexcept { return (min + max) * .5f; }
+        glm::vec3 extent() const noexcept { return (max - min) * .5f; }
+    };
+
+    /// @brief A half-line, e.g. cast from the camera through the cursor for picking.
+    ///
+    /// Distances along the ray are measured in multiples of direction, so it should be normalized.
+    ///
+    struct Ray {
+        glm::vec3 origin = {0, 0, 0};
+        glm::vec3 direction = {0, 0, -1};
+    };
+
+    /// @brief The planes bounding the volume visible to a camera.
+    struct Frustum {
+        /// Each plane is (normal, distance) with the normal facing into the volume, so a point p
+        /// is on the visible side when dot(normal, p) + distance >= 0. Planes are not normalized.
+        glm::vec4 planes[6] = {};
+
+        /// @brief Extracts the planes of a projection * view matrix with a clip depth of 0..1.
+        UP_RENDER_API static auto fromViewProjection(glm::mat4x4 const& viewProjection) noexcept -> Frustum;
+
+        /// @brief Checks if any part of a box may be visible.
+        UP_RENDER_API bool intersects(Aabb const& bounds) const noexcept;
+    };
+
+    /// @brief Computes the bounds of a box after transformation, e.g. from model to world space.
+    UP_RENDER_API auto transformBounds(Aabb const& bounds, glm::mat4x4 const& transform) noexcept -> Aabb;
+} // namespace up
@@ -3,11 +3,12 @@
 #pragma once
 
 #include "_export.h"
+#include "bounds.h"
 
 #include "potato/spud/box.h"
 #include "potato/spud/rc.h"
 
-#include <glm/fwd.hpp>
+#include <glm/mat4x4.hpp>
 
 namespace up {
     class GpuBuffer;
@@ -34,11 +35,18 @@ namespace up {
             glm::mat4x4 cameraTransform);
         UP_RENDER_API void beginFrame(RenderContext& ctx, glm::vec3 cameraPosition, glm::mat4x4 cameraTransform);
 
+        /// @brief The projection * view matrix of the most recent frame.
+        glm::mat4x4 const& viewProjection() const noexcept { return _viewProjection; }
+
+        /// @brief The volume visible in the most recent frame, e.g. to cull what is rendered.
+        Frustum frustum() const noexcept { return Frustum::fromViewProjection(_viewProjection); }
+
     private:
         box<GpuBuffer> _cameraDataBuffer;
         rc<GpuTexture> _backBuffer;
         rc<GpuTexture> _depthStencilBuffer;
         box<GpuResourceView> _rtv;
         box<GpuResourceView> _dsv;
+        glm::mat4x4 _viewProjection = glm::mat4x4(1.f);
     };
 } // namespace up
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "_export.h"
+#include "bounds.h"
 #include "gpu_common.h"
 
 #include "potato/runtime/asset.h"
@@ -45,7 +46,8 @@ namespace up {
             vector<uint16> indices,
             vector<up::byte> data,
             view<MeshBuffer> buffers,
-            view<MeshChannel> channels);
+            view<MeshChannel> channels,
+            Aabb const& bounds = {});
         UP_RENDER_API ~Mesh() override;
 
         UP_RENDER_API static auto createFromBuffer(AssetKey key, view<byte>) -> rc<Mesh>;
@@ -58,6 +60,9 @@ namespace up {
 
         uint32 indexCount() const noexcept { return static_cast<uint32>(_indices.size()); }
 
+        /// @brief Bounds of the vertex positions in model space.
+        Aabb const& bounds() const noexcept { return _bounds; }
+
     private:
         box<GpuBuffer> _ibo;
         box<GpuBuffer> _vbo;
@@ -66,5 +71,6 @@ namespace up {
         vector<MeshChannel> _channels;
         vector<uint16> _indices;
         vector<up::byte> _data;
+        Aabb _bounds;
     };
 } // namespace up
@@ -0,0 +1,98 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#pragma once
+
+#include "_export.h"
+#include "bounds.h"
+
+#include "potato/spud/hash_map.h"
+#include "potato/spud/int_types.h"
+#include "potato/spud/vector.h"
+
+#include <glm/vec3.hpp>
+
+namespace up {
+    /// @brief The nearest entry struck by a ray; see SpatialIndex::raycast.
+    struct RayHit {
+        uint64 key = 0;
+        /// Distance along the ray to the entry's bounds, or zero if the ray starts inside them.
+        float distance = 0;
+        bool hit = false;
+
+        explicit operator bool() const noexcept { return hit; }
+    };
+
+    /// @brief A loose octree over the bounds of keyed entries, for culling and picking.
+    ///
+    /// Each node's loose bounds are twice the size of the cube it subdivides. An entry is stored in
+    /// the deepest node that contains its center and is at least as large as it, which is found from
+    /// its own bounds alone, so moving an entry only touches the node it leaves and the node it
+    /// enters. Entries whose center lies outside of the root are kept in the root.
+    ///
+    /// The bounds of a node's entries are stored as centers and extents in blocks of four, so that
+    /// four entries are tested against a plane or a ray at once.
+    ///
+    class SpatialIndex {
+    public:
+        /// @param halfSize Half the width of the cube subdivided by the root.
+        /// @param maxDepth Number of times the root may be subdivided.
+        UP_RENDER_API explicit SpatialIndex(float halfSize = 1024.f, uint32 maxDepth = 8);
+        UP_RENDER_API ~SpatialIndex();
+
+        SpatialIndex(SpatialIndex const&) = delete;
+        SpatialIndex& operator=(SpatialIndex const&) = delete;
+
+        /// @brief Adds an entry, or moves an existing entry to new bounds.
+        UP_RENDER_API void update(uint64 key, Aabb const& bounds);
+
+        /// @brief Removes an entry.
+        /// @returns false if there was no such entry.
+        UP_RENDER_API bool remove(uint64 key) noexcept;
+
+        /// @brief Removes every entry, keeping the allocated nodes.
+        UP_RENDER_API void clear() noexcept;
+
+        bool contains(uint64 key) const noexcept { return _entries.contains(key); }
+        size_t size() const noexcept { return _entries.size(); }
+
+        /// @brief Appends the key of every entry whose bounds intersect the frustum.
+        ///
+        /// Bounds are tested conservatively, so an entry near a corner of the frustum may be reported
+        /// even though it is not visible.
+        ///
+        UP_RENDER_API void queryFrustum(Frustum const& frustum, vector<uint64>& keys) const;
+
+        /// @brief Finds the entry whose bounds are struck first by a ray.
+        UP_RENDER_API auto raycast(Ray const& ray, float maxDistance = 1e30f) const noexcept -> RayHit;
+
+    private:
+        struct Node {
+            glm::vec3 center = {0, 0, 0};
+            float halfSize = 0;
+            uint32 parent = 0;
+            /// Index of the first of eight consecutive children, or zero if not yet subdivided.
+            uint32 firstChild = 0;
+            /// Number of entries in the node and all of its descendants.
+            uint32 population = 0;
+            /// Per block of four entries, each of center x, y, z and extent x, y, z for the four.
+            vector<float> bounds;
+            vector<uint64> keys;
+        };
+
+        struct Location {
+            uint32 node = 0;
+            uint32 slot = 0;
+        };
+
+        auto _nodeFor(glm::vec3 center, glm::vec3 extent) -> uint32;
+        void _subdivide(uint32 nodeIndex);
+        void _insert(uint32 nodeIndex, uint64 key, glm::vec3 center, glm::vec3 extent);
+        void _erase(Location location) noexcept;
+        void _queryFrustum(uint32 nodeIndex, Frustum const& frustum, bool contained, vector<uint64>& keys) const;
+        void _raycast(uint32 nodeIndex, glm::vec3 origin, glm::vec3 inverseDirection, RayHit& hit) const noexcept;
+
+        vector<Node> _nodes;
+        hash_map<uint64, Location> _entries;
+        uint32 _maxDepth = 0;
+    };
+} // namespace up
@@ -0,0 +1,195 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "potato/render/bounds.h"
+#include "potato/render/spatial_index.h"
+
+#include <catch2/catch.hpp>
+
+namespace {
+    auto boxAt(glm::vec3 center, float extent = .5f) -> up::Aabb {
+        return {.min = center - glm::vec3{extent, extent, extent}, .max = center + glm::vec3{extent, extent, extent}};
+    }
+
+    // a box-shaped frustum, as an orthographic camera would have, covering min..max
+    auto frustumOf(up::Aabb const& volume) -> up::Frustum {
+        return up::Frustum{
+            .planes = {
+                {1, 0, 0, -volume.min.x},
+                {-1, 0, 0, volume.max.x},
+                {0, 1, 0, -volume.min.y},
+                {0, -1, 0, volume.max.y},
+                {0, 0, 1, -volume.min.z},
+                {0, 0, -1, volume.max.z},
+            }};
+    }
+
+    auto contains(up::vector<up::uint64> const& keys, up::uint64 key) -> bool {
+        for (up::uint64 const candidate : keys) {
+            if (candidate == key) {
+                return true;
+            }
+        }
+        return false;
+    }
+} // namespace
+
+TEST_CASE("potato.render.SpatialIndex", "[potato][render]") {
+    using namespace up;
+
+    SECTION("frustum from view projection") {
+        // an orthographic projection of -2..2 on x and y, and a depth of 1..5 looking down -z
+        glm::mat4x4 viewProjection{0};
+        viewProjection[0][0] = .5f;
+        viewProjection[1][1] = .5f;
+        viewProjection[2][2] = -.25f;
+        viewProjection[3][2] = -.25f;
+        viewProjection[3][3] = 1.f;
+
+        Frustum const frustum = Frustum::fromViewProjection(viewProjection);
+
+        CHECK(frustum.intersects(boxAt({0, 0, -3})));
+        CHECK(frustum.intersects(boxAt({2.25f, 0, -3})));
+        CHECK_FALSE(frustum.intersects(boxAt({3, 0, -3})));
+        CHECK_FALSE(frustum.intersects(boxAt({0, -3, -3})));
+        CHECK_FALSE(frustum.intersects(boxAt({0, 0, 0})));
+        CHECK_FALSE(frustum.intersects(boxAt({0, 0, -6})));
+    }
+
+    SECTION("transform bounds") {
+        glm::mat4x4 transform{1};
+        transform[3] = {10, 0, 0, 1};
+        // a quarter turn about z swaps x and y
+        transform[0] = {0, 1, 0, 0};
+        transform[1] = {-1, 0, 0, 0};
+
+        Aabb const bounds = transformBounds({.min = {0, 0, 0}, .max = {2, 1, 1}}, transform);
+
+        CHECK(bounds.min.x == Approx(9));
+        CHECK(bounds.max.x == Approx(10));
+        CHECK(bounds.min.y == Approx(0));
+        CHECK(bounds.max.y == Approx(2));
+        CHECK(bounds.min.z == Approx(0));
+        CHECK(bounds.max.z == Approx(1));
+    }
+
+    SECTION("update and remove") {
+        SpatialIndex index(64.f, 4);
+
+        for (uint64 key = 0; key != 100; ++key) {
+            index.update(key, boxAt({static_cast<float>(key) - 50.f, 0, 0}));
+        }
+        CHECK(index.size() == 100);
+
+        // moving an entry into a different node
+        index.update(7, boxAt({40, 40, 40}));
+        CHECK(index.size() == 100);
+
+        CHECK(index.remove(3));
+        CHECK_FALSE(index.remove(3));
+        CHECK_FALSE(index.contains(3));
+        CHECK(index.contains(4));
+        CHECK(index.size() == 99);
+
+        vector<uint64> keys;
+        index.queryFrustum(frustumOf({.min = {-100, -100, -100}, .max = {100, 100, 100}}), keys);
+        CHECK(keys.size() == 99);
+        CHECK_FALSE(contains(keys, 3));
+
+        index.clear();
+        CHECK(index.size() == 0);
+        keys.clear();
+        index.queryFrustum(frustumOf({.min = {-100, -100, -100}, .max = {100, 100, 100}}), keys);
+        CHECK(keys.empty());
+    }
+
+    SECTION("frustum culling") {
+        SpatialIndex index(64.f, 5);
+
+        // a grid of small boxes, plus large and distant boxes kept in shallower nodes or the root
+        uint64 key = 0;
+        for (int z = -20; z != 20; ++z) {
+            for (int x = -20; x != 20; ++x) {
+                index.update(key++, boxAt({x * 3.f, 0, z * 3.f}));
+            }
+        }
+        uint64 const large = key++;
+        index.update(large, boxAt({-30, 0, -30}, 20));
+        uint64 const distant = key++;
+        index.update(distant, boxAt({500, 0, 0}));
+
+        Aabb const volume{.min = {-10, -1, -10}, .max = {10, 1, 10}};
+        vector<uint64> keys;
+        index.queryFrustum(frustumOf(volume), keys);
+
+        // every box that overlaps the volume is reported, and nothing else
+        key = 0;
+        size_t expected = 0;
+        for (int z = -20; z != 20; ++z) {
+            for (int x = -20; x != 20; ++x, ++key) {
+                bool const overlaps = x * 3.f + .5f >= -10 && x * 3.f - .5f <= 10 && z * 3.f + .5f >= -10 &&
+                    z * 3.f - .5f <= 10;
+                CHECK(contains(keys, key) == overlaps);
+                expected += overlaps ? 1 : 0;
+            }
+        }
+        CHECK(contains(keys, large));
+        CHECK_FALSE(contains(keys, distant));
+        CHECK(keys.size() == expected + 1);
+
+        keys.clear();
+        index.queryFrustum(frustumOf({.min = {490, -10, -10}, .max = {510, 10, 10}}), keys);
+        REQUIRE(keys.size() == 1);
+        CHECK(keys.front() == distant);
+    }
+
+    SECTION("raycast") {
+        SpatialIndex index(64.f, 5);
+
+        for (uint64 key = 0; key != 10; ++key) {
+            index.update(key, boxAt({0, 0, -5.f * static_cast<float>(key + 1)}));
+        }
+        index.update(100, boxAt({3, 0, -2}));
+
+        RayHit hit = index.raycast({.origin = {0, 0, 0}, .direction = {0, 0, -1}});
+        REQUIRE(hit);
+        CHECK(hit.key == 0);
+        CHECK(hit.distance == Approx(4.5f));
+
+        index.remove(0);
+        hit = index.raycast({.origin = {0, 0, 0}, .direction = {0, 0, -1}});
+        REQUIRE(hit);
+        CHECK(hit.key == 1);
+        CHECK(hit.distance == Approx(9.5f));
+
+        CHECK_FALSE(index.raycast({.origin = {0, 0, 0}, .direction = {0, 0, -1}}, 5.f));
+        CHECK_FALSE(index.raycast({.origin = {0, 0, 0}, .direction = {0, 0, 1}}));
+
+        hit = index.raycast({.origin = {0, 0, -2}, .direction = {1, 0, 0}});
+        REQUIRE(hit);
+        CHECK(hit.key == 100);
+        CHECK(hit.distance == Approx(2.5f));
+
+        // starting inside of a box hits it immediately
+        hit = index.raycast({.origin = {0, 0, -10}, .direction = {0, 1, 0}});
+        REQUIRE(hit);
+        CHECK(hit.key == 1);
+        CHECK(hit.distance == 0);
+
+        // a ray parallel to an axis and starting on a box's face still hits it
+        hit = index.raycast({.origin = {.5f, .5f, 0}, .direction = {0, 0, -1}});
+        REQUIRE(hit);
+        CHECK(hit.key == 1);
+        CHECK(hit.distance == Approx(9.5f));
+        CHECK_FALSE(index.raycast({.origin = {.6f, 0, 0}, .direction = {0, 0, -1}}));
+
+        // entries too large for any child all share the root
+        for (uint64 key = 200; key != 1200; ++key) {
+            index.update(key, boxAt({0, 100.f + static_cast<float>(key), 0}, 80.f));
+        }
+        CHECK(index.size() == 1010);
+        hit = index.raycast({.origin = {0, 0, 0}, .direction = {0, 1, 0}});
+        REQUIRE(hit);
+        CHECK(hit.key == 200);
+        CHECK(hit.distance == Approx(220.f));
+    }
+}
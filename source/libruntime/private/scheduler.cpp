@@ -0,0 +1,103 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "scheduler.h"
+
+#include "potato/spud/rc.h"
+#include "potato/spud/string_format.h"
+
+#include <atomic>
+#include <thread>
+
+namespace up {
+    namespace {
+        // shared between all participants of a parallelFor; helpers which are scheduled
+        // late may still touch this after the caller has returned, so it must be refcounted
+        struct ParallelForState : shared<ParallelForState> {
+            ParallelForState(size_t count, delegate_ref<void(size_t)> callback) noexcept
+                : count(count)
+                , callback(std::move(callback)) {}
+
+            void run() noexcept {
+                for (size_t index = next++; index < count; index = next++) {
+                    callback(index);
+                    completed.fetch_add(1, std::memory_order_release);
+                }
+            }
+
+            size_t const count = 0;
+            delegate_ref<void(size_t)> const callback;
+            std::atomic<size_t> next = 0;
+            std::atomic<size_t> completed = 0;
+        };
+    } // namespace
+} // namespace up
+
+up::Scheduler::Scheduler(int workerCount) {
+    if (workerCount < 0) {
+        workerCount = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    }
+
+    for (int index = 0; index < workerCount; ++index) {
+        char name[32] = {
+            0,
+        };
+        format_to(name, "Scheduler Worker {}", index);
+        _workers.push_back(new_box<TaskWorker>(_queue, name));
+    }
+}
+
+up::Scheduler::~Scheduler() {
+    _queue.close();
+    for (auto& worker : _workers) {
+        worker->join();
+    }
+}
+
+void up::Scheduler::submit(Task task) {
+    if (_workers.empty()) {
+        task();
+        return;
+    }
+
+    _queue.enqueWait(std::move(task));
+}
+
+bool up::Scheduler::tryRunPending() {
+    Task task;
+    if (_queue.tryDeque(task)) {
+        task();
+        return true;
+    }
+    return false;
+}
+
+void up::Scheduler::_parallelFor(size_t count, delegate_ref<void(size_t)> callback) {
+    if (count == 0) {
+        return;
+    }
+
+    if (count == 1 || _workers.empty()) {
+        for (size_t index = 0; index != count; ++index) {
+            callback(index);
+        }
+        return;
+    }
+
+    auto state = new_shared<ParallelForState>(count, std::move(callback));
+
+    // the calling thread will participate, so we only need helpers for the remainder
+    auto const helpers = count - 1 < _workers.size() ? count - 1 : _workers.size();
+    for (size_t index = 0; index != helpers; ++index) {
+        _queue.enqueWait([state] { state->run(); });
+    }
+
+    state->run();
+
+    // while other participants are finishing, help out with any other queued work;
+    // this also keeps nested parallelFor calls from deadlocking the pool
+    while (state->completed.load(std::memory_order_acquire) != count) {
+        if (!tryRunPending()) {
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,53 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "virtual_memory.h"
+#include "assertion.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+auto up::virtualPageSize() noexcept -> size_t {
+    static size_t const pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return pageSize;
+}
+
+auto up::mapVirtualMemory(size_t size, size_t alignment, bool hugePages) noexcept -> void* {
+    size_t const pageSize = virtualPageSize();
+    UP_ASSERT(size % pageSize == 0);
+    UP_ASSERT((alignment & (alignment - 1)) == 0);
+
+    if (alignment < pageSize) {
+        alignment = pageSize;
+    }
+
+    // mmap only guarantees page alignment, so map enough that an aligned region
+    // must fit inside and then unmap the excess on either side
+    size_t const reserved = size + alignment - pageSize;
+    void* const mapped = mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+
+    auto const base = reinterpret_cast<uintptr>(mapped);
+    auto const aligned = (base + alignment - 1) & ~(alignment - 1);
+    if (aligned != base) {
+        munmap(mapped, aligned - base);
+    }
+    if (auto const tail = base + reserved - (aligned + size); tail != 0) {
+        munmap(reinterpret_cast<void*>(aligned + size), tail);
+    }
+
+#if defined(MADV_HUGEPAGE)
+    if (hugePages) {
+        madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+    }
+#endif
+
+    return reinterpret_cast<void*>(aligned);
+}
+
+void up::unmapVirtualMemory(void* memory, size_t size) noexcept {
+    if (memory != nullptr) {
+        munmap(memory, size);
+    }
+}
@@ -0,0 +1,54 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "virtual_memory.h"
+#include "assertion.h"
+
+#include "potato/spud/platform_windows.h"
+
+#if !defined(UP_PLATFORM_WINDOWS)
+#    error "Unsupported platform"
+#endif
+
+auto up::virtualPageSize() noexcept -> size_t {
+    static size_t const pageSize = [] {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return static_cast<size_t>(info.dwPageSize);
+    }();
+    return pageSize;
+}
+
+// Large pages on Windows require the SeLockMemoryPrivilege and cannot be paged out,
+// so the huge page hint is ignored rather than silently demanding elevated rights.
+auto up::mapVirtualMemory(size_t size, size_t alignment, bool) noexcept -> void* {
+    UP_ASSERT(size % virtualPageSize() == 0);
+    UP_ASSERT((alignment & (alignment - 1)) == 0);
+
+    // VirtualAlloc only guarantees allocation granularity alignment and cannot partially
+    // release a reservation, so find a suitable address by reserving an oversized region,
+    // releasing it, and then mapping the aligned subrange; another thread may race us
+    // for the address, in which case we simply try again
+    for (int attempt = 0; attempt != 8; ++attempt) {
+        void* const reserved = VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+        if (reserved == nullptr) {
+            return nullptr;
+        }
+
+        auto const aligned = (reinterpret_cast<uintptr>(reserved) + alignment - 1) & ~(alignment - 1);
+        VirtualFree(reserved, 0, MEM_RELEASE);
+
+        if (void* const mapped =
+                VirtualAlloc(reinterpret_cast<void*>(aligned), size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+            mapped != nullptr) {
+            return mapped;
+        }
+    }
+
+    return nullptr;
+}
+
+void up::unmapVirtualMemory(void* memory, size_t) noexcept {
+    if (memory != nullptr) {
+        VirtualFree(memory, 0, MEM_RELEASE);
+    }
+}
@@ -0,0 +1,56 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#pragma once
+
+#include "_export.h"
+#include "task_worker.h"
+
+#include "potato/spud/box.h"
+#include "potato/spud/concepts.h"
+#include "potato/spud/delegate_ref.h"
+#include "potato/spud/int_types.h"
+#include "potato/spud/vector.h"
+
+namespace up {
+    /// A pool of worker threads used to execute data-parallel work.
+    ///
+    /// The thread calling into the Scheduler always participates in the work, so a
+    /// Scheduler with zero workers simply executes everything serially on the caller.
+    ///
+    class Scheduler {
+    public:
+        /// @brief Creates a scheduler with the requested number of worker threads.
+        /// @param workerCount Number of background workers; negative selects one less than the hardware concurrency.
+        UP_RUNTIME_API explicit Scheduler(int workerCount = -1);
+        UP_RUNTIME_API ~Scheduler();
+
+        Scheduler(Scheduler const&) = delete;
+        Scheduler& operator=(Scheduler const&) = delete;
+
+        /// @brief Number of threads that may execute work, including the calling thread.
+        int concurrency() const noexcept { return static_cast<int>(_workers.size()) + 1; }
+
+        /// @brief Invokes a callback once for every index in [0, count), spread across all workers.
+        ///
+        /// Returns only once every invocation has completed. Safe to call from within a
+        /// callback that is itself executing on a worker.
+        ///
+        template <callable<size_t> Callback>
+        void parallelFor(size_t count, Callback&& callback) {
+            _parallelFor(count, delegate_ref<void(size_t)>(callback));
+        }
+
+        /// @brief Submits a task to be executed asynchronously by a worker.
+        UP_RUNTIME_API void submit(Task task);
+
+        /// @brief Executes a single pending task on the calling thread, if any are queued.
+        /// @return true if a task was executed.
+        UP_RUNTIME_API bool tryRunPending();
+
+    private:
+        UP_RUNTIME_API void _parallelFor(size_t count, delegate_ref<void(size_t)> callback);
+
+        TaskQueue _queue;
+        vector<box<TaskWorker>> _workers;
+    };
+} // namespace up
@@ -0,0 +1,25 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#pragma once
+
+#include "_export.h"
+
+#include "potato/spud/int_types.h"
+
+namespace up {
+    /// @brief Size of a page of virtual memory, in bytes.
+    UP_RUNTIME_API auto virtualPageSize() noexcept -> size_t;
+
+    /// @brief Maps a region of zero-filled, read-write memory directly from the OS.
+    ///
+    /// Pages are committed lazily by the OS on first touch where supported.
+    ///
+    /// @param size Size of the region in bytes; must be a multiple of the page size.
+    /// @param alignment Required alignment of the region; must be a power of two.
+    /// @param hugePages Hint that the region should be backed by transparent huge pages, if supported.
+    /// @return The mapped region, or nullptr if it could not be mapped.
+    UP_RUNTIME_API auto mapVirtualMemory(size_t size, size_t alignment, bool hugePages = false) noexcept -> void*;
+
+    /// @brief Returns a region mapped by mapVirtualMemory to the OS.
+    UP_RUNTIME_API void unmapVirtualMemory(void* memory, size_t size) noexcept;
+} // namespace up
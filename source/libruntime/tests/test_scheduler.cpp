@@ -0,0 +1,43 @@
+// Copyright by Potato Engine contributors. See accompanying License.txt for copyright details.
+
+#include "potato/runtime/scheduler.h"
+
+#include <atomic>
+#include <catch2/catch.hpp>
+
+TEST_CASE("potato.runtime.Scheduler", "[potato][runtime]") {
+    using namespace up;
+
+    SECTION("parallelFor") {
+        Scheduler scheduler(3);
+
+        CHECK(scheduler.concurrency() == 4);
+
+        int values[1024] = {};
+        scheduler.parallelFor(1024, [&values](size_t index) { values[index] = static_cast<int>(index); });
+
+        for (int i = 0; i != 1024; ++i) {
+            CHECK(values[i] == i);
+        }
+    }
+
+    SECTION("serial") {
+        Scheduler scheduler(0);
+
+        int sum = 0;
+        scheduler.parallelFor(100, [&sum](size_t index) { sum += static_cast<int>(index); });
+
+        CHECK(sum == 4950);
+    }
+
+    SECTION("nested") {
+        Scheduler scheduler(2);
+
+        std::atomic<int> total = 0;
+        scheduler.parallelFor(8, [&](size_t) {
+            scheduler.parallelFor(16, [&](size_t) { ++total; });
+        });
+
+        CHECK(total == 8 * 16);
+    }
+}
@@ -31,6 +31,7 @@ namespace up {
 
         inline bool operator==(bit_set const& rhs) const noexcept;
         inline bool has_all(bit_set const& rhs) const noexcept;
+        inline bool has_any(bit_set const& rhs) const noexcept;
 
         inline bit_set clone() const;
         inline bit_set& resize(size_type capacity);
@@ -54,6 +55,7 @@ namespace up {
 
     bit_set& bit_set::operator=(bit_set&& rhs) noexcept {
         UP_SPUD_ASSERT(this != &rhs, "cannot move a bit_set over itself");
+        delete[] _elems;
         _elems = rhs._elems;
         _elemSize = rhs._elemSize;
         rhs._elems = nullptr;
@@ -137,6 +139,17 @@ namespace up {
         return true;
     }
 
+    bool bit_set::has_any(bit_set const& rhs) const noexcept {
+        size_type common = _elemSize > rhs._elemSize ? rhs._elemSize : _elemSize;
+        for (size_type index = 0; index < common; ++index) {
+            if ((_elems[index] & rhs._elems[index]) != element(0)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     bit_set bit_set::clone() const {
         bit_set rs;
         rs._elemSize = _elemSize;
@@ -107,7 +107,7 @@ namespace up {
 
         protected:
             explicit delegate_base(delegate_vtable_base const* vtable) noexcept : _vtable(vtable) {}
-            ~delegate_base() = default;
+            ~delegate_base() { reset(); }
 
             // we will overwrite this with an object with just a vtable - if we are nullptr, we have no real vtable
             // NOLINTNEXTLINE(cppcoreguidelines-non-private-member-variables-in-classes)
@@ -36,7 +36,9 @@ namespace up {
             using value_type = key_value<Key const&, Value&>;
 
             constexpr kv_proxy() noexcept = default;
-            constexpr explicit kv_proxy(key_value<Key, Value>* items, size_t index) noexcept
+            template <typename ItemValue>
+            constexpr explicit kv_proxy(key_value<Key, ItemValue>* items, size_t index) noexcept
+                requires std::is_convertible_v<ItemValue&, Value&>
                 : _engaged(index != hash_table::constants::SENTINEL) {
                 if (_engaged) {
                     new (&_data.proxy) value_type{items[index].key, items[index].value};
@@ -153,6 +155,12 @@ namespace up {
             return proxy_type{_items, index};
         }
 
+        template <convertible_to<Key> FindKey = Key>
+        [[nodiscard]] constexpr const_proxy_type find(FindKey const& key) const noexcept {
+            auto const index = _find(key, Hash{}(key));
+            return const_proxy_type{_items, index};
+        }
+
         template <convertible_to<Key> InsertKey = Key, convertible_to<Value> InsertValue = Value>
         constexpr bool insert(InsertKey&& key, InsertValue&& value);
 
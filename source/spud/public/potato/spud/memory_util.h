@@ -124,11 +124,11 @@ void up::move_backwards_n(InputIt first, SizeT count, TypeT* out_last) {
     using type = std::remove_reference_t<decltype(*first)>;
     if constexpr (std::is_trivially_assignable_v<TypeT, type&&> && std::is_pointer_v<InputIt>) {
         // NOLINTNEXTLINE(bugprone-sizeof-expression)
-        std::memmove(out_last - count, first - count, count * sizeof(type));
+        std::memmove(out_last - count, first, count * sizeof(type));
     }
     else {
         for (auto in = first + count; in != first;) {
-            *out_last-- = std::move(*--in);
+            *--out_last = std::move(*--in);
         }
     }
 }
@@ -263,7 +263,7 @@ namespace up {
 
         // shift elements inside the already-initialized parts of the vector
         auto const head = size - tail;
-        move_backwards_n(pos, head, pos + head);
+        move_backwards_n(pos, head, pos + shift + head);
     }
 
     template <typename T>
@@ -285,7 +285,9 @@ namespace up {
     void vector<T>::resize(size_type new_size) {
         size_type const size = _last - _first;
         if (size < new_size) {
-            reserve(new_size);
+            if (new_size > capacity()) {
+                reserve(_grow(new_size));
+            }
             default_construct_n(_last, new_size - size);
         }
         else if (size > new_size) {
@@ -298,7 +300,9 @@ namespace up {
     void vector<T>::resize(size_type new_size, const_reference init) {
         size_type const size = _last - _first;
         if (size < new_size) {
-            reserve(new_size);
+            if (new_size > capacity()) {
+                reserve(_grow(new_size));
+            }
             uninitialized_value_construct_n(_last, new_size - size, init);
         }
         else if (size > new_size) {
@@ -371,7 +375,7 @@ namespace up {
         _last = _first + size + 1;
         _sentinel = _first + newCapacity;
 
-        return _first[size];
+        return _first[index];
     }
 
     template <typename T>
@@ -452,12 +456,16 @@ namespace up {
             iterator mpos = _to_iterator(pos);
             if (mpos == _last) {
                 unitialized_copy_n(begin, count, mpos);
+                _last += count;
             }
             else {
+                // only the slots vacated by existing elements are still constructed;
+                // _rshift extends the vector itself
+                auto const constructed = min(count, _last - mpos);
                 _rshift(mpos, count);
-                copy_n(begin, count, mpos);
+                copy_n(begin, constructed, mpos);
+                unitialized_copy_n(begin + constructed, count - constructed, mpos + constructed);
             }
-            _last += count;
             return mpos;
         }
 
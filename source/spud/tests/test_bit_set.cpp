@@ -88,4 +88,43 @@ TEST_CASE("potato.spud.bit_set", "[potato][spud]") {
 
         CHECK_FALSE(bs1.has_all(bs2));
     }
+
+    SECTION("has_any") {
+        bit_set bs1;
+        bit_set bs2;
+
+        bs1.set(7);
+        bs1.set(555);
+
+        CHECK_FALSE(bs1.has_any(bs2));
+
+        bs2.set(0);
+        bs2.set(109);
+
+        CHECK_FALSE(bs1.has_any(bs2));
+
+        bs2.set(555);
+
+        CHECK(bs1.has_any(bs2));
+        CHECK(bs2.has_any(bs1));
+
+        bs2.reset(555);
+        bs2.set(909);
+
+        CHECK_FALSE(bs1.has_any(bs2));
+    }
+
+    SECTION("move") {
+        bit_set bs1;
+        bit_set bs2;
+
+        bs1.set(7);
+        bs2.set(109);
+
+        bs2 = std::move(bs1);
+
+        CHECK(bs2.test(7));
+        CHECK_FALSE(bs2.test(109));
+        CHECK(bs1.capacity() == 0);
+    }
 }
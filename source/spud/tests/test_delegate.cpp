@@ -9,6 +9,14 @@ namespace {
         int next() { return ++r; }
         int add(int i) const { return r + i; }
     };
+
+    struct Tracked {
+        explicit Tracked(int& alive) : alive(&alive) { ++alive; }
+        Tracked(Tracked const& rhs) : alive(rhs.alive) { ++*alive; }
+        ~Tracked() { --*alive; }
+
+        int* alive = nullptr;
+    };
 } // namespace
 
 TEST_CASE("potato.spud.delegate", "[potato][spud]") {
@@ -74,4 +82,15 @@ TEST_CASE("potato.spud.delegate", "[potato][spud]") {
         d();
         CHECK(i2 == 2);
     }
+
+    SECTION("delegate destroys captures") {
+        int alive = 0;
+        {
+            delegate<int()> d = [tracked = Tracked{alive}] {
+                return *tracked.alive;
+            };
+            CHECK(alive == 1);
+        }
+        CHECK(alive == 0);
+    }
 }
@@ -71,6 +71,10 @@ TEST_CASE("potato.spud.hash_map", "[potato][spud]") {
         CHECK(values.find("test")->value == 8);
         CHECK(values.find("bob")->value == 1);
 
+        auto const& constValues = values;
+        CHECK(constValues.find("test")->value == 8);
+        CHECK_FALSE(constValues.find("missing"));
+
         CHECK(2 == values.size());
 
         // we expect only a single group
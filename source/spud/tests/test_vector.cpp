@@ -51,7 +51,7 @@ TEST_CASE("potato.spud.vector", "[potato][spud]") {
         vector<int> vec;
 
         for (int i = 1; i <= 10'000; ++i) {
-            vec.insert(vec.begin(), i);
+            CHECK(vec.insert(vec.begin(), i) == i);
         }
 
         CHECK(vec.size() == 10'000);
@@ -59,6 +59,37 @@ TEST_CASE("potato.spud.vector", "[potato][spud]") {
 
         CHECK(vec.back() == 1);
         CHECK(vec.front() == 10'000);
+
+        vector<int> ints{1, 4, 5};
+        ints.reserve(8);
+        ints.insert(ints.begin() + 1, 3);
+        ints.insert(ints.begin() + 1, 2);
+        REQUIRE(ints.size() == 5);
+        for (int i = 0; i != 5; ++i) {
+            CHECK(ints[i] == i + 1);
+        }
+
+        vector<string> strings{"a", "d"};
+        strings.reserve(16);
+        strings.insert(strings.begin() + 1, "c");
+        strings.insert(strings.begin() + 1, "b");
+        string const more[] = {"e", "f"};
+        strings.insert(strings.begin(), more, more + 2);
+
+        REQUIRE(strings.size() == 6);
+        CHECK(strings[0] == "e");
+        CHECK(strings[1] == "f");
+        CHECK(strings[2] == "a");
+        CHECK(strings[3] == "b");
+        CHECK(strings[4] == "c");
+        CHECK(strings[5] == "d");
+
+        string const many[] = {"x", "y", "z"};
+        strings.insert(strings.end() - 1, many, many + 3);
+        REQUIRE(strings.size() == 9);
+        CHECK(strings[5] == "x");
+        CHECK(strings[7] == "z");
+        CHECK(strings[8] == "d");
     }
 
     SECTION("vector resize") {
@@ -73,6 +104,22 @@ TEST_CASE("potato.spud.vector", "[potato][spud]") {
         CHECK(vec.size() == 6);
         CHECK(vec.front() == 1);
         CHECK(vec.back() == 7);
+
+        // growing one element at a time reallocates geometrically, not on every call
+        vector<int> grown;
+        int reallocations = 0;
+        for (int i = 1; i <= 10'000; ++i) {
+            auto const capacity = grown.capacity();
+            grown.resize(grown.size() + 1, i);
+            reallocations += grown.capacity() != capacity ? 1 : 0;
+        }
+        CHECK(grown.size() == 10'000);
+        CHECK(grown.back() == 10'000);
+        CHECK(reallocations < 30);
+
+        // a fresh vector is still sized exactly
+        vector<int> exact(100);
+        CHECK(exact.capacity() == 100);
     }
 
     SECTION("vector erase") {